@@ -0,0 +1,90 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// ============================================================
+// SDF Playground — Clustered Light Culling
+// One workgroup per cluster. A cluster is the cone enclosing a
+// screen tile's rays, cut to a slice of hit distance; each light's
+// sphere of influence is tested against it and survivors appended.
+// ============================================================
+
+layout(local_size_x = 64) in;
+
+#include "common/SDFScene.glsl"
+
+shared uint clusterCount;
+shared uint chunkMask[2]; // Visible lights of the current chunk, one bit per invocation
+
+void main() {
+    ivec2 size = ivec2(params.x, params.y);
+    uvec3 cluster = gl_WorkGroupID;
+    uint clusterId = (cluster.z * CLUSTER_Y + cluster.y) * CLUSTER_X + cluster.x;
+    uint lid = gl_LocalInvocationIndex;
+
+    // Same pixel partition as clusterIndex(): tile x covers [x * size / CLUSTER_X, (x + 1) * size / CLUSTER_X)
+    vec2 tileMin = vec2(cluster.xy * uvec2(size)) / vec2(CLUSTER_X, CLUSTER_Y);
+    vec2 tileMax = vec2((cluster.xy + 1u) * uvec2(size)) / vec2(CLUSTER_X, CLUSTER_Y);
+    vec3 axis = cameraRayAt(0.5 * (tileMin + tileMax), size);
+    float cosCone = 1.0;
+    for (int i = 0; i < 4; i++) {
+        vec2 corner = vec2((i & 1) != 0 ? tileMax.x : tileMin.x, (i & 2) != 0 ? tileMax.y : tileMin.y);
+        cosCone = min(cosCone, dot(axis, cameraRayAt(corner, size)));
+    }
+    float coneAngle = acos(clamp(cosCone, -1.0, 1.0));
+
+    float tNear = clusterSliceStart(cluster.z);
+    float tFar = cluster.z + 1u < CLUSTER_Z ? clusterSliceStart(cluster.z + 1u) : 1e30;
+
+    if (lid == 0u) clusterCount = 0u;
+
+    // Lights are taken in index order, 64 at a time, and each survivor's slot is its rank
+    // within the chunk. A full list therefore always keeps the lowest indices; allocating
+    // slots with atomics made the survivors change from frame to frame.
+    for (uint first = 0u; first < lightCount; first += 64u) {
+        // Invocation 0 resets the mask it summed at the end of the previous chunk, so the
+        // reset cannot overtake that read
+        if (lid == 0u) {
+            chunkMask[0] = 0u;
+            chunkMask[1] = 0u;
+        }
+        barrier();
+
+        uint i = first + lid;
+        bool visible = false;
+        if (i < lightCount) {
+            PointLightGPU light = lights[i];
+            vec3 v = light.position - camPos.xyz;
+            float dist = length(v);
+
+            // Points of the light's sphere lie between dist - radius and dist + radius from the camera
+            visible = dist + light.radius >= tNear && dist - light.radius <= tFar;
+            if (visible && dist > light.radius) {
+                float angle = acos(clamp(dot(v / dist, axis), -1.0, 1.0));
+                visible = angle <= coneAngle + asin(light.radius / dist) + 1e-3;
+            }
+        }
+        if (visible) {
+            atomicOr(chunkMask[lid >> 5u], 1u << (lid & 31u));
+        }
+        barrier();
+
+        uint below = lid < 32u ? bitCount(chunkMask[0] & ((1u << lid) - 1u))
+                               : bitCount(chunkMask[0]) + bitCount(chunkMask[1] & ((1u << (lid - 32u)) - 1u));
+        uint slot = clusterCount + below;
+        if (visible && slot < MAX_CLUSTER_LIGHTS) {
+            clusterLights[clusterId * CLUSTER_STRIDE + 1u + slot] = i;
+        }
+        barrier();
+
+        // Visible lights keep being counted past the capacity, for the overflow view
+        if (lid == 0u) clusterCount += bitCount(chunkMask[0]) + bitCount(chunkMask[1]);
+    }
+    barrier();
+
+    // Header: list length in the low 16 bits, lights dropped for lack of room in the high 16
+    if (lid == 0u) {
+        uint stored = min(clusterCount, MAX_CLUSTER_LIGHTS);
+        clusterLights[clusterId * CLUSTER_STRIDE] = stored | (min(clusterCount - stored, 0xFFFFu) << 16u);
+    }
+}
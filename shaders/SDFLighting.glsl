@@ -0,0 +1,221 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// ============================================================
+// SDF Playground — Lighting Pass
+// Resolves the G-Buffer: sun/fill, probe GI and clustered point light
+// shading, fog, sky, debug views and tonemap.
+// ============================================================
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#include "common/SDFScene.glsl"
+
+#ifdef SDF_DIRECT_PRESENT
+// Acquired swapchain image. Its BGRA8 format has no GLSL qualifier, so writes are
+// format-less (shaderStorageImageWriteWithoutFormat); components still land by name.
+layout(set = 0, binding = BINDLESS_STORAGE_IMAGES) writeonly uniform image2D gPresentImages[];
+#define presentImage gPresentImages[RESOURCE(RES_PRESENT_TARGET)]
+#endif
+
+vec3 shade(vec3 n, vec3 viewDir, vec3 albedo, float roughness, float metallic, float shadow1, vec3 ambient) {
+    // Two lights
+    vec3 lightDir1 = normalize(SUN_DIR);
+    vec3 lightDir2 = normalize(vec3(-0.4, 0.5, 0.7));
+    vec3 lightCol1 = SUN_COLOR;
+    vec3 lightCol2 = vec3(0.3, 0.4, 0.6);
+
+    float diff1 = max(dot(n, lightDir1), 0.0);
+    float diff2 = max(dot(n, lightDir2), 0.0);
+
+    vec3 h1 = normalize(lightDir1 + viewDir);
+    float spec1 = pow(max(dot(n, h1), 0.0), mix(8.0, 128.0, 1.0 - roughness));
+    float specIntensity = mix(0.04, 1.0, metallic);
+
+    vec3 color = ambient * albedo;
+    color += albedo * lightCol1 * diff1 * shadow1;
+    color += albedo * lightCol2 * diff2 * 0.3;
+    color += vec3(specIntensity) * lightCol1 * spec1 * shadow1;
+
+    return color;
+}
+
+// Windowed inverse-square falloff that reaches zero at the light's radius
+float lightFalloff(float dist, float radius) {
+    float x = dist / radius;
+    float window = clamp(1.0 - x * x * x * x, 0.0, 1.0);
+    return window * window / (dist * dist + 1.0);
+}
+
+// Point lights of the pixel's cluster. Only the POINT_SHADOWS strongest
+// contributions trace soft shadows; the rest are unshadowed.
+vec3 shadePointLights(vec3 p, vec3 n, vec3 viewDir, vec3 albedo, float roughness, float metallic, uint cluster) {
+    uint base = cluster * CLUSTER_STRIDE;
+    uint count = lightCount > 0u ? clusterLights[base] & 0xFFFFu : 0u;
+    float specPower = mix(8.0, 128.0, 1.0 - roughness);
+    float specIntensity = mix(0.04, 1.0, metallic);
+
+    vec3 color = vec3(0.0);
+    // Sized for MAX_POINT_SHADOWS in SDFRenderer.hpp, which bounds every quality preset
+    int strongest[4] = int[4](-1, -1, -1, -1);
+    float strongestLum[4] = float[4](0.0, 0.0, 0.0, 0.0);
+    vec3 strongestColor[4];
+
+    for (uint i = 0u; i < count; i++) {
+        uint index = clusterLights[base + 1u + i];
+        PointLightGPU light = lights[index];
+        vec3 toLight = light.position - p;
+        float dist = length(toLight);
+        if (dist >= light.radius) continue;
+
+        vec3 l = toLight / max(dist, 1e-4);
+        float diff = max(dot(n, l), 0.0);
+        if (diff <= 0.0) continue;
+
+        float spec = pow(max(dot(n, normalize(l + viewDir)), 0.0), specPower);
+        vec3 c = (albedo * diff + vec3(specIntensity) * spec) * light.color * light.intensity * lightFalloff(dist, light.radius);
+        color += c;
+
+        // Keep the strongest contributions, sorted by luminance
+        float lum = dot(c, vec3(0.2126, 0.7152, 0.0722));
+        for (int k = 0; k < POINT_SHADOWS; k++) {
+            if (lum <= strongestLum[k]) continue;
+            for (int j = POINT_SHADOWS - 1; j > k; j--) {
+                strongest[j] = strongest[j - 1];
+                strongestLum[j] = strongestLum[j - 1];
+                strongestColor[j] = strongestColor[j - 1];
+            }
+            strongest[k] = int(index);
+            strongestLum[k] = lum;
+            strongestColor[k] = c;
+            break;
+        }
+    }
+
+    for (int k = 0; k < POINT_SHADOWS; k++) {
+        if (strongest[k] < 0) break;
+        vec3 toLight = lights[strongest[k]].position - p;
+        float dist = length(toLight);
+        float shadow = softShadow(p + n * 0.02, toLight / dist, 0.02, dist, 8.0);
+        color -= strongestColor[k] * (1.0 - shadow);
+    }
+
+    return color;
+}
+
+// Depth/normal-aware upsample of the reduced-resolution shadow/AO history
+vec2 upsampleShadowAO(ivec2 pixel, ivec2 size, float t, vec3 n) {
+    ivec2 lowSize = shadowSize(size);
+    vec2 f = (vec2(pixel) + 0.5) / float(shadowScale()) - 0.5;
+    ivec2 base = ivec2(floor(f));
+    vec2 frac = f - vec2(base);
+
+    vec2 sum = vec2(0.0);
+    float weightSum = 0.0;
+    vec2 fallback = vec2(1.0);
+    float fallbackWeight = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 tap = clamp(base + offset, ivec2(0), lowSize - 1);
+
+        vec4 h = imageLoad(shadowHistory(frameIndex & 1u), tap);
+        if (h.z < 0.0) continue;
+
+        vec2 bw = mix(1.0 - frac, frac, vec2(offset));
+        float w = bw.x * bw.y;
+        if (w > fallbackWeight) {
+            fallback = h.xy;
+            fallbackWeight = w;
+        }
+
+        float depthW = max(1.0 - abs(h.z - t) / (0.1 * t + 0.01), 0.0);
+        vec3 tapNormal = imageLoad(gbufferNormal, shadowSourcePixel(tap, size)).xyz;
+        float normalW = pow(max(dot(n, tapNormal), 0.0), 8.0);
+
+        w *= depthW * normalW;
+        sum += h.xy * w;
+        weightSum += w;
+    }
+
+    return weightSum > 1e-4 ? sum / weightSum : fallback;
+}
+
+// ACES tone mapping
+vec3 ACESFilm(vec3 x) {
+    float a = 2.51;
+    float b = 0.03;
+    float c = 2.43;
+    float d = 0.59;
+    float e = 0.14;
+    return clamp((x * (a * x + b)) / (x * (c * x + d) + e), 0.0, 1.0);
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = ivec2(params.x, params.y);
+
+    if (pixel.x >= size.x || pixel.y >= size.y) return;
+
+    vec3 rd = cameraRay(pixel, size);
+    float t = imageLoad(gbufferDepth, pixel).r;
+    uint info = imageLoad(gbufferInfo, pixel).r;
+    int steps = int(info >> 16);
+
+    vec3 color = vec3(0);
+    if (renderMode == 2) { // Complexity
+        float c = float(steps) / float(MAX_MARCH_STEPS);
+        color = vec3(c * c, c, 0.5 * c); // Heatmap
+    } else if (renderMode == 3) { // Light Clusters
+        uint header = lightCount > 0u ? clusterLights[clusterIndex(pixel, size, t < 0.0 ? MAX_MARCH_DIST : t) * CLUSTER_STRIDE] : 0u;
+        float c = float(header & 0xFFFFu) / 16.0;
+        color = vec3(c, c * c, 0.2 * c); // Heatmap
+        // Overflowing clusters turn magenta, brighter the more lights they dropped
+        uint dropped = header >> 16u;
+        if (dropped > 0u) {
+            color = vec3(1.0, 0.0, 1.0) * (0.5 + 0.5 * min(float(dropped) / float(MAX_CLUSTER_LIGHTS), 1.0));
+        }
+    } else if (t >= 0.0) {
+        vec4 normalMetal = imageLoad(gbufferNormal, pixel);
+        vec3 n = normalMetal.xyz;
+
+        if (renderMode == 1) { // Normals
+            color = n * 0.5 + 0.5;
+        } else { // Lit
+            vec4 albedoRough = imageLoad(gbufferAlbedo, pixel);
+            vec2 sa = upsampleShadowAO(pixel, size, t, n);
+            vec3 p = camPos.xyz + rd * t;
+
+            // Probe irradiance where the grid covers the surface, constant ambient elsewhere
+            vec3 ambient = vec3(0.08, 0.09, 0.12);
+            vec3 irradiance;
+            if (PROBE_GI && sampleProbeIrradiance(p, n, irradiance)) {
+                ambient = irradiance * giIntensity / 3.14159265;
+            }
+
+            color = shade(n, -rd, albedoRough.rgb, albedoRough.a, normalMetal.w, sa.x, ambient * sa.y);
+            color += shadePointLights(p, n, -rd, albedoRough.rgb, albedoRough.a, normalMetal.w, clusterIndex(pixel, size, t));
+
+            // Distance fog
+            float fog = 1.0 - exp(-0.003 * t * t);
+            vec3 fogColor = vec3(0.45, 0.50, 0.60);
+            color = mix(color, fogColor, fog);
+        }
+    } else {
+        color = skyColor(rd);
+    }
+
+    // Tone map + gamma
+    if (renderMode == 0) {
+        color = ACESFilm(color);
+        color = pow(color, vec3(1.0 / 2.2));
+    } else if (renderMode == 1) {
+        color = pow(color, vec3(1.0 / 2.2));
+    }
+
+#ifdef SDF_DIRECT_PRESENT
+    imageStore(presentImage, pixel, vec4(color, 1.0));
+#else
+    imageStore(outImage, pixel, vec4(color, 1.0));
+#endif
+}
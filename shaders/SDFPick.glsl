@@ -0,0 +1,33 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// ============================================================
+// SDF Playground — Pick Pass
+// Traces only the requested pick rays (one invocation each) into
+// this frame's slot of the readback ring.
+// ============================================================
+
+layout(local_size_x = 64) in;
+
+#include "common/SDFScene.glsl"
+
+void main() {
+    uint idx = gl_GlobalInvocationID.x;
+    if (idx >= pickCount) return;
+
+    ivec2 size = ivec2(params.x, params.y);
+    uint entry = pickBase + idx;
+    ivec2 pixel = clamp(ivec2(picks[entry].position.xy), ivec2(0), size - 1);
+
+    vec3 ro = camPos.xyz;
+    vec3 rd = cameraRay(pixel, size);
+
+    float t;
+    HitResult hit;
+    int steps = 0;
+    bool hitSurface = tracePrimaryRay(ro, rd, t, hit, steps);
+
+    picks[entry].position = ro + rd * t;
+    picks[entry].hitIndex = hitSurface ? hit.index : -1;
+}
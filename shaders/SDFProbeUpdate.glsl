@@ -0,0 +1,142 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// ============================================================
+// SDF Playground — Irradiance Probe Update
+// One workgroup per probe, one ray per invocation. Only the probes
+// in this frame's round-robin window are dispatched, so the cost is
+// a fixed ray budget. Ray directions are a spherical Fibonacci set
+// under a per-frame random rotation; results are projected to L1 SH
+// and blended into the probe with hysteresis.
+// ============================================================
+
+layout(local_size_x = 64) in;
+
+#include "common/SDFScene.glsl"
+
+const uint RAYS_PER_PROBE = 64u;
+const float HYSTERESIS = 0.9;  // Weight of the stored probe
+const float INSIDE_HIT_DIST = 0.05; // Rays hitting this close start inside geometry
+
+shared vec4 shR[RAYS_PER_PROBE];
+shared vec4 shG[RAYS_PER_PROBE];
+shared vec4 shB[RAYS_PER_PROBE];
+shared float escaped[RAYS_PER_PROBE];
+
+uint hash(uint x) {
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float hashFloat(uint x) {
+    return float(hash(x) >> 8) / 16777216.0;
+}
+
+// Uniformly distributed rotation (Shoemake's random unit quaternion)
+mat3 randomRotation(uint seed) {
+    float u1 = hashFloat(seed);
+    float u2 = hashFloat(seed + 1u) * 6.28318531;
+    float u3 = hashFloat(seed + 2u) * 6.28318531;
+    float a = sqrt(1.0 - u1);
+    float b = sqrt(u1);
+    vec4 q = vec4(a * sin(u2), a * cos(u2), b * sin(u3), b * cos(u3));
+
+    float x = q.x, y = q.y, z = q.z, w = q.w;
+    return mat3(
+        1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y + w * z),       2.0 * (x * z - w * y),
+        2.0 * (x * y - w * z),       1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z + w * x),
+        2.0 * (x * z + w * y),       2.0 * (y * z - w * x),       1.0 - 2.0 * (x * x + y * y)
+    );
+}
+
+vec3 sphericalFibonacci(uint i, uint n) {
+    float phi = 6.28318531 * fract(float(i) * 0.61803399);
+    float cosTheta = 1.0 - (2.0 * float(i) + 1.0) / float(n);
+    float sinTheta = sqrt(clamp(1.0 - cosTheta * cosTheta, 0.0, 1.0));
+    return vec3(cos(phi) * sinTheta, cosTheta, sin(phi) * sinTheta);
+}
+
+// Radiance arriving back along rd: sun + one bounce of the previous probe state at hits, sky on misses
+vec3 traceRadiance(vec3 ro, vec3 rd, out bool inside) {
+    inside = false;
+
+    float t;
+    HitResult hit;
+    int steps = 0;
+    if (!tracePrimaryRay(ro, rd, t, hit, steps)) {
+        return skyColor(rd);
+    }
+    if (t < INSIDE_HIT_DIST) {
+        inside = true;
+        return vec3(0.0);
+    }
+
+    vec3 p = ro + rd * t;
+    vec3 n = calcNormal(p);
+
+    vec3 sunDir = normalize(SUN_DIR);
+    float diff = max(dot(n, sunDir), 0.0);
+    float shadow = diff > 0.0 ? softShadow(p + n * 0.02, sunDir, 0.02, 20.0, 8.0) : 0.0;
+    vec3 irradiance = SUN_COLOR * diff * shadow;
+
+    vec3 bounce;
+    if (sampleProbeIrradiance(p, n, bounce)) {
+        irradiance += bounce / 3.14159265;
+    }
+    return hit.albedo * irradiance;
+}
+
+void main() {
+    uint probe = (probeOffset + gl_WorkGroupID.x) % uint(PROBE_COUNT);
+    uint lid = gl_LocalInvocationIndex;
+
+    ivec3 cell = ivec3(probe % uint(PROBE_GRID.x),
+                       (probe / uint(PROBE_GRID.x)) % uint(PROBE_GRID.y),
+                       probe / uint(PROBE_GRID.x * PROBE_GRID.y));
+    vec3 ro = PROBE_ORIGIN + vec3(cell) * PROBE_SPACING;
+
+    mat3 rotation = randomRotation(hash(frameIndex) ^ (probe * 3u));
+    vec3 rd = rotation * sphericalFibonacci(lid, RAYS_PER_PROBE);
+
+    bool inside;
+    vec3 radiance = traceRadiance(ro, rd, inside);
+
+    // Monte Carlo projection onto L1 SH: 4pi / N * L * Y(rd)
+    vec4 basis = vec4(0.282095, 0.488603 * rd) * (12.5663706 / float(RAYS_PER_PROBE));
+    shR[lid] = basis * radiance.r;
+    shG[lid] = basis * radiance.g;
+    shB[lid] = basis * radiance.b;
+    escaped[lid] = inside ? 0.0 : 1.0;
+    barrier();
+
+    for (uint stride = RAYS_PER_PROBE / 2u; stride > 0u; stride >>= 1) {
+        if (lid < stride) {
+            shR[lid] += shR[lid + stride];
+            shG[lid] += shG[lid + stride];
+            shB[lid] += shB[lid + stride];
+            escaped[lid] += escaped[lid + stride];
+        }
+        barrier();
+    }
+
+    if (lid == 0u) {
+        // Probes mostly inside geometry would bleed darkness; their validity drops their weight
+        float validity = clamp((escaped[0] / float(RAYS_PER_PROBE) - 0.25) / 0.5, 0.0, 1.0);
+        ProbeSH fresh = ProbeSH(shR[0] / max(escaped[0], 1.0) * float(RAYS_PER_PROBE),
+                                shG[0] / max(escaped[0], 1.0) * float(RAYS_PER_PROBE),
+                                shB[0] / max(escaped[0], 1.0) * float(RAYS_PER_PROBE),
+                                vec4(validity, 1.0, 0.0, 0.0));
+
+        ProbeSH stored = probes[probe];
+        if (stored.meta.y != 0.0) {
+            fresh.r = mix(fresh.r, stored.r, HYSTERESIS);
+            fresh.g = mix(fresh.g, stored.g, HYSTERESIS);
+            fresh.b = mix(fresh.b, stored.b, HYSTERESIS);
+            fresh.meta.x = mix(fresh.meta.x, stored.meta.x, HYSTERESIS);
+        }
+        probes[probe] = fresh;
+    }
+}
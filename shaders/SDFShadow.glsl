@@ -0,0 +1,77 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+#ifdef SDF_FP16
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+#endif
+
+// ============================================================
+// SDF Playground — Shadow / AO Pass
+// Runs over the compacted hit list only, at reduced resolution:
+// one source pixel per low-res texel, accumulated over frames
+// with reprojection and rejected on disocclusion.
+// ============================================================
+
+layout(local_size_x = 64) in;
+
+#include "common/SDFScene.glsl"
+
+const float MAX_HISTORY = 16.0;
+
+// Bilinear fetch of last frame's history, skipping taps whose stored
+// distance does not match the reprojected surface (disocclusion).
+bool sampleHistory(vec2 prevPixel, float expectedDist, ivec2 lowSize, out vec4 history) {
+    vec2 f = (prevPixel + 0.5) / float(shadowScale()) - 0.5;
+    ivec2 base = ivec2(floor(f));
+    vec2 frac = f - vec2(base);
+
+    vec4 sum = vec4(0.0);
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 tap = base + offset;
+        if (any(lessThan(tap, ivec2(0))) || any(greaterThanEqual(tap, lowSize))) continue;
+
+        vec4 h = imageLoad(shadowHistory((frameIndex + 1u) & 1u), tap);
+        if (h.z < 0.0) continue;
+        if (abs(h.z - expectedDist) > 0.05 * expectedDist + 0.05) continue;
+
+        vec2 bw = mix(1.0 - frac, frac, vec2(offset));
+        float w = bw.x * bw.y;
+        sum += h * w;
+        weightSum += w;
+    }
+
+    if (weightSum < 1e-3) return false;
+    history = sum / weightSum;
+    return true;
+}
+
+void main() {
+    uint idx = gl_GlobalInvocationID.x;
+    if (idx >= hitCount) return;
+
+    ivec2 pixel = unpackPixel(hitPixels[idx]);
+    ivec2 size = ivec2(params.x, params.y);
+    ivec2 lowPixel = pixel / shadowScale();
+
+    float t = imageLoad(gbufferDepth, pixel).r;
+    vec3 n = imageLoad(gbufferNormal, pixel).xyz;
+    vec3 p = camPos.xyz + cameraRay(pixel, size) * t;
+
+    float shadow = softShadow(p + n * 0.01, normalize(SUN_DIR), 0.02, 20.0, 12.0);
+    float ao = calcAO(p, n);
+
+    vec2 result = vec2(shadow, ao);
+    float historyLength = 1.0;
+
+    vec2 prevPixel;
+    vec4 history;
+    if (historyValid == 1 && projectToPrevious(p, size, prevPixel) &&
+        sampleHistory(prevPixel, distance(p, prevCamPos.xyz), shadowSize(size), history)) {
+        historyLength = min(history.w + 1.0, MAX_HISTORY);
+        result = mix(history.xy, result, 1.0 / historyLength);
+    }
+
+    imageStore(shadowHistory(frameIndex & 1u), lowPixel, vec4(result, t, historyLength));
+}
@@ -0,0 +1,83 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// ============================================================
+// SDF Playground — Tile Edit Culling
+// One workgroup per 8x8 screen tile (the visibility pass's group).
+// Each edit's bounding sphere is tested against the cone enclosing
+// the tile's rays; survivors are appended in scene order.
+// ============================================================
+
+layout(local_size_x = 64) in;
+
+#include "common/SDFScene.glsl"
+
+shared bool editVisible[64];
+shared uint tileCount;
+
+void main() {
+    ivec2 size = ivec2(params.x, params.y);
+    uvec2 tile = gl_WorkGroupID.xy;
+    uint tilesX = (uint(size.x) + TILE_SIZE - 1u) / TILE_SIZE;
+    uint tileIndex = tile.y * tilesX + tile.x;
+    uint lid = gl_LocalInvocationIndex;
+
+    // Cone around the tile's centre ray that contains all four corner rays
+    vec2 tileMin = vec2(tile * TILE_SIZE);
+    vec2 tileMax = min(tileMin + float(TILE_SIZE), vec2(size));
+    vec3 axis = cameraRayAt(0.5 * (tileMin + tileMax), size);
+    float cosCone = 1.0;
+    for (int i = 0; i < 4; i++) {
+        vec2 corner = vec2((i & 1) != 0 ? tileMax.x : tileMin.x, (i & 2) != 0 ? tileMax.y : tileMin.y);
+        cosCone = min(cosCone, dot(axis, cameraRayAt(corner, size)));
+    }
+    float coneAngle = acos(clamp(cosCone, -1.0, 1.0));
+
+    if (lid == 0u) tileCount = 0u;
+
+    int count = min(int(params.w), 256);
+    for (int chunk = 0; chunk < count; chunk += 64) {
+        int i = chunk + int(lid);
+        bool visible = false;
+        if (i < count) {
+            SDFEditGPU e = edits[i];
+            if (e.operation == 2u) {
+                // Intersection clips everything before it, so it can never be skipped
+                visible = true;
+            } else {
+                float radius = editBoundingRadius(e);
+                vec3 v = e.position - camPos.xyz;
+                float dist = length(v);
+                if (dist <= radius) {
+                    visible = true;
+                } else {
+                    float angle = acos(clamp(dot(v / dist, axis), -1.0, 1.0));
+                    visible = angle <= coneAngle + asin(radius / dist) + 1e-3;
+                }
+            }
+        }
+        editVisible[lid] = visible;
+        barrier();
+
+        // Serial compaction keeps the edit order that the boolean ops depend on
+        if (lid == 0u && tileCount != TILE_OVERFLOW) {
+            uint n = tileCount;
+            for (uint j = 0u; j < 64u && chunk + int(j) < count; j++) {
+                if (!editVisible[j]) continue;
+                if (n == MAX_TILE_EDITS) {
+                    n = TILE_OVERFLOW;
+                    break;
+                }
+                tileEdits[tileIndex * TILE_STRIDE + 1u + n] = uint(chunk) + j;
+                n++;
+            }
+            tileCount = n;
+        }
+        barrier();
+    }
+
+    if (lid == 0u) {
+        tileEdits[tileIndex * TILE_STRIDE] = tileCount;
+    }
+}
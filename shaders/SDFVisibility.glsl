@@ -0,0 +1,67 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+#ifdef SDF_FP16
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+#endif
+
+// ============================================================
+// SDF Playground — Visibility Pass
+// Traces the terrain through its min/max pyramid, marches primary
+// rays against the tile's culled edit list only where edits can be,
+// and writes surface attributes to the G-Buffer.
+// One lit pixel per low-res shadow texel is appended to the hit list.
+// ============================================================
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#define SDF_STAGE_EDITS
+#include "common/SDFScene.glsl"
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = ivec2(params.x, params.y);
+
+    // Primary rays only need the edits culled for their tile
+    uint tilesX = (uint(size.x) + TILE_SIZE - 1u) / TILE_SIZE;
+    sceneTile = int(gl_WorkGroupID.y * tilesX + gl_WorkGroupID.x);
+    stageTileEdits(uint(sceneTile)); // Whole workgroup, before any invocation exits
+
+    if (pixel.x >= size.x || pixel.y >= size.y) return;
+
+    vec3 ro = camPos.xyz;
+    vec3 rd = cameraRay(pixel, size);
+
+    float t;
+    HitResult hit;
+    int steps = 0;
+    bool hitSurface = tracePrimaryRay(ro, rd, t, hit, steps);
+
+    uint info = (uint(steps) << 16) | uint((hitSurface ? hit.index : -1) + 1);
+    imageStore(gbufferInfo, pixel, uvec4(info));
+
+    // Only the lit view consumes shadows/AO, and only one pixel per low-res texel traces them
+    ivec2 lowPixel = pixel / shadowScale();
+    bool shadowSource = renderMode == 0 && pixel == shadowSourcePixel(lowPixel, size);
+
+    if (!hitSurface) {
+        imageStore(gbufferDepth, pixel, vec4(-1.0));
+        if (shadowSource) {
+            imageStore(shadowHistory(frameIndex & 1u), lowPixel, vec4(1.0, 1.0, -1.0, 0.0));
+        }
+        return;
+    }
+
+    vec3 n = calcNormal(ro + rd * t);
+    imageStore(gbufferDepth, pixel, vec4(t));
+    imageStore(gbufferNormal, pixel, vec4(n, hit.metallic));
+    imageStore(gbufferAlbedo, pixel, vec4(hit.albedo, hit.roughness));
+
+    if (shadowSource) {
+        uint slot = atomicAdd(hitCount, 1u);
+        hitPixels[slot] = packPixel(pixel);
+        if ((slot & 63u) == 0u) {
+            atomicAdd(dispatchX, 1u);
+        }
+    }
+}
@@ -1,11 +1,13 @@
 #version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(local_size_x = 8, local_size_y = 8) in;
 
-layout(binding = 0, r32f) uniform image2D heightmap;
-layout(binding = 1, rgba8) uniform image2D splatmap;
+#include "common/Bindless.glsl"
 
-layout(push_constant) uniform PushConstants {
+// Must match Terrain::BrushParams
+struct BrushStamp {
     vec2 pos;      // UV center
     float radius;  // UV radius
     float strength;
@@ -13,63 +15,97 @@ layout(push_constant) uniform PushConstants {
     uint layer;    // 0..3
     float targetHeight;
     float padding;
+};
+
+layout(set = 0, binding = BINDLESS_STORAGE_BUFFERS, std430) restrict readonly buffer BrushStamps {
+    BrushStamp stamps[];
+} gBrushStamps[];
+
+layout(push_constant) uniform PushConstants {
+    ivec2 rectMin; // Inclusive texel rectangle covered by the dispatch
+    ivec2 rectMax;
+    uint firstStamp;
+    uint stampCount;
+    uint stampsIndex;    // Bindless heap indices
+    uint heightmapIndex;
+    uint splatmapIndex;
 } pc;
 
+#define heightmap gImages2D_r32f[pc.heightmapIndex]
+#define splatmap  gImages2D_rgba8[pc.splatmapIndex]
+#define stamps    gBrushStamps[pc.stampsIndex].stamps
+
 void main() {
     ivec2 size = imageSize(heightmap);
-    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
-    
-    if (pixel.x >= size.x || pixel.y >= size.y) return;
+    ivec2 pixel = pc.rectMin + ivec2(gl_GlobalInvocationID.xy);
+
+    if (any(greaterThan(pixel, pc.rectMax)) || pixel.x >= size.x || pixel.y >= size.y) return;
 
     vec2 uv = (vec2(pixel) + 0.5) / vec2(size);
-    float dist = distance(uv, pc.pos);
 
-    if (dist > pc.radius) return;
+    // Stamps apply in queue order, so overlapping ones compose like separate dispatches.
+    // Each texel is loaded and stored once for the whole batch.
+    float h = imageLoad(heightmap, pixel).r;
+    vec4 splat = vec4(0);
+    bool heightChanged = false;
+    bool splatLoaded = false;
 
-    // Falloff function (smoothstep-like)
-    float falloff = smoothstep(pc.radius, pc.radius * 0.5, dist);
-    
-    if (pc.mode == 0) { // Raise
-        float h = imageLoad(heightmap, pixel).r;
-        h += pc.strength * falloff;
-        imageStore(heightmap, pixel, vec4(h, 0, 0, 0));
-    } 
-    else if (pc.mode == 1) { // Lower
-        float h = imageLoad(heightmap, pixel).r;
-        h -= pc.strength * falloff;
-        imageStore(heightmap, pixel, vec4(h, 0, 0, 0));
-    }
-    else if (pc.mode == 3) { // Smooth
-        // Box blur kernel (3x3)
-        float sum = 0.0;
-        float count = 0.0;
-        for (int y = -1; y <= 1; y++) {
-            for (int x = -1; x <= 1; x++) {
-                ivec2 p = pixel + ivec2(x, y);
-                if (p.x >= 0 && p.x < size.x && p.y >= 0 && p.y < size.y) {
-                    sum += imageLoad(heightmap, p).r;
-                    count += 1.0;
+    for (uint i = pc.firstStamp; i < pc.firstStamp + pc.stampCount; i++) {
+        BrushStamp stamp = stamps[i];
+        float dist = distance(uv, stamp.pos);
+        if (dist > stamp.radius) continue;
+
+        // Falloff function (smoothstep-like)
+        float falloff = smoothstep(stamp.radius, stamp.radius * 0.5, dist);
+
+        if (stamp.mode == 0) { // Raise
+            h += stamp.strength * falloff;
+            heightChanged = true;
+        }
+        else if (stamp.mode == 1) { // Lower
+            h -= stamp.strength * falloff;
+            heightChanged = true;
+        }
+        else if (stamp.mode == 3) { // Smooth
+            // Box blur kernel (3x3). Neighbours are read from the image, so smooth stamps
+            // are dispatched one at a time with a barrier between them.
+            float sum = h;
+            float count = 1.0;
+            for (int y = -1; y <= 1; y++) {
+                for (int x = -1; x <= 1; x++) {
+                    ivec2 p = pixel + ivec2(x, y);
+                    if ((x != 0 || y != 0) && p.x >= 0 && p.x < size.x && p.y >= 0 && p.y < size.y) {
+                        sum += imageLoad(heightmap, p).r;
+                        count += 1.0;
+                    }
                 }
             }
+            float avg = sum / count;
+            h = mix(h, avg, stamp.strength * falloff);
+            heightChanged = true;
         }
-        float avg = sum / count;
-        float h = imageLoad(heightmap, pixel).r;
-        h = mix(h, avg, pc.strength * falloff);
+        else if (stamp.mode == 4) { // Paint
+            if (!splatLoaded) {
+                splat = imageLoad(splatmap, pixel);
+                splatLoaded = true;
+            }
+
+            // Target layer gets +strength, others get -strength (normalize)
+            if (stamp.layer == 0) splat.r += stamp.strength * falloff;
+            if (stamp.layer == 1) splat.g += stamp.strength * falloff;
+            if (stamp.layer == 2) splat.b += stamp.strength * falloff;
+            if (stamp.layer == 3) splat.a += stamp.strength * falloff;
+
+            splat = max(splat, vec4(0));
+            float total = splat.r + splat.g + splat.b + splat.a;
+            if (total > 0.0001) splat /= total;
+        }
+    }
+
+    if (heightChanged) {
         imageStore(heightmap, pixel, vec4(h, 0, 0, 0));
     }
-    else if (pc.mode == 4) { // Paint
-        vec4 splat = imageLoad(splatmap, pixel);
-        
-        // Target layer gets +strength, others get -strength (normalize)
-        if (pc.layer == 0) splat.r += pc.strength * falloff;
-        if (pc.layer == 1) splat.g += pc.strength * falloff;
-        if (pc.layer == 2) splat.b += pc.strength * falloff;
-        if (pc.layer == 3) splat.a += pc.strength * falloff;
-        
-        splat = max(splat, vec4(0));
-        float total = splat.r + splat.g + splat.b + splat.a;
-        if (total > 0.0001) splat /= total;
-        
+    if (splatLoaded) {
         imageStore(splatmap, pixel, splat);
     }
 }
@@ -0,0 +1,53 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+// ============================================================
+// Terrain min/max pyramid update, one dispatch per level.
+// Level 0 texel = height range of the 3x3 heightmap texels its
+// bilinear footprint interpolates; level N = 2x2 of level N-1.
+// Ranges are stored as packHalf2x16(min, max).
+// ============================================================
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#include "common/Bindless.glsl"
+
+layout(push_constant) uniform PushConstants {
+    ivec2 rectMin; // Inclusive texel rectangle of the destination level
+    ivec2 rectMax;
+    int level;
+    uint heightmapIndex; // Bindless heap indices
+    uint pyramidIndex;   // Level 0; the other levels follow it
+} pc;
+
+#define heightmap gImages2D_r32f[pc.heightmapIndex]
+#define pyramid(level) gUImages2D_r32ui[pc.pyramidIndex + uint(level)]
+
+void main() {
+    ivec2 pixel = pc.rectMin + ivec2(gl_GlobalInvocationID.xy);
+    if (pixel.x > pc.rectMax.x || pixel.y > pc.rectMax.y) return;
+
+    vec2 range = vec2(1e30, -1e30);
+    if (pc.level == 0) {
+        ivec2 size = imageSize(heightmap);
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                float h = imageLoad(heightmap, clamp(pixel + ivec2(x, y), ivec2(0), size - 1)).r;
+                range = vec2(min(range.x, h), max(range.y, h));
+            }
+        }
+        // Widen before the fp16 round trip so the range stays conservative
+        vec2 margin = abs(range) * 1e-3 + 1e-3;
+        range += vec2(-margin.x, margin.y);
+    } else {
+        ivec2 srcSize = imageSize(pyramid(pc.level - 1));
+        for (int i = 0; i < 4; i++) {
+            ivec2 src = min(pixel * 2 + ivec2(i & 1, i >> 1), srcSize - 1);
+            vec2 child = unpackHalf2x16(imageLoad(pyramid(pc.level - 1), src).r);
+            range = vec2(min(range.x, child.x), max(range.y, child.y));
+        }
+    }
+
+    imageStore(pyramid(pc.level), pixel, uvec4(packHalf2x16(range)));
+}
@@ -0,0 +1,29 @@
+// ============================================================
+// SDF Playground — Global bindless heap (BindlessHeap.hpp)
+// Set 0 of every pass: one large, partially bound array per
+// descriptor type. An array may be declared several times with
+// different image types and formats; each resource is accessed
+// through the declaration that matches its view.
+// ============================================================
+
+// Runtime-sized arrays need GL_EXT_nonuniform_qualifier, which each pass enables
+// before any code. Indices here are uniform across the dispatch, so no access
+// needs nonuniformEXT.
+
+// Bindings, must match BindlessHeap::Kind
+#define BINDLESS_STORAGE_IMAGES  0
+#define BINDLESS_SAMPLED_IMAGES  1
+#define BINDLESS_STORAGE_BUFFERS 2
+
+layout(set = 0, binding = BINDLESS_STORAGE_IMAGES, r32f)    uniform image2D  gImages2D_r32f[];
+layout(set = 0, binding = BINDLESS_STORAGE_IMAGES, rgba8)   uniform image2D  gImages2D_rgba8[];
+layout(set = 0, binding = BINDLESS_STORAGE_IMAGES, rgba16f) uniform image2D  gImages2D_rgba16f[];
+layout(set = 0, binding = BINDLESS_STORAGE_IMAGES, r32ui)   uniform uimage2D gUImages2D_r32ui[];
+layout(set = 0, binding = BINDLESS_STORAGE_IMAGES, r16f)    uniform image3D  gImages3D_r16f[];
+layout(set = 0, binding = BINDLESS_STORAGE_IMAGES, r32ui)   uniform uimage3D gUImages3D_r32ui[];
+
+layout(set = 0, binding = BINDLESS_SAMPLED_IMAGES) uniform sampler2D  gTextures2D[];
+layout(set = 0, binding = BINDLESS_SAMPLED_IMAGES) uniform usampler2D gUTextures2D[];
+
+// Storage buffers are typed by their block, so users declare their own arrays at
+// binding BINDLESS_STORAGE_BUFFERS (see SDFScene.glsl)
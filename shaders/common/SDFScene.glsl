@@ -0,0 +1,951 @@
+// ============================================================
+// SDF Playground — Shared scene description
+// Included by every pass of the deferred SDF pipeline.
+// ============================================================
+
+#include "Bindless.glsl"
+
+// Every resource below lives in the bindless heap. This frame's heap indices are in a
+// resource table (written by SDFRenderer, slots must match SDFRenderer::ResourceSlot)
+// whose own index is the resourceTable push constant; the names used by the passes
+// are macros that look their resource up through it.
+const uint RES_BRICK_ATLAS = 0u;
+const uint RES_SPARSE_MAP = 1u;
+const uint RES_OUTPUT = 2u;
+const uint RES_EDITS = 3u;
+const uint RES_PICKS = 4u;
+const uint RES_TERRAIN_HEIGHT = 5u;
+const uint RES_TERRAIN_SPLAT = 6u;
+const uint RES_TERRAIN_MINMAX = 7u;
+const uint RES_GBUFFER_DEPTH = 8u;
+const uint RES_GBUFFER_NORMAL = 9u;
+const uint RES_GBUFFER_ALBEDO = 10u;
+const uint RES_GBUFFER_INFO = 11u;
+const uint RES_SHADOW_HISTORY = 12u; // Two consecutive slots
+const uint RES_HIT_LIST = 14u;
+const uint RES_TILE_EDITS = 15u;
+const uint RES_LIGHTS = 16u;
+const uint RES_CLUSTER_LIGHTS = 17u;
+const uint RES_PROBES = 18u;
+const uint RES_PRESENT_TARGET = 19u;
+
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) restrict readonly buffer ResourceTable {
+    uint slots[];
+} gResourceTables[];
+
+#define RESOURCE(slot) gResourceTables[resourceTable].slots[slot]
+
+#define brickAtlas gImages3D_r16f[RESOURCE(RES_BRICK_ATLAS)]
+#define sparseMap  gUImages3D_r32ui[RESOURCE(RES_SPARSE_MAP)]
+#define outImage   gImages2D_rgba8[RESOURCE(RES_OUTPUT)]
+
+// GPU Edit struct — must match CPU SDFEdit exactly
+struct SDFEditGPU {
+    vec3  position;   float pad1;
+    vec4  rotation;
+    vec3  scale;      uint  primitiveType;
+    uint  operation;  float blendFactor;
+    uint  isDynamic;  float pad2;
+    vec3  albedo;     float roughness;
+    float metallic;   float matPad1; float matPad2; float matPad3;
+};
+
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) buffer EditBuffer {
+    SDFEditGPU edits[];
+} gEditBuffers[];
+#define edits gEditBuffers[RESOURCE(RES_EDITS)].edits
+
+// Pick readback ring, one region per frame in flight. The pick pass reads a
+// request (xy = pixel) and overwrites it in place with the result.
+struct PickEntry {
+    vec3 position;
+    int  hitIndex; // -1 none, 0 ground, 1+ edit
+};
+
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) buffer PickBuffer {
+    PickEntry picks[];
+} gPickBuffers[];
+#define picks gPickBuffers[RESOURCE(RES_PICKS)].picks
+
+#define terrainHeight gTextures2D[RESOURCE(RES_TERRAIN_HEIGHT)]
+#define terrainSplat  gTextures2D[RESOURCE(RES_TERRAIN_SPLAT)]
+// Terrain height range pyramid: packHalf2x16(min, max) per texel, one mip per quadtree level.
+// A level-0 texel bounds the bilinear surface over its own footprint.
+#define terrainMinMax gUTextures2D[RESOURCE(RES_TERRAIN_MINMAX)]
+
+// G-Buffer written by the visibility pass
+#define gbufferDepth  gImages2D_r32f[RESOURCE(RES_GBUFFER_DEPTH)]     // hit distance along the view ray, < 0 on miss
+#define gbufferNormal gImages2D_rgba16f[RESOURCE(RES_GBUFFER_NORMAL)] // xyz=normal, w=metallic
+#define gbufferAlbedo gImages2D_rgba8[RESOURCE(RES_GBUFFER_ALBEDO)]   // rgb=albedo, a=roughness
+#define gbufferInfo   gUImages2D_r32ui[RESOURCE(RES_GBUFFER_INFO)]    // (steps << 16) | (hitIndex + 1)
+
+// Reduced-resolution shadow/AO history, ping-ponged by frame parity.
+// x=sun shadow, y=AO, z=hit distance (< 0 on miss), w=accumulated frame count
+#define shadowHistory(i) gImages2D_rgba16f[RESOURCE(RES_SHADOW_HISTORY + (i))]
+
+// Compacted list of lit pixels. The header doubles as VkDispatchIndirectCommand
+// for the shadow/AO pass (one 64-wide group per 64 appended pixels).
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) buffer HitList {
+    uint dispatchX;
+    uint dispatchY;
+    uint dispatchZ;
+    uint hitCount;
+    uint hitPixels[];
+} gHitLists[];
+#define dispatchX gHitLists[RESOURCE(RES_HIT_LIST)].dispatchX
+#define dispatchY gHitLists[RESOURCE(RES_HIT_LIST)].dispatchY
+#define dispatchZ gHitLists[RESOURCE(RES_HIT_LIST)].dispatchZ
+#define hitCount  gHitLists[RESOURCE(RES_HIT_LIST)].hitCount
+#define hitPixels gHitLists[RESOURCE(RES_HIT_LIST)].hitPixels
+
+// Per 8x8 screen tile edit lists built by the tile cull pass.
+// Each tile owns TILE_STRIDE uints: [0] = count (TILE_OVERFLOW if the tile
+// needs the full edit list), [1..] = edit indices in scene order.
+const uint TILE_SIZE = 8u;
+const uint TILE_STRIDE = 64u;
+const uint MAX_TILE_EDITS = TILE_STRIDE - 1u;
+const uint TILE_OVERFLOW = 0xFFFFFFFFu;
+
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) buffer TileEditList {
+    uint tileEdits[];
+} gTileEditLists[];
+#define tileEdits gTileEditLists[RESOURCE(RES_TILE_EDITS)].tileEdits
+
+// Dynamic point lights — must match CPU PointLight exactly
+struct PointLightGPU {
+    vec3  position; float radius;
+    vec3  color;    float intensity;
+};
+
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) buffer LightBuffer {
+    PointLightGPU lights[];
+} gLightBuffers[];
+#define lights gLightBuffers[RESOURCE(RES_LIGHTS)].lights
+
+// Per cluster light lists built by the light cull pass. Clusters split the screen
+// into CLUSTER_X x CLUSTER_Y tiles and CLUSTER_Z slices of hit distance, spaced
+// exponentially out to MAX_MARCH_DIST. Each cluster owns CLUSTER_STRIDE uints:
+// [0] = count | (lights dropped on overflow << 16), [1..] = light indices, ascending.
+const uint CLUSTER_X = 16u;
+const uint CLUSTER_Y = 9u;
+const uint CLUSTER_Z = 24u;
+const uint CLUSTER_STRIDE = 64u;
+const uint MAX_CLUSTER_LIGHTS = CLUSTER_STRIDE - 1u;
+const float CLUSTER_NEAR = 0.5; // Far edge of the first slice
+
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) buffer ClusterLightList {
+    uint clusterLights[];
+} gClusterLightLists[];
+#define clusterLights gClusterLightLists[RESOURCE(RES_CLUSTER_LIGHTS)].clusterLights
+
+// World-space irradiance probes, refreshed round-robin by the probe update pass.
+// Each probe stores L1 spherical harmonics of incoming radiance per colour channel
+// as (L0, L1x, L1y, L1z); meta.x = fraction of rays that escaped geometry, meta.y = 1 once traced.
+struct ProbeSH {
+    vec4 r;
+    vec4 g;
+    vec4 b;
+    vec4 meta;
+};
+
+const ivec3 PROBE_GRID = ivec3(32, 8, 32);
+const int PROBE_COUNT = PROBE_GRID.x * PROBE_GRID.y * PROBE_GRID.z;
+const vec3 PROBE_SPACING = vec3(4.0, 2.0, 4.0);
+const vec3 PROBE_ORIGIN = vec3(-62.0, -3.0, -62.0); // Probe (0, 0, 0)
+
+layout(std430, set = 0, binding = BINDLESS_STORAGE_BUFFERS) buffer ProbeBuffer {
+    ProbeSH probes[];
+} gProbeBuffers[];
+#define probes gProbeBuffers[RESOURCE(RES_PROBES)].probes
+
+layout(push_constant) uniform PushConstants {
+    vec4 camPos;     // xyz, w=shadow/AO resolution divisor
+    vec4 camDir;     // xyz + pad
+    vec4 params;     // resX, resY, time, editCount
+    uint lightCount; // Point lights in the light buffer
+    uint probeOffset; // First probe refreshed this frame (round-robin cursor)
+    uint pickBase;   // First PickEntry of this frame's ring slot
+    uint pickCount;
+    vec4 brushPos;   // xyz=pos, w=radius
+    float giIntensity; // Scale applied to probe irradiance
+    uint frameIndex;
+    uint historyValid; // 0 discards the shadow/AO history
+    uint resourceTable; // Heap index of this frame's resource table
+    vec4 prevCamPos; // Camera of the previous frame, for reprojection
+    vec4 prevCamDir;
+};
+
+// Specialization constants: quality tier and view toggles, so dead branches
+// are compiled out of each pipeline variant. IDs must match SpecConstant in SDFRenderer.hpp.
+layout(constant_id = 0) const int MAX_MARCH_STEPS = 128;
+layout(constant_id = 1) const int SHADOW_STEPS = 32;
+layout(constant_id = 2) const int AO_TAPS = 5;
+layout(constant_id = 3) const float MAX_MARCH_DIST = 100.0;
+layout(constant_id = 4) const uint renderMode = 0; // 0=Lit, 1=Normals, 2=Complexity, 3=Light Clusters
+layout(constant_id = 5) const bool showGround = true;
+layout(constant_id = 6) const bool showGrid = false;
+layout(constant_id = 7) const bool STAGE_EDITS = true; // Stage tile edit lists in shared memory
+layout(constant_id = 8) const int POINT_SHADOWS = 2;   // Point lights per pixel that trace soft shadows
+layout(constant_id = 9) const bool PROBE_GI = true;    // Ambient from the irradiance probe grid
+
+// ============== Evaluation Precision ==============
+// Passes built with -DSDF_FP16 (and GL_EXT_shader_explicit_arithmetic_types_float16
+// enabled before any code) evaluate primitives and smooth blends in half precision.
+// Positions stay fp32: only edit-local coordinates are narrowed.
+
+#ifdef SDF_FP16
+#define sdf_t    float16_t
+#define sdf_vec2 f16vec2
+#define sdf_vec3 f16vec3
+#else
+#define sdf_t    float
+#define sdf_vec2 vec2
+#define sdf_vec3 vec3
+#endif
+
+// Beyond this edit-local distance primitives fall back to their fp32 bounding sphere,
+// keeping squared lengths well inside the fp16 range (max 65504)
+const float SDF_FP16_RANGE = 64.0;
+
+// Distance narrowed for fp16 blending; sky-sized distances would overflow to inf
+sdf_t toSdf(float d) {
+#ifdef SDF_FP16
+    return sdf_t(clamp(d, -SDF_FP16_RANGE, SDF_FP16_RANGE));
+#else
+    return d;
+#endif
+}
+
+// ============== SDF Primitives ==============
+
+sdf_t sdSphere(sdf_vec3 p, sdf_t r) {
+    return length(p) - r;
+}
+
+sdf_t sdBox(sdf_vec3 p, sdf_vec3 b) {
+    sdf_vec3 q = abs(p) - b;
+    return length(max(q, sdf_t(0.0))) + min(max(q.x, max(q.y, q.z)), sdf_t(0.0));
+}
+
+sdf_t sdTorus(sdf_vec3 p, sdf_vec2 t) {
+    sdf_vec2 q = sdf_vec2(length(p.xz) - t.x, p.y);
+    return length(q) - t.y;
+}
+
+sdf_t sdCapsule(sdf_vec3 p, sdf_t h, sdf_t r) {
+    p.y -= clamp(p.y, sdf_t(0.0), h);
+    return length(p) - r;
+}
+
+sdf_t sdCylinder(sdf_vec3 p, sdf_t h, sdf_t r) {
+    sdf_vec2 d = abs(sdf_vec2(length(p.xz), p.y)) - sdf_vec2(r, h);
+    return min(max(d.x, d.y), sdf_t(0.0)) + length(max(d, sdf_t(0.0)));
+}
+
+float sdPlane(vec3 p) {
+    return p.y;
+}
+
+const float TERRAIN_WORLD_SIZE = 256.0;
+
+vec2 terrainRange(ivec2 cell, int level) {
+    return unpackHalf2x16(texelFetch(terrainMinMax, cell, level).r);
+}
+
+// Height range of the 2x2 cells of a pyramid level nearest to g (level-0 texel
+// coordinates). edge receives how far g is from the border of that block, in texels.
+vec2 terrainBlockRange(vec2 g, int level, out float edge) {
+    float cellSize = float(1 << level);
+    vec2 gl = g / cellSize;
+    ivec2 base = ivec2(floor(gl - 0.5));
+    ivec2 maxCell = textureSize(terrainMinMax, level) - 1;
+
+    vec2 range = vec2(1e30, -1e30);
+    for (int i = 0; i < 4; i++) {
+        vec2 r = terrainRange(clamp(base + ivec2(i & 1, i >> 1), ivec2(0), maxCell), level);
+        range = vec2(min(range.x, r.x), max(range.y, r.y));
+    }
+
+    vec2 e = min(gl - vec2(base), vec2(base + 2) - gl);
+    edge = min(e.x, e.y) * cellSize;
+    return range;
+}
+
+float sdTerrain(vec3 p) {
+    vec2 uv = (p.xz + TERRAIN_WORLD_SIZE * 0.5) / TERRAIN_WORLD_SIZE;
+    if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) return p.y;
+
+    float h = textureLod(terrainHeight, uv, 0.0).r;
+    float dy = p.y - h;
+
+    // Thin shell: a constant scale keeps normals smooth across texel blocks
+    if (abs(dy) < 0.05) return dy * 0.5;
+
+    float texelWorld = TERRAIN_WORLD_SIZE / float(textureSize(terrainMinMax, 0).x);
+    vec2 g = uv * float(textureSize(terrainMinMax, 0).x);
+
+    // Lipschitz bound inside the nearest 2x2 block: the bilinear slope there
+    // cannot exceed its height range per texel
+    float edge;
+    vec2 range = terrainBlockRange(g, 0, edge);
+    float slope = 1.41421356 * (range.y - range.x) / texelWorld;
+    float bound = min(abs(dy) / sqrt(1.0 + slope * slope), edge * texelWorld);
+
+    // Coarser blocks the point is clear of allow larger safe steps
+    for (int level = 2; level <= 6; level += 2) {
+        if (level >= textureQueryLevels(terrainMinMax)) break;
+        range = terrainBlockRange(g, level, edge);
+        float gap = dy > 0.0 ? p.y - range.y : range.x - p.y;
+        if (gap <= 0.0) break;
+        bound = max(bound, min(gap, edge * texelWorld));
+    }
+    return dy > 0.0 ? bound : -bound;
+}
+
+float terrainHeightAt(vec2 xz) {
+    vec2 uv = (xz + TERRAIN_WORLD_SIZE * 0.5) / TERRAIN_WORLD_SIZE;
+    return textureLod(terrainHeight, uv, 0.0).r;
+}
+
+// ============== SDF for a single edit ==============
+
+// Radius of the sphere enclosing an edit's primitive, centred on its position
+float primitiveRadius(SDFEditGPU e) {
+    switch (e.primitiveType) {
+        case 1: return length(e.scale);
+        case 2: return e.scale.x + e.scale.y;
+        case 3: return e.scale.y + e.scale.x;
+        case 4: return length(vec2(e.scale.x, e.scale.y));
+        default: return e.scale.x;
+    }
+}
+
+float evalPrimitive(vec3 p, SDFEditGPU e) {
+    vec3 lp = p - e.position;
+
+#ifdef SDF_FP16
+    if (dot(lp, lp) > SDF_FP16_RANGE * SDF_FP16_RANGE) {
+        return length(lp) - primitiveRadius(e);
+    }
+#endif
+
+    sdf_vec3 hp = sdf_vec3(lp);
+    sdf_vec3 hs = sdf_vec3(e.scale);
+    switch (e.primitiveType) {
+        case 0: return float(sdSphere(hp, hs.x));
+        case 1: return float(sdBox(hp, hs));
+        case 2: return float(sdTorus(hp, hs.xy));
+        case 3: return float(sdCapsule(hp, hs.y, hs.x));
+        case 4: return float(sdCylinder(hp, hs.y, hs.x));
+        default: return float(sdSphere(hp, hs.x));
+    }
+}
+
+// ============== Boolean Operations ==============
+
+float opUnion(float d1, float d2) { return min(d1, d2); }
+float opSubtract(float d1, float d2) { return max(d1, -d2); }
+float opIntersect(float d1, float d2) { return max(d1, d2); }
+
+sdf_t opSmoothUnion(sdf_t d1, sdf_t d2, sdf_t k) {
+    sdf_t h = clamp(sdf_t(0.5) + sdf_t(0.5) * (d2 - d1) / k, sdf_t(0.0), sdf_t(1.0));
+    return mix(d2, d1, h) - k * h * (sdf_t(1.0) - h);
+}
+
+sdf_t opSmoothSub(sdf_t d1, sdf_t d2, sdf_t k) {
+    sdf_t h = clamp(sdf_t(0.5) - sdf_t(0.5) * (d1 + d2) / k, sdf_t(0.0), sdf_t(1.0));
+    return mix(d1, -d2, h) + k * h * (sdf_t(1.0) - h);
+}
+
+// ============== Scene (ground + edits) ==============
+
+struct HitResult {
+    float dist;
+    vec3  albedo;
+    float roughness;
+    float metallic;
+    int   index; // -1 for sky/nothing, 0 for ground, 1+ for edits
+};
+
+void applyTerrainMaterial(vec3 p, inout HitResult res) {
+    // Material from splatmap
+    vec2 uv = (p.xz + TERRAIN_WORLD_SIZE * 0.5) / TERRAIN_WORLD_SIZE;
+
+    if (uv.x >= 0.0 && uv.x <= 1.0 && uv.y >= 0.0 && uv.y <= 1.0) {
+        vec4 splat = textureLod(terrainSplat, uv, 0.0);
+
+        // Mat 0 (Red ch): Grass
+        vec3 col0 = vec3(0.1, 0.4, 0.1); float rough0 = 0.9; float met0 = 0.0;
+        // Mat 1 (Green ch): Dirt
+        vec3 col1 = vec3(0.4, 0.3, 0.2); float rough1 = 1.0; float met1 = 0.0;
+        // Mat 2 (Blue ch): Rock
+        vec3 col2 = vec3(0.5, 0.5, 0.5); float rough2 = 0.7; float met2 = 0.0;
+        // Mat 3 (Alpha ch): Snow
+        vec3 col3 = vec3(0.9, 0.9, 0.95); float rough3 = 0.3; float met3 = 0.0;
+
+        res.albedo = col0 * splat.r + col1 * splat.g + col2 * splat.b + col3 * splat.a;
+        res.roughness = rough0 * splat.r + rough1 * splat.g + rough2 * splat.b + rough3 * splat.a;
+        res.metallic = met0 * splat.r + met1 * splat.g + met2 * splat.b + met3 * splat.a;
+
+        float sum = dot(splat, vec4(1.0));
+        if (sum > 0.001) {
+            res.albedo /= sum;
+            res.roughness /= sum;
+            res.metallic /= sum;
+        }
+    } else {
+        // Checkerboard fallback
+        float checker = mod(floor(p.x * 0.5) + floor(p.z * 0.5), 2.0);
+        res.albedo = mix(vec3(0.35, 0.38, 0.42), vec3(0.55, 0.58, 0.62), checker);
+        res.roughness = 0.9;
+        res.metallic = 0.0;
+    }
+
+    // --- Debug Grid ---
+    if (showGrid) {
+        // World space grid
+        float gridSize = 1.0;
+        float lineThickness = 0.02;
+
+        // Simple non-anti-aliased grid for now to avoid derivative issues in compute
+        vec2 g = abs(fract(p.xz / gridSize - 0.5) - 0.5);
+        float gLine = min(g.x, g.y);
+        if (gLine < lineThickness) {
+            res.albedo = mix(res.albedo, vec3(0.8), 0.5); // Light grid
+        }
+
+        // Major grid
+        vec2 gMajor = abs(fract(p.xz / 10.0) - 0.5);
+        float gMajorLine = min(gMajor.x, gMajor.y);
+        if (gMajorLine < 0.005) { // 0.005 * 10 = 0.05
+            res.albedo = mix(res.albedo, vec3(1.0), 0.6); // White major lines
+        }
+    }
+
+    // --- Brush Cursor ---
+    if (brushPos.w > 0.0) {
+        float dist = distance(p, brushPos.xyz);
+        float ringWidth = 0.1;
+
+        // Ring
+        if (abs(dist - brushPos.w) < ringWidth) {
+            res.albedo = mix(res.albedo, vec3(1.0, 0.5, 0.0), 0.8); // Orange ring
+        }
+        // Area
+        else if (dist < brushPos.w) {
+            res.albedo = mix(res.albedo, vec3(1.0, 0.5, 0.0), 0.1); // Faint orange fill
+        }
+    }
+}
+
+void applyEdit(vec3 p, SDFEditGPU e, int i, inout HitResult res) {
+    float d = evalPrimitive(p, e);
+
+    switch (e.operation) {
+        case 0: // Union
+            if (d < res.dist) {
+                res.dist = d;
+                res.albedo = e.albedo;
+                res.roughness = e.roughness;
+                res.metallic = e.metallic;
+                res.index = i + 1; // Edit index (1-based because 0 is ground)
+            }
+            break;
+        case 1: // Subtraction
+        {
+            float newDist = opSubtract(res.dist, d);
+            // Subtraction keeps base material/index
+            res.dist = newDist;
+            break;
+        }
+        case 2: // Intersection
+        {
+            float newDist = opIntersect(res.dist, d);
+            // If intersection is closer to the new part, swap index?
+            // For simplicity, we keep the previous index for now or take the new one if closer
+            if (newDist < res.dist && d < res.dist) {
+                res.index = i + 1;
+            }
+            res.dist = newDist;
+            break;
+        }
+        case 3: // Smooth Union
+        {
+            sdf_t k = sdf_t(max(e.blendFactor, 0.01));
+            sdf_t a = toSdf(res.dist);
+            sdf_t b = toSdf(d);
+            float newDist = float(opSmoothUnion(a, b, k));
+            float h = float(clamp(sdf_t(0.5) + sdf_t(0.5) * (b - a) / k, sdf_t(0.0), sdf_t(1.0)));
+            res.albedo = mix(e.albedo, res.albedo, h);
+            res.roughness = mix(e.roughness, res.roughness, h);
+            res.metallic = mix(e.metallic, res.metallic, h);
+            if (h < 0.5) res.index = i + 1; // Take index of the "closer" or "more dominant" part
+            res.dist = newDist;
+            break;
+        }
+        case 4: // Smooth Subtraction
+        {
+            sdf_t k = sdf_t(max(e.blendFactor, 0.01));
+            sdf_t a = toSdf(res.dist);
+            sdf_t b = toSdf(d);
+            float newDist = float(opSmoothSub(a, b, k));
+            float h = float(clamp(sdf_t(0.5) - sdf_t(0.5) * (a + b) / k, sdf_t(0.0), sdf_t(1.0)));
+            res.albedo = mix(res.albedo, e.albedo, h * 0.5);
+            res.dist = newDist;
+            break;
+        }
+    }
+}
+
+// Screen tile the current invocation marches through, or -1 to evaluate every edit.
+// Only primary rays stay inside their tile, so secondary rays leave this at -1.
+int sceneTile = -1;
+
+#ifdef SDF_STAGE_EDITS
+// Workgroup copy of the tile's culled edits (shaders that define SDF_STAGE_EDITS
+// run one workgroup per tile). Every invocation walks the same list in the same
+// order, so the edit loop and its operation switch stay subgroup-uniform.
+struct StagedEdit {
+    vec4 positionType;    // xyz position, w primitive type
+    vec4 scaleBlend;      // xyz scale, w blend factor
+    vec4 albedoRoughness;
+    vec4 metallicOpIndex; // x metallic, y operation, z index into edits[]
+};
+shared StagedEdit stagedEdits[TILE_STRIDE];
+#endif
+
+// Set once stageTileEdits() has filled stagedEdits for this workgroup
+bool editsStaged = false;
+uint stagedCount = 0u;
+
+// Number of edits mapScene evaluates for the current tile
+uint sceneEditCount() {
+    if (editsStaged) return stagedCount;
+    uint tileCount = sceneTile >= 0 ? tileEdits[uint(sceneTile) * TILE_STRIDE] : TILE_OVERFLOW;
+    return tileCount != TILE_OVERFLOW ? tileCount : uint(min(int(params.w), 256));
+}
+
+// Index into edits[] of the j-th evaluated edit, in scene order
+int sceneEdit(uint j) {
+    bool tiled = sceneTile >= 0 && tileEdits[uint(sceneTile) * TILE_STRIDE] != TILE_OVERFLOW;
+    return tiled ? int(tileEdits[uint(sceneTile) * TILE_STRIDE + 1u + j]) : int(j);
+}
+
+// The j-th evaluated edit, from shared memory when staged
+SDFEditGPU sceneEditData(uint j, out int index) {
+#ifdef SDF_STAGE_EDITS
+    if (editsStaged) {
+        StagedEdit s = stagedEdits[j];
+        SDFEditGPU e;
+        e.position = s.positionType.xyz;
+        e.primitiveType = uint(s.positionType.w);
+        e.scale = s.scaleBlend.xyz;
+        e.blendFactor = s.scaleBlend.w;
+        e.operation = uint(s.metallicOpIndex.y);
+        e.albedo = s.albedoRoughness.rgb;
+        e.roughness = s.albedoRoughness.a;
+        e.metallic = s.metallicOpIndex.x;
+        index = int(s.metallicOpIndex.z);
+        return e;
+    }
+#endif
+    index = sceneEdit(j);
+    return edits[index];
+}
+
+#ifdef SDF_STAGE_EDITS
+// Cooperatively copies the tile's edit list into shared memory. Must be called by
+// every invocation of the workgroup before any of them returns. Overflowing tiles
+// keep reading the global edit buffer.
+void stageTileEdits(uint tile) {
+    uint count = tileEdits[tile * TILE_STRIDE];
+    if (!STAGE_EDITS || count == TILE_OVERFLOW) return; // Uniform across the workgroup
+
+    uint lid = gl_LocalInvocationIndex;
+    if (lid < count) {
+        int index = int(tileEdits[tile * TILE_STRIDE + 1u + lid]);
+        SDFEditGPU e = edits[index];
+        stagedEdits[lid].positionType = vec4(e.position, float(e.primitiveType));
+        stagedEdits[lid].scaleBlend = vec4(e.scale, e.blendFactor);
+        stagedEdits[lid].albedoRoughness = vec4(e.albedo, e.roughness);
+        stagedEdits[lid].metallicOpIndex = vec4(e.metallic, float(e.operation), float(index), 0.0);
+    }
+    barrier();
+
+    editsStaged = true;
+    stagedCount = count;
+}
+#endif
+
+HitResult mapScene(vec3 p) {
+    // Start with infinite distance
+    HitResult res;
+    res.dist = 1e10;
+    res.albedo = vec3(0.5);
+    res.roughness = 0.8;
+    res.metallic = 0.0;
+    res.index = -1;
+
+    // Ground plane (optional)
+    if (showGround) {
+        float ground = sdTerrain(p);
+        if (ground < res.dist) {
+            res.dist = ground;
+            applyTerrainMaterial(p, res);
+            res.index = 0; // Ground index
+        }
+    }
+
+    // Evaluate each edit (only those overlapping the tile's frustum for primary rays)
+    uint count = sceneEditCount();
+    for (uint j = 0u; j < count; j++) {
+        int index;
+        SDFEditGPU e = sceneEditData(j, index);
+        applyEdit(p, e, index, res);
+    }
+
+    return res;
+}
+
+// Radius around e.position containing every point the edit can change.
+// Smooth blends reach at most 1.25 * k beyond the primitive itself.
+float editBoundingRadius(SDFEditGPU e) {
+    float r = primitiveRadius(e);
+    if (e.operation == 3u || e.operation == 4u) {
+        r += 1.25 * max(e.blendFactor, 0.01);
+    }
+    return r;
+}
+
+// Range along a ray covered by the bounding spheres of the edits mapScene evaluates.
+// Outside [tEnter, tExit] only the ground can produce a surface.
+void editsInterval(vec3 ro, vec3 rd, out float tEnter, out float tExit) {
+    tEnter = 1e10;
+    tExit = -1e10;
+
+    uint count = sceneEditCount();
+    for (uint j = 0u; j < count; j++) {
+        int index;
+        SDFEditGPU e = sceneEditData(j, index);
+        if (e.operation == 2u) {
+            // Intersection clips the whole scene, nothing can be skipped
+            tEnter = 0.0;
+            tExit = 1e10;
+            return;
+        }
+
+        float r = editBoundingRadius(e);
+        vec3 oc = ro - e.position;
+        float b = dot(oc, rd);
+        float disc = b * b - (dot(oc, oc) - r * r);
+        if (disc < 0.0) continue;
+
+        float s = sqrt(disc);
+        if (-b + s < 0.0) continue;
+        tEnter = min(tEnter, max(-b - s, 0.0));
+        tExit = max(tExit, -b + s);
+    }
+}
+
+// ============== Scene queries ==============
+
+// Quadtree traversal of the terrain min/max pyramid: whole cells the ray stays above
+// are skipped at the coarsest level possible, and level-0 cells it overlaps are
+// searched for the bilinear surface crossing. Returns false if the iteration budget
+// ran out, in which case tHit is a safe distance to continue marching from.
+// Otherwise tHit is the first ground hit (heightmap or outer y = 0 plane), or -1.
+bool traceTerrain(vec3 ro, vec3 rd, float tMax, out float tHit, inout int iterations) {
+    const float halfSize = TERRAIN_WORLD_SIZE * 0.5;
+    tHit = -1.0;
+
+    // Outside the heightmap the ground is the y = 0 plane
+    if (rd.y < 0.0 || ro.y < 0.0) {
+        float tp = ro.y < 0.0 ? 0.0 : -ro.y / rd.y;
+        vec3 pp = ro + rd * tp;
+        if (tp <= tMax && (abs(pp.x) > halfSize || abs(pp.z) > halfSize)) tHit = tp;
+    }
+
+    int levels = textureQueryLevels(terrainMinMax);
+    float gridSize = float(textureSize(terrainMinMax, 0).x);
+    float scale = gridSize / TERRAIN_WORLD_SIZE;
+
+    // Ray in level-0 texel space (xz), t stays in world units
+    vec2 o = (ro.xz + halfSize) * scale;
+    vec2 d = rd.xz * scale;
+    vec2 invD = vec2(abs(d.x) > 1e-8 ? 1.0 / d.x : 1e30, abs(d.y) > 1e-8 ? 1.0 / d.y : 1e30);
+
+    vec2 t0 = -o * invD;
+    vec2 t1 = (vec2(gridSize) - o) * invD;
+    float t = max(max(min(t0.x, t1.x), min(t0.y, t1.y)), 0.0);
+    float tFar = min(min(max(t0.x, t1.x), max(t0.y, t1.y)), tHit >= 0.0 ? tHit : tMax);
+
+    int level = levels - 1;
+    for (int i = 0; i < 160; i++) {
+        if (t >= tFar) return true;
+        iterations++;
+
+        float cellSize = float(1 << level);
+        ivec2 maxCell = textureSize(terrainMinMax, level) - 1;
+        vec2 g = o + d * t + sign(d) * 1e-3;
+        ivec2 cell = clamp(ivec2(floor(g / cellSize)), ivec2(0), maxCell);
+        vec2 range = terrainRange(cell, level);
+
+        vec2 exitEdge = (vec2(cell) + step(0.0, d)) * cellSize;
+        vec2 tEdge = (exitEdge - o) * invD;
+        float tExit = min(max(min(tEdge.x, tEdge.y), t + 1e-4), tFar);
+
+        float y0 = ro.y + rd.y * t;
+        float y1 = ro.y + rd.y * tExit;
+        if (min(y0, y1) > range.y) {
+            // Above everything in this cell: skip it and retry one level coarser
+            t = tExit;
+            level = min(level + 1, levels - 1);
+            continue;
+        }
+        if (level > 0) {
+            level--;
+            continue;
+        }
+
+        // Candidate texel: look for the crossing of the bilinear surface
+        float prevT = t;
+        if (y0 - terrainHeightAt(ro.xz + rd.xz * t) <= 0.0) {
+            tHit = t;
+            return true;
+        }
+        for (int k = 1; k <= 4; k++) {
+            float st = mix(t, tExit, float(k) * 0.25);
+            if (ro.y + rd.y * st - terrainHeightAt(ro.xz + rd.xz * st) <= 0.0) {
+                float a = prevT;
+                float b = st;
+                for (int j = 0; j < 8; j++) {
+                    float m = 0.5 * (a + b);
+                    if (ro.y + rd.y * m - terrainHeightAt(ro.xz + rd.xz * m) > 0.0) a = m; else b = m;
+                }
+                tHit = b;
+                return true;
+            }
+            prevT = st;
+        }
+
+        t = tExit;
+        level = min(level + 1, levels - 1);
+    }
+
+    tHit = t;
+    return false;
+}
+
+vec3 calcNormal(vec3 p) {
+    const float h = 0.001;
+    return normalize(vec3(
+        mapScene(p + vec3(h, 0, 0)).dist - mapScene(p - vec3(h, 0, 0)).dist,
+        mapScene(p + vec3(0, h, 0)).dist - mapScene(p - vec3(0, h, 0)).dist,
+        mapScene(p + vec3(0, 0, h)).dist - mapScene(p - vec3(0, 0, h)).dist
+    ));
+}
+
+float softShadow(vec3 ro, vec3 rd, float mint, float maxt, float k) {
+    float res = 1.0;
+    float t = mint;
+    for (int i = 0; i < SHADOW_STEPS && t < maxt; i++) {
+        float h = mapScene(ro + rd * t).dist;
+        if (h < 0.001) return 0.0;
+        res = min(res, k * h / t);
+        t += clamp(h, 0.02, 0.5);
+    }
+    return clamp(res, 0.0, 1.0);
+}
+
+float calcAO(vec3 p, vec3 n) {
+    float occ = 0.0;
+    float sca = 1.0;
+    for (int i = 0; i < AO_TAPS; i++) {
+        float h = 0.02 + 0.12 * float(i);
+        float d = mapScene(p + n * h).dist;
+        occ += (h - d) * sca;
+        sca *= 0.75;
+    }
+    return clamp(1.0 - 1.5 * occ, 0.0, 1.0);
+}
+
+// Full primary ray query: the terrain is traversed through its pyramid and
+// edits are only sphere-traced inside their bounds. Returns true on a hit.
+bool tracePrimaryRay(vec3 ro, vec3 rd, out float t, out HitResult hit, inout int steps) {
+    hit.dist = 1e10;
+    hit.index = -1;
+    bool hitSurface = false;
+
+    // Ground is resolved by the pyramid traversal; edits only matter inside their bounds
+    float tEnter, tExit;
+    editsInterval(ro, rd, tEnter, tExit);
+
+    float tTerrain = -1.0;
+    bool terrainResolved = true;
+    if (showGround) {
+        terrainResolved = traceTerrain(ro, rd, MAX_MARCH_DIST, tTerrain, steps);
+    }
+
+    // Nothing but ground exists before the first edit bound
+    t = terrainResolved ? tEnter : min(tEnter, tTerrain);
+    if (terrainResolved && tTerrain >= 0.0 && tTerrain <= tEnter) {
+        t = tTerrain;
+        hit = mapScene(ro + rd * t);
+        return true;
+    }
+
+    // Ray march
+    for (int i = 0; i < MAX_MARCH_STEPS; i++) {
+        if (t > MAX_MARCH_DIST) break;
+
+        // Past every edit bound, only the already traced ground can still be hit
+        if (terrainResolved && t > tExit && (tTerrain < 0.0 || tTerrain >= t)) {
+            if (tTerrain >= 0.0) {
+                t = tTerrain;
+                hit = mapScene(ro + rd * t);
+                hitSurface = true;
+            }
+            break;
+        }
+
+        steps++;
+        hit = mapScene(ro + rd * t);
+        if (hit.dist < 0.001) {
+            hitSurface = true;
+            break;
+        }
+        t += hit.dist;
+    }
+
+    return hitSurface;
+}
+
+// ============== Camera ==============
+
+const vec3 SUN_DIR = vec3(0.6, 0.8, -0.4); // normalized at use
+const vec3 SUN_COLOR = vec3(1.4, 1.3, 1.2);
+
+vec3 skyColor(vec3 rd) {
+    float skyT = 0.5 * (rd.y + 1.0);
+    return mix(vec3(0.45, 0.50, 0.60), vec3(0.20, 0.30, 0.55), skyT);
+}
+
+// Ray through a continuous screen position (pixel corners at integer coordinates)
+vec3 cameraRayAt(vec2 screenPos, ivec2 size) {
+    vec2 uv = screenPos / vec2(size) * 2.0 - 1.0;
+    uv.y = -uv.y; // Vulkan Y flip
+    uv.x *= float(size.x) / float(size.y);
+
+    vec3 forward = normalize(camDir.xyz);
+    vec3 worldUp = vec3(0, 1, 0);
+    vec3 right = normalize(cross(forward, worldUp));
+    vec3 up = cross(right, forward);
+    float fov = 1.0;
+    return normalize(forward * fov + right * uv.x + up * uv.y);
+}
+
+vec3 cameraRay(ivec2 pixel, ivec2 size) {
+    return cameraRayAt(vec2(pixel) + 0.5, size);
+}
+
+// ============== Light Clusters ==============
+
+// Hit distance where a cluster slice begins
+float clusterSliceStart(uint slice) {
+    if (slice == 0u) return 0.0;
+    return CLUSTER_NEAR * pow(MAX_MARCH_DIST / CLUSTER_NEAR, float(slice - 1u) / float(CLUSTER_Z - 1u));
+}
+
+uint clusterIndex(ivec2 pixel, ivec2 size, float t) {
+    uvec2 xy = min(uvec2(pixel * ivec2(CLUSTER_X, CLUSTER_Y) / size), uvec2(CLUSTER_X, CLUSTER_Y) - 1u);
+    uint slice = 0u;
+    if (t > CLUSTER_NEAR) {
+        float s = log(t / CLUSTER_NEAR) / log(MAX_MARCH_DIST / CLUSTER_NEAR) * float(CLUSTER_Z - 1u);
+        slice = min(uint(s) + 1u, CLUSTER_Z - 1u);
+    }
+    return (slice * CLUSTER_Y + xy.y) * CLUSTER_X + xy.x;
+}
+
+// ============== Irradiance Probes ==============
+
+// Cosine-convolved irradiance of one L1 SH channel around normal n
+float shIrradiance(vec4 sh, vec3 n) {
+    const float A0 = 3.14159265 * 0.282095;
+    const float A1 = 2.09439510 * 0.488603;
+    return max(A0 * sh.x + A1 * dot(sh.yzw, n), 0.0);
+}
+
+// Trilinear blend of the 8 surrounding probes, weighted away from probes behind
+// the surface and from probes buried in geometry. False outside the grid.
+bool sampleProbeIrradiance(vec3 p, vec3 n, out vec3 irradiance) {
+    irradiance = vec3(0.0);
+    vec3 g = (p - PROBE_ORIGIN) / PROBE_SPACING;
+    if (any(lessThan(g, vec3(0.0))) || any(greaterThan(g, vec3(PROBE_GRID - 1)))) return false;
+
+    ivec3 base = min(ivec3(floor(g)), PROBE_GRID - 2);
+    vec3 f = g - vec3(base);
+
+    float weightSum = 0.0;
+    for (int i = 0; i < 8; i++) {
+        ivec3 offset = ivec3(i & 1, (i >> 1) & 1, i >> 2);
+        ivec3 cell = base + offset;
+        ProbeSH probe = probes[(cell.z * PROBE_GRID.y + cell.y) * PROBE_GRID.x + cell.x];
+        if (probe.meta.y == 0.0) continue;
+
+        vec3 tri = mix(1.0 - f, f, vec3(offset));
+        vec3 toProbe = normalize(PROBE_ORIGIN + vec3(cell) * PROBE_SPACING - p + n * 1e-3);
+        float facing = 0.5 * dot(toProbe, n) + 0.5;
+        float w = tri.x * tri.y * tri.z * (facing * facing + 0.05) * probe.meta.x;
+
+        irradiance += w * vec3(shIrradiance(probe.r, n), shIrradiance(probe.g, n), shIrradiance(probe.b, n));
+        weightSum += w;
+    }
+
+    if (weightSum < 1e-4) return false;
+    irradiance /= weightSum;
+    return true;
+}
+
+// Projects a world position into the previous frame's pixel space.
+// Returns false if the point was behind the previous camera.
+bool projectToPrevious(vec3 p, ivec2 size, out vec2 prevPixel) {
+    vec3 forward = normalize(prevCamDir.xyz);
+    vec3 right = normalize(cross(forward, vec3(0, 1, 0)));
+    vec3 up = cross(right, forward);
+
+    vec3 v = p - prevCamPos.xyz;
+    float z = dot(v, forward);
+    if (z <= 1e-4) return false;
+
+    float aspect = float(size.x) / float(size.y);
+    vec2 ndc = vec2(dot(v, right) / z / aspect, -dot(v, up) / z);
+    prevPixel = (ndc * 0.5 + 0.5) * vec2(size) - 0.5;
+    return true;
+}
+
+// ============== Reduced-resolution shadow/AO ==============
+
+int shadowScale() {
+    return int(camPos.w);
+}
+
+ivec2 shadowSize(ivec2 size) {
+    int s = shadowScale();
+    return (size + s - 1) / s;
+}
+
+// Full-resolution pixel that feeds a low-resolution texel this frame.
+// Cycles through the whole s x s footprint so the history converges to full coverage.
+ivec2 shadowSourcePixel(ivec2 lowPixel, ivec2 size) {
+    int s = shadowScale();
+    int k = int(frameIndex % uint(s * s));
+    return min(lowPixel * s + ivec2(k % s, k / s), size - 1);
+}
+
+uint packPixel(ivec2 pixel) {
+    return (uint(pixel.y) << 16) | uint(pixel.x);
+}
+
+ivec2 unpackPixel(uint packed) {
+    return ivec2(int(packed & 0xFFFFu), int(packed >> 16));
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "core/VulkanContext.hpp"
+#include "core/CpuProfiler.hpp"
+#include "core/ImageWriter.hpp"
+#include "renderer/SDFRenderer.hpp"
+#include "BenchScene.hpp"
+#include "BenchReport.hpp"
+
+namespace {
+
+struct BenchOptions {
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t warmupFrames = 30;
+    uint32_t frames = 300;
+    uint32_t framesInFlight = engine::core::VulkanContext::DEFAULT_FRAMES_IN_FLIGHT;
+    uint32_t recordThreads = 0; // 0 keeps the context's default
+    engine::bench::SceneParams scene;
+    std::string quality = "high";
+    bool stageEdits = true;
+    bool fp16Check = false;
+    std::string output = "bench.json";
+    std::string capture; // Last frame as an image, when set
+};
+
+const char* USAGE =
+    "EngineBench [--size WxH] [--frames N] [--warmup N] [--seed N] [--edits N] [--strokes N]\n"
+    "            [--quality low|medium|high|ultra] [--frames-in-flight 1-3] [--record-threads N]\n"
+    "            [--stage-edits on|off]\n"
+    "            [--output results.json] [--capture frame.png]\n"
+    "EngineBench --fp16-check [--size WxH] [--seed N] [--edits N] [--quality ...] [--output results.json]\n"
+    "EngineBench --compare base.json current.json [--threshold percent]\n";
+
+bool parseQuality(const std::string& name, engine::renderer::QualityPreset& quality) {
+    static const std::map<std::string, engine::renderer::QualityPreset> presets = {
+        { "low", engine::renderer::QualityPreset::Low },
+        { "medium", engine::renderer::QualityPreset::Medium },
+        { "high", engine::renderer::QualityPreset::High },
+        { "ultra", engine::renderer::QualityPreset::Ultra }
+    };
+    auto it = presets.find(name);
+    if (it == presets.end()) return false;
+    quality = it->second;
+    return true;
+}
+
+// Renders warmup + measured frames along the camera path at a fixed timestep. The
+// frame index alone decides what is drawn, so two runs with the same options
+// render the same images.
+engine::bench::Report runBenchmark(const BenchOptions& options, engine::renderer::QualityPreset quality) {
+    using engine::core::CpuProfiler;
+
+    engine::core::VulkanContext context(options.width, options.height, options.framesInFlight);
+    if (options.recordThreads > 0) {
+        context.setRecordingThreads(options.recordThreads);
+    }
+    engine::renderer::SDFRenderer renderer(context);
+    renderer.getQuality() = quality;
+    renderer.getStageEdits() = options.stageEdits;
+    renderer.waitForVariants();
+    engine::bench::buildScene(renderer, options.scene);
+    auto stamps = engine::bench::buildBrushStrokes(options.scene);
+
+    auto& gpuProfiler = context.getGpuProfiler();
+    if (!gpuProfiler.isSupported()) {
+        std::cerr << "warning: no GPU timestamps on this device, the report has CPU timings only" << std::endl;
+    }
+
+    std::vector<double> frameMs, workMs;
+    std::map<std::string, std::vector<double>> passMs;
+
+    // The profiler numbers frames from 0 in submission order, i.e. by loop index
+    uint64_t nextGpuFrame = options.warmupFrames;
+    auto consumeGpuTimings = [&] {
+        for (const auto& frame : gpuProfiler.getHistory()) {
+            if (frame.frameNumber < nextGpuFrame) continue;
+            // A pass name can repeat within a frame; report its total
+            std::map<std::string, double> totals;
+            for (const auto& scope : frame.scopes) {
+                totals[scope.name] += scope.endMs - scope.startMs;
+            }
+            for (const auto& [name, ms] : totals) {
+                passMs[name].push_back(ms);
+            }
+            nextGpuFrame = frame.frameNumber + 1;
+        }
+    };
+
+    const float deltaTime = 1.0f / 60.0f;
+    const engine::core::InputState input{};
+    uint32_t totalFrames = options.warmupFrames + options.frames;
+    for (uint32_t frame = 0; frame < totalFrames; frame++) {
+        double frameStart = CpuProfiler::nowUs();
+
+        auto pose = engine::bench::cameraPath(frame * deltaTime);
+        renderer.setCamera(pose.position, pose.yaw, pose.pitch);
+        if (frame < stamps.size()) {
+            if (frame % engine::bench::STAMPS_PER_STROKE == 0) {
+                renderer.getTerrain().endStroke();
+            }
+            renderer.getTerrain().queueBrush(stamps[frame]);
+        }
+        renderer.update(deltaTime, input, false);
+
+        // Blocks on the fence of the frame framesInFlight back
+        double waitStart = CpuProfiler::nowUs();
+        context.beginFrame();
+        double waitUs = CpuProfiler::nowUs() - waitStart;
+        consumeGpuTimings();
+
+        renderer.render(context.getRenderGraph());
+        if (!renderer.usesDirectPresent()) {
+            context.endFrameBlit(renderer.getOutputImage());
+        }
+        if (!options.capture.empty() && frame + 1 == totalFrames) {
+            context.requestCapture();
+        }
+        context.endFramePresent();
+
+        double frameUs = CpuProfiler::nowUs() - frameStart;
+        if (frame >= options.warmupFrames) {
+            frameMs.push_back(frameUs / 1000.0);
+            workMs.push_back((frameUs - waitUs) / 1000.0);
+        }
+    }
+
+    if (!options.capture.empty()) {
+        std::vector<uint8_t> pixels;
+        if (!context.readCapture(pixels) ||
+            !engine::core::ImageWriter::write(options.capture, options.width, options.height, pixels.data())) {
+            std::cerr << "warning: failed to write " << options.capture << std::endl;
+        }
+    }
+
+    context.getDevice().waitIdle();
+    gpuProfiler.flush();
+    consumeGpuTimings();
+
+    engine::bench::Report report;
+    auto properties = context.getPhysicalDevice().getProperties();
+    report.config["device"] = properties.deviceName.data();
+    report.config["size"] = std::to_string(options.width) + "x" + std::to_string(options.height);
+    report.config["frames"] = std::to_string(options.frames);
+    report.config["warmup"] = std::to_string(options.warmupFrames);
+    report.config["seed"] = std::to_string(options.scene.seed);
+    report.config["edits"] = std::to_string(std::min<uint32_t>(options.scene.editCount, 256));
+    report.config["strokes"] = std::to_string(options.scene.strokeCount);
+    report.config["quality"] = options.quality;
+    report.config["framesInFlight"] = std::to_string(context.getFramesInFlight());
+    report.config["recordThreads"] = std::to_string(context.getRecorder().getThreadCount());
+    report.config["stageEdits"] = options.stageEdits ? "on" : "off";
+    report.config["fp16"] = renderer.usesFp16Evaluation() ? "on" : "off";
+    report.config["directPresent"] = renderer.usesDirectPresent() ? "on" : "off";
+
+    // Frame: wall time of a loop iteration. Work: the same minus the fence wait, i.e. CPU cost
+    report.cpu["Frame"] = engine::bench::summarize(frameMs);
+    report.cpu["Work"] = engine::bench::summarize(workMs);
+    for (auto& [name, samples] : passMs) {
+        report.gpu[name] = engine::bench::summarize(std::move(samples));
+    }
+    return report;
+}
+
+// --fp16-check: scenes seed..seed+FP16_CHECK_SCENES-1, each seen from points of the camera path
+constexpr uint32_t FP16_CHECK_SCENES = 4;
+constexpr float FP16_CHECK_VIEW_TIMES[] = { 0.0f, 5.0f, 10.0f, 15.0f };
+// Pixels where only one variant hits, or whose hit distances differ by more than
+// FP16_OUTLIER_DEPTH, found a different surface (silhouettes, grazing hits). Their share is
+// bounded on its own; the mean errors cover the remaining pixels.
+constexpr double FP16_OUTLIER_DEPTH = 0.01;      // Relative
+constexpr double FP16_MAX_OUTLIER_FRACTION = 0.01;
+constexpr double FP16_MAX_MEAN_DEPTH_ERROR = 0.002; // Relative
+constexpr double FP16_MAX_MEAN_NORMAL_ERROR = 2.0;  // Degrees
+
+// Renders every reference view with the FP32 and then the FP16 visibility/shadow variants,
+// reads both G-Buffers back and compares hit distance and normal per pixel. Returns false
+// when an error exceeds its bound.
+bool runFp16Check(const BenchOptions& options, engine::renderer::QualityPreset quality, engine::bench::Report& report) {
+    engine::core::VulkanContext context(options.width, options.height, options.framesInFlight);
+    engine::renderer::SDFRenderer renderer(context);
+    renderer.getQuality() = quality;
+    renderer.getStageEdits() = options.stageEdits;
+    renderer.waitForVariants();
+
+    auto properties = context.getPhysicalDevice().getProperties();
+    report.config["device"] = properties.deviceName.data();
+    report.config["size"] = std::to_string(options.width) + "x" + std::to_string(options.height);
+    report.config["seed"] = std::to_string(options.scene.seed);
+    report.config["scenes"] = std::to_string(FP16_CHECK_SCENES);
+    report.config["edits"] = std::to_string(std::min<uint32_t>(options.scene.editCount, 256));
+    report.config["quality"] = options.quality;
+    report.config["stageEdits"] = options.stageEdits ? "on" : "off";
+
+    if (!renderer.supportsFp16Evaluation()) {
+        std::cout << "No shaderFloat16 on this device: the FP16 variants are never used, nothing to check" << std::endl;
+        report.config["fp16Check"] = "unsupported";
+        return true;
+    }
+
+    const engine::core::InputState input{};
+    auto renderView = [&](bool fp16, const engine::bench::CameraPose& pose,
+                          engine::renderer::SDFRenderer::GBufferCapture& capture) {
+        renderer.setFp16Evaluation(fp16);
+        renderer.setCamera(pose.position, pose.yaw, pose.pitch);
+        renderer.update(0.0f, input, false);
+
+        context.beginFrame();
+        renderer.requestGBufferCapture();
+        renderer.render(context.getRenderGraph());
+        if (!renderer.usesDirectPresent()) {
+            context.endFrameBlit(renderer.getOutputImage());
+        }
+        context.endFramePresent();
+
+        context.getDevice().waitIdle();
+        if (!renderer.readGBufferCapture(capture)) {
+            throw std::runtime_error("G-Buffer capture was not recorded");
+        }
+    };
+
+    double depthSum = 0.0, depthMax = 0.0, normalSum = 0.0, normalMax = 0.0;
+    uint64_t pixels = 0, compared = 0, outliers = 0;
+
+    engine::bench::SceneParams scene = options.scene;
+    for (uint32_t sceneIndex = 0; sceneIndex < FP16_CHECK_SCENES; sceneIndex++) {
+        scene.seed = options.scene.seed + sceneIndex;
+        engine::bench::buildScene(renderer, scene);
+
+        for (float time : FP16_CHECK_VIEW_TIMES) {
+            auto pose = engine::bench::cameraPath(time);
+            engine::renderer::SDFRenderer::GBufferCapture reference, half;
+            renderView(false, pose, reference);
+            renderView(true, pose, half);
+
+            for (size_t i = 0; i < reference.depth.size(); i++) {
+                pixels++;
+                float depth32 = reference.depth[i], depth16 = half.depth[i];
+                if ((depth32 >= 0.0f) != (depth16 >= 0.0f)) {
+                    outliers++;
+                    continue;
+                }
+                if (depth32 < 0.0f) continue;
+
+                double depthError = std::abs(depth16 - depth32) / std::max(depth32, 1e-3f);
+                glm::vec3 n32 = reference.normal[i], n16 = half.normal[i];
+                double normalError = 0.0;
+                if (glm::length(n32) > 0.0f && glm::length(n16) > 0.0f) {
+                    float cosine = std::clamp(glm::dot(glm::normalize(n32), glm::normalize(n16)), -1.0f, 1.0f);
+                    normalError = glm::degrees(std::acos(cosine));
+                }
+                depthMax = std::max(depthMax, depthError);
+                normalMax = std::max(normalMax, normalError);
+
+                if (depthError > FP16_OUTLIER_DEPTH) {
+                    outliers++;
+                    continue;
+                }
+                depthSum += depthError;
+                normalSum += normalError;
+                compared++;
+            }
+        }
+    }
+
+    double depthMean = compared > 0 ? depthSum / compared : 0.0;
+    double normalMean = compared > 0 ? normalSum / compared : 0.0;
+    double outlierFraction = pixels > 0 ? static_cast<double>(outliers) / pixels : 0.0;
+    bool passed = depthMean <= FP16_MAX_MEAN_DEPTH_ERROR && normalMean <= FP16_MAX_MEAN_NORMAL_ERROR &&
+                  outlierFraction <= FP16_MAX_OUTLIER_FRACTION;
+
+    report.config["fp16Check"] = passed ? "pass" : "fail";
+    report.accuracy["depthMeanError"] = depthMean;
+    report.accuracy["depthMaxError"] = depthMax;
+    report.accuracy["normalMeanErrorDeg"] = normalMean;
+    report.accuracy["normalMaxErrorDeg"] = normalMax;
+    report.accuracy["outlierFraction"] = outlierFraction;
+    report.accuracy["depthMeanBound"] = FP16_MAX_MEAN_DEPTH_ERROR;
+    report.accuracy["normalMeanBoundDeg"] = FP16_MAX_MEAN_NORMAL_ERROR;
+    report.accuracy["outlierFractionBound"] = FP16_MAX_OUTLIER_FRACTION;
+
+    std::printf("FP16 vs FP32 over %u views: depth error mean %.5f max %.5f (relative), normal error mean %.3f max %.3f deg, "
+                "outliers %.3f%%\n%s\n",
+                FP16_CHECK_SCENES * static_cast<uint32_t>(std::size(FP16_CHECK_VIEW_TIMES)), depthMean, depthMax,
+                normalMean, normalMax, outlierFraction * 100.0, passed ? "FP16 check passed" : "FP16 check FAILED");
+    return passed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        BenchOptions options;
+        std::vector<std::string> compareFiles;
+        double threshold = 5.0;
+
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            auto count = [&]() { return static_cast<uint32_t>(std::max(0, std::atoi(argv[++i]))); };
+
+            if (arg == "--size" && hasValue) {
+                if (std::sscanf(argv[++i], "%ux%u", &options.width, &options.height) != 2 ||
+                    options.width == 0 || options.height == 0) {
+                    throw std::runtime_error("--size expects WIDTHxHEIGHT");
+                }
+            } else if (arg == "--frames" && hasValue) {
+                options.frames = std::max(1u, count());
+            } else if (arg == "--warmup" && hasValue) {
+                options.warmupFrames = count();
+            } else if (arg == "--seed" && hasValue) {
+                options.scene.seed = count();
+            } else if (arg == "--edits" && hasValue) {
+                options.scene.editCount = count();
+            } else if (arg == "--strokes" && hasValue) {
+                options.scene.strokeCount = count();
+            } else if (arg == "--quality" && hasValue) {
+                options.quality = argv[++i];
+            } else if (arg == "--frames-in-flight" && hasValue) {
+                options.framesInFlight = count();
+            } else if (arg == "--record-threads" && hasValue) {
+                options.recordThreads = std::max(1u, count());
+            } else if (arg == "--stage-edits" && hasValue) {
+                std::string value = argv[++i];
+                if (value != "on" && value != "off") {
+                    throw std::runtime_error("--stage-edits expects on or off");
+                }
+                options.stageEdits = value == "on";
+            } else if (arg == "--fp16-check") {
+                options.fp16Check = true;
+            } else if (arg == "--output" && hasValue) {
+                options.output = argv[++i];
+            } else if (arg == "--capture" && hasValue) {
+                options.capture = argv[++i];
+            } else if (arg == "--compare" && i + 2 < argc) {
+                compareFiles = { argv[i + 1], argv[i + 2] };
+                i += 2;
+            } else if (arg == "--threshold" && hasValue) {
+                threshold = std::atof(argv[++i]);
+            } else {
+                std::cerr << USAGE;
+                return EXIT_FAILURE;
+            }
+        }
+
+        if (!compareFiles.empty()) {
+            engine::bench::Report base, current;
+            std::string error;
+            if (!engine::bench::readReport(compareFiles[0], base, error) ||
+                !engine::bench::readReport(compareFiles[1], current, error)) {
+                std::cerr << error << std::endl;
+                return EXIT_FAILURE;
+            }
+            return engine::bench::compareReports(base, current, threshold) ? EXIT_SUCCESS : 2;
+        }
+
+        engine::renderer::QualityPreset quality;
+        if (!parseQuality(options.quality, quality)) {
+            throw std::runtime_error("Unknown quality preset: " + options.quality);
+        }
+
+        if (options.fp16Check) {
+            engine::bench::Report report;
+            bool passed = runFp16Check(options, quality, report);
+            if (!engine::bench::writeReport(options.output, report)) {
+                std::cerr << "Failed to write " << options.output << std::endl;
+                return EXIT_FAILURE;
+            }
+            return passed ? EXIT_SUCCESS : 2;
+        }
+
+        auto report = runBenchmark(options, quality);
+        if (!engine::bench::writeReport(options.output, report)) {
+            std::cerr << "Failed to write " << options.output << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const auto& frame = report.cpu["Frame"];
+        std::printf("%s: %zu frames, frame mean %.3f ms, p95 %.3f ms, p99 %.3f ms\n",
+                    options.output.c_str(), frame.samples, frame.mean, frame.p95, frame.p99);
+        auto gpuFrame = report.gpu.find("Frame");
+        if (gpuFrame != report.gpu.end()) {
+            std::printf("GPU frame mean %.3f ms, p95 %.3f ms\n", gpuFrame->second.mean, gpuFrame->second.p95);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
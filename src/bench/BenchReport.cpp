@@ -0,0 +1,282 @@
+#include "BenchReport.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+namespace engine::bench {
+
+namespace {
+
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+    }
+    return escaped;
+}
+
+void writeSummaries(std::ostream& out, const std::map<std::string, Summary>& summaries) {
+    out << "{";
+    bool first = true;
+    for (const auto& [name, summary] : summaries) {
+        out << (first ? "\n" : ",\n") << "    \"" << escapeJson(name) << "\": {"
+            << "\"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+            << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99
+            << ", \"min\": " << summary.min << ", \"max\": " << summary.max
+            << ", \"samples\": " << summary.samples << "}";
+        first = false;
+    }
+    out << "\n  }";
+}
+
+// Just enough JSON for reading reports back: objects, strings and numbers
+struct JsonValue {
+    enum class Type { Object, String, Number } type = Type::Number;
+    std::vector<std::pair<std::string, JsonValue>> members;
+    std::string string;
+    double number = 0.0;
+
+    const JsonValue* find(const std::string& key) const {
+        for (const auto& [name, value] : members) {
+            if (name == key) return &value;
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text(text) {}
+
+    bool parse(JsonValue& value, std::string& error) {
+        if (!parseValue(value) || (skipWhitespace(), pos != text.size())) {
+            error = "invalid JSON at offset " + std::to_string(pos);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const std::string& text;
+    size_t pos = 0;
+
+    void skipWhitespace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(std::string& out) {
+        if (!consume('"')) return false;
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\' && pos + 1 < text.size()) pos++;
+            out += text[pos++];
+        }
+        return consume('"');
+    }
+
+    bool parseValue(JsonValue& value) {
+        skipWhitespace();
+        if (pos >= text.size()) return false;
+
+        if (text[pos] == '{') {
+            pos++;
+            value.type = JsonValue::Type::Object;
+            if (consume('}')) return true;
+            do {
+                std::string key;
+                JsonValue member;
+                if (!parseString(key) || !consume(':') || !parseValue(member)) return false;
+                value.members.emplace_back(std::move(key), std::move(member));
+            } while (consume(','));
+            return consume('}');
+        }
+        if (text[pos] == '"') {
+            value.type = JsonValue::Type::String;
+            return parseString(value.string);
+        }
+
+        const char* start = text.c_str() + pos;
+        char* end = nullptr;
+        value.type = JsonValue::Type::Number;
+        value.number = std::strtod(start, &end);
+        if (end == start) return false;
+        pos += static_cast<size_t>(end - start);
+        return true;
+    }
+};
+
+bool readSummaries(const JsonValue* section, std::map<std::string, Summary>& summaries) {
+    if (!section || section->type != JsonValue::Type::Object) return false;
+    for (const auto& [name, value] : section->members) {
+        auto number = [&value](const char* key) {
+            const JsonValue* field = value.find(key);
+            return field && field->type == JsonValue::Type::Number ? field->number : 0.0;
+        };
+        Summary summary;
+        summary.mean = number("mean");
+        summary.p50 = number("p50");
+        summary.p95 = number("p95");
+        summary.p99 = number("p99");
+        summary.min = number("min");
+        summary.max = number("max");
+        summary.samples = static_cast<size_t>(number("samples"));
+        summaries[name] = summary;
+    }
+    return true;
+}
+
+double percentChange(double base, double current) {
+    return base > 0.0 ? (current - base) / base * 100.0 : 0.0;
+}
+
+} // namespace
+
+Summary summarize(std::vector<double> samples) {
+    Summary summary;
+    if (samples.empty()) return summary;
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+
+    double total = 0.0;
+    for (double sample : samples) total += sample;
+
+    summary.mean = total / samples.size();
+    summary.p50 = percentile(50.0);
+    summary.p95 = percentile(95.0);
+    summary.p99 = percentile(99.0);
+    summary.min = samples.front();
+    summary.max = samples.back();
+    summary.samples = samples.size();
+    return summary;
+}
+
+bool writeReport(const std::string& path, const Report& report) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    file << "{\n  \"config\": {";
+    bool first = true;
+    for (const auto& [key, value] : report.config) {
+        file << (first ? "\n" : ",\n") << "    \"" << escapeJson(key) << "\": \"" << escapeJson(value) << "\"";
+        first = false;
+    }
+    file << "\n  },\n  \"cpu\": ";
+    writeSummaries(file, report.cpu);
+    file << ",\n  \"gpu\": ";
+    writeSummaries(file, report.gpu);
+    if (!report.accuracy.empty()) {
+        file << ",\n  \"accuracy\": {";
+        first = true;
+        for (const auto& [key, value] : report.accuracy) {
+            file << (first ? "\n" : ",\n") << "    \"" << escapeJson(key) << "\": " << value;
+            first = false;
+        }
+        file << "\n  }";
+    }
+    file << "\n}\n";
+    return static_cast<bool>(file);
+}
+
+bool readReport(const std::string& path, Report& report, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    JsonValue root;
+    JsonParser parser(text);
+    if (!parser.parse(root, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+
+    const JsonValue* config = root.find("config");
+    if (config && config->type == JsonValue::Type::Object) {
+        for (const auto& [key, value] : config->members) {
+            report.config[key] = value.string;
+        }
+    }
+    const JsonValue* accuracy = root.find("accuracy");
+    if (accuracy && accuracy->type == JsonValue::Type::Object) {
+        for (const auto& [key, value] : accuracy->members) {
+            report.accuracy[key] = value.number;
+        }
+    }
+    if (!readSummaries(root.find("cpu"), report.cpu) || !readSummaries(root.find("gpu"), report.gpu)) {
+        error = path + ": missing \"cpu\" or \"gpu\" section";
+        return false;
+    }
+    return true;
+}
+
+bool compareReports(const Report& base, const Report& current, double thresholdPercent) {
+    // Numbers from different settings or devices are not comparable; say so but still print them
+    std::set<std::string> keys;
+    for (const auto& [key, value] : base.config) keys.insert(key);
+    for (const auto& [key, value] : current.config) keys.insert(key);
+    for (const auto& key : keys) {
+        auto a = base.config.find(key);
+        auto b = current.config.find(key);
+        std::string before = a != base.config.end() ? a->second : "-";
+        std::string after = b != current.config.end() ? b->second : "-";
+        if (before != after) {
+            std::cout << "warning: " << key << " differs (" << before << " vs " << after << ")" << std::endl;
+        }
+    }
+
+    bool passed = true;
+    auto compareSection = [&](const char* section, const std::map<std::string, Summary>& before,
+                              const std::map<std::string, Summary>& after) {
+        std::set<std::string> names;
+        for (const auto& [name, summary] : before) names.insert(name);
+        for (const auto& [name, summary] : after) names.insert(name);
+
+        std::printf("\n%-4s %-28s %10s %10s %8s %10s %10s %8s\n", section, "timing (ms)",
+                    "base mean", "mean", "delta", "base p95", "p95", "delta");
+        for (const auto& name : names) {
+            auto a = before.find(name);
+            auto b = after.find(name);
+            if (a == before.end() || b == after.end()) {
+                std::printf("     %-28s %s\n", name.c_str(), a == before.end() ? "(new)" : "(removed)");
+                continue;
+            }
+            double meanDelta = percentChange(a->second.mean, b->second.mean);
+            double p95Delta = percentChange(a->second.p95, b->second.p95);
+            bool regressed = meanDelta > thresholdPercent;
+            passed = passed && !regressed;
+            std::printf("     %-28s %10.3f %10.3f %+7.1f%% %10.3f %10.3f %+7.1f%%%s\n", name.c_str(),
+                        a->second.mean, b->second.mean, meanDelta,
+                        a->second.p95, b->second.p95, p95Delta, regressed ? "  REGRESSED" : "");
+        }
+    };
+    compareSection("CPU", base.cpu, current.cpu);
+    compareSection("GPU", base.gpu, current.gpu);
+
+    std::printf("\n%s (threshold %.1f%% on the mean)\n", passed ? "No regressions" : "Regressions found", thresholdPercent);
+    return passed;
+}
+
+} // namespace engine::bench
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace engine::bench {
+
+// Milliseconds
+struct Summary {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    size_t samples = 0;
+};
+
+// Nearest-rank percentiles
+Summary summarize(std::vector<double> samples);
+
+struct Report {
+    std::map<std::string, std::string> config; // Run settings and device, for telling runs apart
+    std::map<std::string, Summary> cpu;        // Frame timings measured on the host
+    std::map<std::string, Summary> gpu;        // Per render graph pass, from timestamps
+    std::map<std::string, double> accuracy;    // Error measurements (EngineBench --fp16-check)
+};
+
+bool writeReport(const std::string& path, const Report& report);
+// Reads a file written by writeReport
+bool readReport(const std::string& path, Report& report, std::string& error);
+
+// Prints mean and p95 per timing, current against base. Returns true when no mean
+// regressed by more than thresholdPercent.
+bool compareReports(const Report& base, const Report& current, double thresholdPercent);
+
+} // namespace engine::bench
@@ -0,0 +1,112 @@
+#include "BenchScene.hpp"
+#include "core/SDFEdit.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace engine::bench {
+
+namespace {
+
+const glm::vec3 SCENE_CENTER(0.0f, 1.0f, 6.0f);
+constexpr float SCENE_RADIUS = 7.0f;
+
+// Terrain UV of a world position (the terrain spans -128..128 on x and z)
+glm::vec2 worldToTerrainUV(float x, float z) {
+    return glm::vec2((x + 128.0f) / 256.0f, (z + 128.0f) / 256.0f);
+}
+
+} // namespace
+
+void buildScene(renderer::SDFRenderer& renderer, const SceneParams& params) {
+    BenchRandom random(params.seed);
+
+    auto& edits = renderer.getEdits();
+    edits.clear();
+
+    uint32_t count = std::min<uint32_t>(params.editCount, 256);
+    for (uint32_t i = 0; i < count; i++) {
+        core::SDFEdit edit{};
+
+        float angle = random.range(0.0f, 6.2831853f);
+        float distance = SCENE_RADIUS * std::sqrt(random.next());
+        edit.position = glm::vec3(
+            SCENE_CENTER.x + std::cos(angle) * distance,
+            random.range(0.3f, 2.5f),
+            SCENE_CENTER.z + std::sin(angle) * distance
+        );
+
+        // Random unit quaternion (uniform over rotations)
+        float u1 = random.next(), u2 = random.range(0.0f, 6.2831853f), u3 = random.range(0.0f, 6.2831853f);
+        float a = std::sqrt(1.0f - u1), b = std::sqrt(u1);
+        edit.rotation = glm::vec4(a * std::sin(u2), a * std::cos(u2), b * std::sin(u3), b * std::cos(u3));
+
+        edit.primitiveType = random.index(5); // Sphere, box, torus, capsule, cylinder
+        float size = random.range(0.3f, 1.0f);
+        edit.scale = glm::vec3(size, size * random.range(0.3f, 1.0f), size);
+
+        // Mostly additive; intersections are left out since one would clip every edit before it
+        float op = random.next();
+        if (op < 0.55f) {
+            edit.operation = static_cast<uint32_t>(core::SDFOp::Union);
+        } else if (op < 0.8f) {
+            edit.operation = static_cast<uint32_t>(core::SDFOp::SmoothUnion);
+        } else if (op < 0.9f) {
+            edit.operation = static_cast<uint32_t>(core::SDFOp::Subtraction);
+        } else {
+            edit.operation = static_cast<uint32_t>(core::SDFOp::SmoothSub);
+        }
+        edit.blendFactor = random.range(0.1f, 0.5f);
+
+        edit.material.albedo = glm::vec3(random.next(), random.next(), random.next());
+        edit.material.roughness = random.range(0.1f, 0.9f);
+        edit.material.metallic = random.next() < 0.3f ? 1.0f : 0.0f;
+        edits.push_back(edit);
+    }
+
+    renderer.markEditsDirty();
+}
+
+std::vector<renderer::Terrain::BrushParams> buildBrushStrokes(const SceneParams& params) {
+    // Separate stream, so changing the edit count leaves the strokes alone
+    BenchRandom random(params.seed ^ 0x9E3779B9u);
+
+    std::vector<renderer::Terrain::BrushParams> stamps;
+    stamps.reserve(static_cast<size_t>(params.strokeCount) * STAMPS_PER_STROKE);
+    for (uint32_t stroke = 0; stroke < params.strokeCount; stroke++) {
+        float angle = random.range(0.0f, 6.2831853f);
+        float distance = random.range(0.0f, 2.0f * SCENE_RADIUS);
+        glm::vec2 start = worldToTerrainUV(SCENE_CENTER.x + std::cos(angle) * distance,
+                                           SCENE_CENTER.z + std::sin(angle) * distance);
+        float heading = random.range(0.0f, 6.2831853f);
+        glm::vec2 step = glm::vec2(std::cos(heading), std::sin(heading)) * (random.range(2.0f, 8.0f) / 256.0f / STAMPS_PER_STROKE);
+
+        renderer::Terrain::BrushParams stamp{};
+        stamp.radius = random.range(1.5f, 6.0f) / 256.0f;
+        stamp.strength = random.range(0.2f, 1.0f) * 0.01f;
+        const uint32_t modes[] = { 0, 1, 3 }; // Raise, lower, smooth
+        stamp.mode = modes[random.index(3)];
+
+        for (uint32_t i = 0; i < STAMPS_PER_STROKE; i++) {
+            stamp.pos = start + step * static_cast<float>(i);
+            stamps.push_back(stamp);
+        }
+    }
+    return stamps;
+}
+
+CameraPose cameraPath(float time) {
+    // One revolution every 20 seconds, bobbing in height so near and far views both occur
+    float angle = time * (6.2831853f / 20.0f);
+    float orbitRadius = 11.0f + 3.0f * std::sin(time * 0.7f);
+    glm::vec3 position(
+        SCENE_CENTER.x + std::sin(angle) * orbitRadius,
+        2.5f + 1.5f * std::sin(time * 0.45f),
+        SCENE_CENTER.z - std::cos(angle) * orbitRadius
+    );
+
+    // Inverse of the direction the renderer builds from yaw/pitch
+    glm::vec3 toCenter = glm::normalize(SCENE_CENTER - position);
+    return { position, std::atan2(toCenter.x, toCenter.z), std::asin(toCenter.y) };
+}
+
+} // namespace engine::bench
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "renderer/SDFRenderer.hpp"
+#include "renderer/Terrain.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace engine::bench {
+
+struct SceneParams {
+    uint32_t seed = 1;
+    uint32_t editCount = 64;   // Capped by the renderer's edit buffer (256)
+    uint32_t strokeCount = 8;  // Terrain brush strokes, STAMPS_PER_STROKE stamps each
+};
+
+static constexpr uint32_t STAMPS_PER_STROKE = 16;
+
+// std distributions differ between standard libraries; only the mt19937 sequence
+// itself is specified, so scenes are derived from its raw output
+class BenchRandom {
+public:
+    explicit BenchRandom(uint32_t seed) : engine(seed) {}
+
+    float next() { return static_cast<float>(engine() >> 8) * (1.0f / 16777216.0f); } // [0, 1)
+    float range(float lo, float hi) { return lo + (hi - lo) * next(); }
+    uint32_t index(uint32_t count) { return static_cast<uint32_t>(next() * count); }
+
+private:
+    std::mt19937 engine;
+};
+
+// Replaces the renderer's edits with seeded primitives and operations around the origin
+void buildScene(renderer::SDFRenderer& renderer, const SceneParams& params);
+
+// Brush stamps of every stroke in application order; the benchmark queues one per frame
+std::vector<renderer::Terrain::BrushParams> buildBrushStrokes(const SceneParams& params);
+
+struct CameraPose {
+    glm::vec3 position;
+    float yaw, pitch;
+};
+
+// Fixed orbit around the scene, sampled at a time in seconds
+CameraPose cameraPath(float time);
+
+} // namespace engine::bench
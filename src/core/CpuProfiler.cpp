@@ -0,0 +1,97 @@
+#include "CpuProfiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine::core {
+
+namespace {
+
+const auto profilerEpoch = std::chrono::steady_clock::now();
+
+struct ThreadRing {
+    std::atomic<uint64_t> head{ 0 }; // Total events written; slot = index % capacity
+    CpuProfiler::Event events[CpuProfiler::RING_CAPACITY];
+    std::atomic<const char*> name{ nullptr };
+    uint32_t id = 0;
+};
+
+// Rings are never freed: a dump may run after a worker thread exits
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadRing>>& registry() {
+    static std::vector<std::unique_ptr<ThreadRing>> rings;
+    return rings;
+}
+
+ThreadRing& localRing() {
+    thread_local ThreadRing* ring = [] {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto& rings = registry();
+        rings.push_back(std::make_unique<ThreadRing>());
+        rings.back()->id = static_cast<uint32_t>(rings.size());
+        return rings.back().get();
+    }();
+    return *ring;
+}
+
+} // namespace
+
+double CpuProfiler::nowUs() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - profilerEpoch).count();
+}
+
+void CpuProfiler::record(const char* name, double startUs, double endUs) {
+    ThreadRing& ring = localRing();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head & (RING_CAPACITY - 1)] = { name, startUs, endUs };
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void CpuProfiler::setThreadName(const char* name, bool onlyIfUnnamed) {
+    ThreadRing& ring = localRing();
+    if (onlyIfUnnamed && ring.name.load(std::memory_order_relaxed)) return;
+    ring.name.store(name, std::memory_order_relaxed);
+}
+
+bool CpuProfiler::exportChromeTrace(const std::string& path, const std::function<void(std::ostream&)>& appendEvents) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}}";
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<Event> events;
+    for (const auto& ring : registry()) {
+        // Copy, then drop whatever the owner may have overwritten during the copy
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t count = std::min<uint64_t>(head, RING_CAPACITY);
+        events.resize(count);
+        for (uint64_t i = 0; i < count; i++) {
+            events[i] = ring->events[(head - count + i) & (RING_CAPACITY - 1)];
+        }
+        uint64_t headAfter = ring->head.load(std::memory_order_acquire);
+        uint64_t overwritten = std::min<uint64_t>(headAfter - head, count);
+
+        const char* name = ring->name.load(std::memory_order_relaxed);
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << ring->id
+             << ",\"args\":{\"name\":\"" << (name ? name : "Thread") << " " << ring->id << "\"}}";
+
+        for (uint64_t i = overwritten; i < count; i++) {
+            const Event& event = events[i];
+            file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << ring->id
+                 << ",\"ts\":" << event.startUs << ",\"dur\":" << event.endUs - event.startUs << "}";
+        }
+    }
+
+    if (appendEvents) {
+        appendEvents(file);
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
+
+} // namespace engine::core
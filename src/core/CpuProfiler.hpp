@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+// Scoped CPU zones. Compiled out entirely unless ENGINE_PROFILE is defined
+// (CMake option ENGINE_ENABLE_PROFILING). Names must outlive the program,
+// e.g. string literals.
+#ifdef ENGINE_PROFILE
+#define ENGINE_PROFILE_CONCAT_INNER(a, b) a##b
+#define ENGINE_PROFILE_CONCAT(a, b) ENGINE_PROFILE_CONCAT_INNER(a, b)
+#define ENGINE_PROFILE_ZONE(name) ::engine::core::ProfileZone ENGINE_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define ENGINE_PROFILE_THREAD(name) ::engine::core::CpuProfiler::setThreadName(name)
+#else
+#define ENGINE_PROFILE_ZONE(name) ((void)0)
+#define ENGINE_PROFILE_THREAD(name) ((void)0)
+#endif
+
+namespace engine::core {
+
+// Each thread appends finished zones to its own ring buffer; only that thread
+// writes it, so recording takes no locks. A dump copies every ring and keeps the
+// entries that were not overwritten while it was copying.
+class CpuProfiler {
+public:
+    struct Event {
+        const char* name;
+        double startUs;
+        double endUs;
+    };
+
+    // Microseconds since startup; shared with the GPU profiler so both land on one timeline
+    static double nowUs();
+
+    static void record(const char* name, double startUs, double endUs);
+    // Names the calling thread's track; onlyIfUnnamed keeps an earlier explicit name
+    static void setThreadName(const char* name, bool onlyIfUnnamed = false);
+
+    // Writes every thread's zones as Chrome trace JSON. appendEvents may add further
+    // events (e.g. GPU timings); each must be written with a leading ",\n".
+    static bool exportChromeTrace(const std::string& path, const std::function<void(std::ostream&)>& appendEvents = {});
+
+    static constexpr uint32_t RING_CAPACITY = 1u << 15; // Per thread, power of two
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), startUs(CpuProfiler::nowUs()) {}
+    ~ProfileZone() { CpuProfiler::record(name, startUs, CpuProfiler::nowUs()); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    double startUs;
+};
+
+} // namespace engine::core
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace engine::core {
+
+// Writers for captured frames: 8-bit RGBA pixels, rows top to bottom, tightly packed.
+// No image library is needed: PNG output uses uncompressed (stored) deflate blocks.
+namespace ImageWriter {
+
+// Binary P6; alpha is dropped
+bool writePPM(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba);
+bool writePNG(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba);
+// The pixel bytes as-is, with no header
+bool writeRaw(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba);
+
+// Picks the format from the extension (.ppm, .png); anything else is written raw
+bool write(const std::string& path, uint32_t width, uint32_t height, const uint8_t* rgba);
+
+} // namespace ImageWriter
+
+} // namespace engine::core
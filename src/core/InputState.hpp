@@ -15,9 +15,11 @@ struct InputState {
 
     // Keyboard
     std::array<bool, 512> keys{};
+    std::array<bool, 512> keysPressed{}; // True for one frame on press
     
     // Frame helpers
     bool isKeyDown(int key) const { return key >= 0 && key < 512 && keys[key]; }
+    bool isKeyPressed(int key) const { return key >= 0 && key < 512 && keysPressed[key]; }
     bool isMouseDown(int button) const { return button >= 0 && button < 3 && mouseButtons[button]; }
     
     void resetDeltas() {
@@ -27,6 +29,7 @@ struct InputState {
         mouseClicked[0] = false;
         mouseClicked[1] = false;
         mouseClicked[2] = false;
+        keysPressed.fill(false);
     }
 };
 
@@ -0,0 +1,34 @@
+#include "LatencyTracker.hpp"
+
+namespace engine::core {
+
+void LatencyTracker::submitted(uint64_t id, double timeUs) {
+    if (inputUs <= 0.0) return;
+    pending.push_back({ id, inputUs, timeUs });
+    inputUs = 0.0;
+}
+
+void LatencyTracker::completed(uint64_t id, double timeUs) {
+    while (!pending.empty() && pending.front().id <= id) {
+        const Pending& frame = pending.front();
+        history.push_back({ (frame.submitUs - frame.inputUs) / 1000.0, (timeUs - frame.inputUs) / 1000.0 });
+        if (history.size() > HISTORY_FRAMES) {
+            history.pop_front();
+        }
+        pending.pop_front();
+    }
+}
+
+LatencyTracker::Sample LatencyTracker::getAverage() const {
+    Sample average{ 0.0, 0.0 };
+    if (history.empty()) return average;
+    for (const Sample& sample : history) {
+        average.submitMs += sample.submitMs;
+        average.completeMs += sample.completeMs;
+    }
+    average.submitMs /= static_cast<double>(history.size());
+    average.completeMs /= static_cast<double>(history.size());
+    return average;
+}
+
+} // namespace engine::core
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace engine::core {
+
+// Input-to-present latency of recent frames. The time input was sampled is attached to
+// the next submitted frame and closed once that frame is known to be complete: on screen
+// when VK_KHR_present_wait is available, otherwise finished on the GPU. Times are on
+// CpuProfiler::nowUs(). Main thread only.
+class LatencyTracker {
+public:
+    struct Sample {
+        double submitMs;   // Input sample to queue submission (CPU part)
+        double completeMs; // Input sample to present or GPU completion
+    };
+
+    // Input for the next submitted frame was polled at timeUs
+    void sampleInput(double timeUs) { inputUs = timeUs; }
+    // Frame id was submitted at timeUs; frames without an input sample are not tracked
+    void submitted(uint64_t id, double timeUs);
+    // Every frame up to and including id was complete by timeUs
+    void completed(uint64_t id, double timeUs);
+    // Oldest frame still waiting for completed(), or 0 when none is
+    uint64_t oldestPending() const { return pending.empty() ? 0 : pending.front().id; }
+
+    // Oldest first, up to HISTORY_FRAMES
+    const std::deque<Sample>& getHistory() const { return history; }
+    // Mean of the history; zeros while it is empty
+    Sample getAverage() const;
+
+    static constexpr size_t HISTORY_FRAMES = 240;
+
+private:
+    struct Pending {
+        uint64_t id;
+        double inputUs;
+        double submitUs;
+    };
+
+    double inputUs = 0.0;
+    std::deque<Pending> pending;
+    std::deque<Sample> history;
+};
+
+} // namespace engine::core
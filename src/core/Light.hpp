@@ -0,0 +1,15 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace engine::core {
+
+// GPU layout must match PointLightGPU in shaders/common/SDFScene.glsl
+struct PointLight {
+    glm::vec3 position;
+    float radius;    // Influence ends here; falloff is windowed to reach zero at the radius
+    glm::vec3 color;
+    float intensity;
+};
+
+} // namespace engine::core
@@ -1,6 +1,26 @@
 #include "PhysicsSystem.hpp"
+#include "CpuProfiler.hpp"
 #include <Jolt/Core/Memory.h>
 #include <iostream>
+#include <new>
+
+#ifdef JPH_EXTERNAL_PROFILE
+// ENGINE_ENABLE_PROFILING builds Jolt with JPH_EXTERNAL_PROFILE, so its JPH_PROFILE scopes,
+// including the one around every job, land here and become CPU zones
+static_assert(sizeof(engine::core::ProfileZone) <= 64, "ProfileZone must fit ExternalProfileMeasurement::mUserData");
+
+JPH_NAMESPACE_BEGIN
+
+ExternalProfileMeasurement::ExternalProfileMeasurement(const char* inName, uint32) {
+    new (mUserData) engine::core::ProfileZone(inName);
+}
+
+ExternalProfileMeasurement::~ExternalProfileMeasurement() {
+    reinterpret_cast<engine::core::ProfileZone*>(mUserData)->~ProfileZone();
+}
+
+JPH_NAMESPACE_END
+#endif
 
 namespace engine::core {
 
@@ -21,7 +41,10 @@ PhysicsSystem::PhysicsSystem() {
     temp_allocator = std::make_unique<JPH::TempAllocatorImpl>(10 * 1024 * 1024);
     
     int num_threads = std::max(1, (int)JPH::thread::hardware_concurrency() - 1);
-    job_system = std::make_unique<JPH::JobSystemThreadPool>(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
+    job_system = std::make_unique<JPH::JobSystemThreadPool>();
+    // Must be set before Init starts the workers
+    job_system->SetThreadInitFunction([](int) { ENGINE_PROFILE_THREAD("Jolt Worker"); });
+    job_system->Init(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, num_threads);
 
     std::cout << "Physics: Initializing PhysicsSystem..." << std::endl;
     physics_system = std::make_unique<JPH::PhysicsSystem>();
@@ -40,6 +63,7 @@ PhysicsSystem::~PhysicsSystem() {
 }
 
 void PhysicsSystem::update(float deltaTime) {
+    ENGINE_PROFILE_ZONE("Physics Update");
     physics_system->Update(deltaTime, 1, temp_allocator.get(), job_system.get());
 }
 
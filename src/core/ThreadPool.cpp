@@ -0,0 +1,84 @@
+#include "ThreadPool.hpp"
+#include "CpuProfiler.hpp"
+
+namespace engine::core {
+
+ThreadPool::ThreadPool(uint32_t workerCount, const char* name) : name(name) {
+    workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(uint32_t count, const Job& fn) {
+    if (count == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        jobCount = count;
+        nextJob = 0;
+        busyWorkers = static_cast<uint32_t>(workers.size());
+        error = nullptr;
+        batch++;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        job = nullptr;
+        failure = error;
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void ThreadPool::workerLoop(uint32_t thread) {
+    ENGINE_PROFILE_THREAD(name);
+    uint64_t seenBatch = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seenBatch] { return stopping || batch != seenBatch; });
+            if (stopping) return;
+            seenBatch = batch;
+        }
+
+        drain(thread);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::drain(uint32_t thread) {
+    // Workers that wake late find the counter past the end and go straight back to sleep
+    for (uint32_t index = nextJob++; index < jobCount; index = nextJob++) {
+        try {
+            (*job)(index, thread);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+    }
+}
+
+} // namespace engine::core
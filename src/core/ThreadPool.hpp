@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine::core {
+
+// Fixed set of worker threads for fork-join work on the frame's critical path. run()
+// spreads a batch of jobs over the workers and the calling thread and returns once every
+// job has finished. Used from one thread at a time; run() is not reentrant.
+class ThreadPool {
+public:
+    using Job = std::function<void(uint32_t index, uint32_t thread)>;
+
+    // workerCount threads besides the caller; 0 runs every job on the caller.
+    // name labels the workers in CPU profiles and must outlive the pool.
+    ThreadPool(uint32_t workerCount, const char* name);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Calls job(index, thread) for every index below count. thread is 0 on the caller and
+    // 1..workerCount on the workers, so per-thread resources can be indexed by it. The first
+    // exception a job throws is rethrown here after the batch completes.
+    void run(uint32_t count, const Job& job);
+
+    // Callers plus workers
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+private:
+    const char* name;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const Job* job = nullptr;
+    uint32_t jobCount = 0;
+    std::atomic<uint32_t> nextJob{ 0 };
+    uint32_t busyWorkers = 0;
+    uint64_t batch = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    void workerLoop(uint32_t thread);
+    void drain(uint32_t thread);
+};
+
+} // namespace engine::core
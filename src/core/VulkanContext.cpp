@@ -7,13 +7,66 @@
 
 #define VULKAN_HPP_DISPATCH_LOADER_DYNAMIC 1
 #include "VulkanContext.hpp"
+#include "CpuProfiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
+#include <thread>
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
 namespace engine::core {
 
+namespace {
+
+// Prepended to the driver's cache blob. The driver checks its own header as well, but
+// driverUUID also changes on driver updates that keep pipelineCacheUUID, and the
+// checksum catches truncated or corrupted files before the driver parses them.
+struct PipelineCacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t driverUUID[VK_UUID_SIZE];
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t checksum; // FNV-1a of the data
+};
+
+constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43504453; // "SDPC"
+constexpr uint32_t PIPELINE_CACHE_VERSION = 1;
+
+uint64_t fnv1a(const uint8_t* data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+PipelineCacheFileHeader describeDevice(vk::PhysicalDevice physicalDevice) {
+    auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+    const auto& core = properties.get<vk::PhysicalDeviceProperties2>().properties;
+    const auto& ids = properties.get<vk::PhysicalDeviceIDProperties>();
+
+    PipelineCacheFileHeader header{};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.vendorID = core.vendorID;
+    header.deviceID = core.deviceID;
+    header.driverVersion = core.driverVersion;
+    std::memcpy(header.driverUUID, ids.driverUUID.data(), VK_UUID_SIZE);
+    std::memcpy(header.pipelineCacheUUID, core.pipelineCacheUUID.data(), VK_UUID_SIZE);
+    return header;
+}
+
+} // namespace
+
 const std::vector<const char*> validationLayers = {
     "VK_LAYER_KHRONOS_validation"
 };
@@ -24,12 +77,26 @@ const bool enableValidationLayers = false;
 const bool enableValidationLayers = true;
 #endif
 
-VulkanContext::VulkanContext(Window& window) : window(window) {
+VulkanContext::VulkanContext(Window& window, uint32_t framesInFlight, vk::PresentModeKHR presentMode)
+    : window(&window), framesInFlight(std::clamp(framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT)) {
+    int width, height;
+    window.getFramebufferSize(width, height);
+    initialize(reinterpret_cast<PFN_vkGetInstanceProcAddr>(glfwGetInstanceProcAddress(nullptr, "vkGetInstanceProcAddr")),
+               static_cast<uint32_t>(width), static_cast<uint32_t>(height), presentMode);
+}
+
+VulkanContext::VulkanContext(uint32_t width, uint32_t height, uint32_t framesInFlight)
+    : framesInFlight(std::clamp(framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT)) {
+    // GLFW is never initialized here, so take the entry point from the linked loader
+    initialize(vkGetInstanceProcAddr, width, height);
+}
+
+void VulkanContext::initialize(PFN_vkGetInstanceProcAddr getInstanceProcAddr, uint32_t width, uint32_t height,
+                               vk::PresentModeKHR presentMode) {
     // Initialize the default dynamic dispatcher
     static bool dispatcherInitialized = false;
     if (!dispatcherInitialized) {
-        auto vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(glfwGetInstanceProcAddress(nullptr, "vkGetInstanceProcAddr"));
-        VULKAN_HPP_DEFAULT_DISPATCHER.init(vkGetInstanceProcAddr);
+        VULKAN_HPP_DEFAULT_DISPATCHER.init(getInstanceProcAddr);
         dispatcherInitialized = true;
     }
 
@@ -37,16 +104,26 @@ VulkanContext::VulkanContext(Window& window) : window(window) {
     VULKAN_HPP_DEFAULT_DISPATCHER.init(instance.get());
 
     setupDebugMessenger();
-    createSurface();
+    if (window) {
+        createSurface();
+    }
     pickPhysicalDevice();
     createLogicalDevice();
     VULKAN_HPP_DEFAULT_DISPATCHER.init(device.get());
+    createPipelineCache();
+    shaderReload = std::make_unique<renderer::ShaderHotReload>(device.get(), pipelineCache.get(), framesInFlight);
+    bindlessHeap = std::make_unique<renderer::BindlessHeap>(device.get(), physicalDevice, framesInFlight);
 
-    int width, height;
-    window.getFramebufferSize(width, height);
-    swapChain = std::make_unique<renderer::Swapchain>(device.get(), physicalDevice, surface.get(), width, height);
+    if (window) {
+        swapChain = std::make_unique<renderer::Swapchain>(device.get(), physicalDevice, surface.get(), width, height, presentMode);
+    }
     
     resourceManager = std::make_unique<renderer::ResourceManager>(device.get(), physicalDevice);
+    transferManager = std::make_unique<renderer::TransferManager>(
+        device.get(), *resourceManager, transferQueue, transferFamily, queueFamilyIndex, framesInFlight);
+    if (!window) {
+        createOffscreenTarget(width, height);
+    }
     
     // Initial size: 64x64x64 bricks = 512x512x512 voxels
     brickAtlas = std::make_unique<renderer::BrickAtlas>(*resourceManager, 64, 64, 64);
@@ -54,12 +131,18 @@ VulkanContext::VulkanContext(Window& window) : window(window) {
     // Spatial index for a 128x128x128 grid
     sparseMap = std::make_unique<renderer::SparseMap>(*resourceManager, 128, 128, 128);
 
+    renderGraph = std::make_unique<renderer::RenderGraph>(device.get(), *resourceManager);
+    gpuProfiler = std::make_unique<renderer::GpuProfiler>(device.get(), physicalDevice, queueFamilyIndex, framesInFlight);
+    renderGraph->setProfiler(gpuProfiler.get());
+    setRecordingThreads(std::min(DEFAULT_RECORDING_THREADS, std::thread::hardware_concurrency() / 2));
+
     createCommandPool();
     createCommandBuffers();
     createSyncObjects();
 }
 
 VulkanContext::~VulkanContext() {
+    savePipelineCache();
     // Unique handles will cleanup automatically
 }
 
@@ -95,12 +178,108 @@ void VulkanContext::createInstance() {
 
 void VulkanContext::createSurface() {
     VkSurfaceKHR rawSurface;
-    if (glfwCreateWindowSurface(instance.get(), window.getGLFWwindow(), nullptr, &rawSurface) != VK_SUCCESS) {
+    if (glfwCreateWindowSurface(instance.get(), window->getGLFWwindow(), nullptr, &rawSurface) != VK_SUCCESS) {
         throw std::runtime_error("failed to create window surface!");
     }
     surface = vk::UniqueSurfaceKHR(rawSurface, instance.get());
 }
 
+void VulkanContext::createOffscreenTarget(uint32_t width, uint32_t height) {
+    offscreenExtent = vk::Extent2D{ width, height };
+
+    // Stands in for the swapchain: written by the lighting pass, the blit or the ImGui overlay
+    offscreenTarget = resourceManager->createImage(
+        width, height, 1,
+        OFFSCREEN_FORMAT,
+        vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferDst |
+        vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eColorAttachment,
+        vk::MemoryPropertyFlagBits::eDeviceLocal
+    );
+    offscreenViews = { offscreenTarget.view.get() };
+
+    captureBuffer = resourceManager->createBuffer(
+        static_cast<vk::DeviceSize>(width) * height * 4,
+        vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+    );
+    captureMapped = captureBuffer.memory.getMappedData();
+}
+
+void VulkanContext::createPipelineCache() {
+    PipelineCacheFileHeader expected = describeDevice(physicalDevice);
+    std::vector<uint8_t> data;
+    const char* rejected = nullptr;
+
+    std::ifstream file(PIPELINE_CACHE_PATH, std::ios::binary | std::ios::ate);
+    if (file) {
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+
+        PipelineCacheFileHeader header{};
+        if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            rejected = "truncated header";
+        } else if (header.magic != expected.magic || header.version != expected.version) {
+            rejected = "unknown format";
+        } else if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID) {
+            rejected = "different GPU";
+        } else if (header.driverVersion != expected.driverVersion ||
+                   std::memcmp(header.driverUUID, expected.driverUUID, VK_UUID_SIZE) != 0 ||
+                   std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            rejected = "driver changed";
+        } else if (header.dataSize != fileSize - sizeof(header)) {
+            rejected = "size mismatch";
+        } else {
+            data.resize(static_cast<size_t>(header.dataSize));
+            if (!file.read(reinterpret_cast<char*>(data.data()), data.size()) ||
+                fnv1a(data.data(), data.size()) != header.checksum) {
+                rejected = "checksum mismatch";
+                data.clear();
+            }
+        }
+    }
+
+    vk::PipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+    pipelineCache = device->createPipelineCacheUnique(cacheInfo);
+
+    if (!data.empty()) {
+        std::cout << "Pipeline cache: loaded " << data.size() / 1024 << " KiB from " << PIPELINE_CACHE_PATH << std::endl;
+    } else if (rejected) {
+        std::cout << "Pipeline cache: ignoring " << PIPELINE_CACHE_PATH << " (" << rejected << "), starting empty" << std::endl;
+    } else {
+        std::cout << "Pipeline cache: none on disk, starting empty" << std::endl;
+    }
+}
+
+void VulkanContext::savePipelineCache() {
+    if (!pipelineCache) return;
+
+    // Never let a failed write escape the destructor; the next launch just compiles again
+    try {
+        std::vector<uint8_t> data = device->getPipelineCacheData(pipelineCache.get());
+        PipelineCacheFileHeader header = describeDevice(physicalDevice);
+        header.dataSize = data.size();
+        header.checksum = fnv1a(data.data(), data.size());
+
+        // Write beside the old file and swap, so a crash mid-write leaves the previous cache intact
+        std::string tempPath = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+            if (!file) {
+                std::cerr << "Pipeline cache: failed to write " << tempPath << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH);
+    } catch (const std::exception& e) {
+        std::cerr << "Pipeline cache: failed to save (" << e.what() << ")" << std::endl;
+    }
+}
+
 void VulkanContext::pickPhysicalDevice() {
     auto devices = instance->enumeratePhysicalDevices();
     if (devices.empty()) {
@@ -123,23 +302,73 @@ void VulkanContext::createLogicalDevice() {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
     float queuePriority = 1.0f;
-    vk::DeviceQueueCreateInfo queueCreateInfo{};
-    queueCreateInfo.queueFamilyIndex = indices.graphicsFamily;
-    queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriority;
+    std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos;
+    for (uint32_t family : std::set<uint32_t>{ indices.graphicsFamily, indices.transferFamily }) {
+        queueCreateInfos.push_back(vk::DeviceQueueCreateInfo{ {}, family, 1, &queuePriority });
+    }
 
     vk::PhysicalDeviceFeatures deviceFeatures{};
     // Basic features for now, Vulkan 1.4 implies many features are core
-    
+
+    // Optional features the renderer can pick shader variants for
+    auto supported = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+    shaderFloat16Supported = supported.get<vk::PhysicalDeviceVulkan12Features>().shaderFloat16;
+
+    // Swapchain formats (BGRA8) have no GLSL format qualifier
+    storageWriteWithoutFormat = supported.get<vk::PhysicalDeviceFeatures2>().features.shaderStorageImageWriteWithoutFormat;
+    deviceFeatures.shaderStorageImageWriteWithoutFormat = storageWriteWithoutFormat;
+
+    vk::PhysicalDeviceVulkan12Features features12{};
+    features12.shaderFloat16 = shaderFloat16Supported;
+    // Required since 1.2; tracks upload completion
+    features12.timelineSemaphore = VK_TRUE;
+    // Required since 1.3; the bindless heap's partially bound, update-after-bind arrays
+    features12.descriptorIndexing = VK_TRUE;
+    features12.runtimeDescriptorArray = VK_TRUE;
+    features12.descriptorBindingPartiallyBound = VK_TRUE;
+    features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    features12.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+
+    // Present ids let the CPU wait for (and time) a frame reaching the screen
+    vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+    vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+    if (window) {
+        bool hasPresentId = false, hasPresentWait = false;
+        for (const auto& extension : physicalDevice.enumerateDeviceExtensionProperties()) {
+            hasPresentId = hasPresentId || strcmp(extension.extensionName, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0;
+            hasPresentWait = hasPresentWait || strcmp(extension.extensionName, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0;
+        }
+        if (hasPresentId && hasPresentWait) {
+            auto presentFeatures = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR,
+                                                               vk::PhysicalDevicePresentWaitFeaturesKHR>();
+            presentWaitSupported = presentFeatures.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+                                   presentFeatures.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+        }
+    }
+    if (presentWaitSupported) {
+        presentIdFeatures.presentId = VK_TRUE;
+        presentWaitFeatures.presentWait = VK_TRUE;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        features12.pNext = &presentIdFeatures;
+    }
+
     vk::DeviceCreateInfo createInfo{};
-    createInfo.pQueueCreateInfos = &queueCreateInfo;
-    createInfo.queueCreateInfoCount = 1;
+    createInfo.pNext = &features12;
+    createInfo.pQueueCreateInfos = queueCreateInfos.data();
+    createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    // Device extensions could go here (e.g. VK_KHR_SWAPCHAIN_EXTENSION_NAME)
-    std::vector<const char*> deviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    // Headless devices (e.g. lavapipe on build machines) need no presentation support
+    std::vector<const char*> deviceExtensions;
+    if (window) {
+        deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
+    if (presentWaitSupported) {
+        deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -151,8 +380,15 @@ void VulkanContext::createLogicalDevice() {
     }
 
     device = physicalDevice.createDeviceUnique(createInfo);
+    std::cout << "Shader float16: " << (shaderFloat16Supported ? "supported" : "not supported") << std::endl;
     graphicsQueue = device->getQueue(indices.graphicsFamily, 0);
     queueFamilyIndex = indices.graphicsFamily;
+    transferQueue = device->getQueue(indices.transferFamily, 0);
+    transferFamily = indices.transferFamily;
+    std::cout << "Uploads: " << (transferFamily != queueFamilyIndex ? "dedicated transfer queue" : "graphics queue") << std::endl;
+    if (window) {
+        std::cout << "Present wait: " << (presentWaitSupported ? "supported" : "not supported") << std::endl;
+    }
 }
 
 VulkanContext::QueueFamilyIndices VulkanContext::findQueueFamilies(vk::PhysicalDevice dev) {
@@ -161,17 +397,23 @@ VulkanContext::QueueFamilyIndices VulkanContext::findQueueFamilies(vk::PhysicalD
 
     int i = 0;
     for (const auto& queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics) {
+        if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics && !indices.hasGraphicsFamily) {
             indices.graphicsFamily = i;
             indices.hasGraphicsFamily = true;
         }
-
-        if (indices.isComplete()) {
-            break;
+        // Transfer without graphics or compute is a copy engine that runs beside the frame
+        if (queueFamily.queueFlags & vk::QueueFlagBits::eTransfer &&
+            !(queueFamily.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) &&
+            !indices.hasTransferFamily) {
+            indices.transferFamily = i;
+            indices.hasTransferFamily = true;
         }
         i++;
     }
 
+    if (!indices.hasTransferFamily) {
+        indices.transferFamily = indices.graphicsFamily;
+    }
     return indices;
 }
 
@@ -186,7 +428,10 @@ bool VulkanContext::isDeviceSuitable(vk::PhysicalDevice dev) {
 }
 
 std::vector<const char*> VulkanContext::getRequiredExtensions() {
-    auto extensions = Window::getRequiredExtensions();
+    std::vector<const char*> extensions;
+    if (window) {
+        extensions = Window::getRequiredExtensions();
+    }
     if (enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
@@ -218,15 +463,16 @@ void VulkanContext::setupDebugMessenger() {
 }
 
 void VulkanContext::createSyncObjects() {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAvailableSemaphores.resize(framesInFlight);
+    renderFinishedSemaphores.resize(framesInFlight);
+    inFlightFences.resize(framesInFlight);
+    slotFrames.assign(framesInFlight, 0);
 
     vk::SemaphoreCreateInfo semaphoreInfo{};
     vk::FenceCreateInfo fenceInfo{};
     fenceInfo.flags = vk::FenceCreateFlagBits::eSignaled;
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < framesInFlight; i++) {
         imageAvailableSemaphores[i] = device->createSemaphoreUnique(semaphoreInfo);
         renderFinishedSemaphores[i] = device->createSemaphoreUnique(semaphoreInfo);
         inFlightFences[i] = device->createFenceUnique(fenceInfo);
@@ -244,7 +490,7 @@ void VulkanContext::createCommandPool() {
 }
 
 void VulkanContext::createCommandBuffers() {
-    commandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    commandBuffers.resize(framesInFlight);
 
     vk::CommandBufferAllocateInfo allocInfo{};
     allocInfo.commandPool = commandPool.get();
@@ -254,156 +500,261 @@ void VulkanContext::createCommandBuffers() {
     commandBuffers = device->allocateCommandBuffersUnique(allocInfo);
 }
 
-void VulkanContext::beginFrame() {
-    auto result = device->waitForFences(1, &inFlightFences[currentFrame].get(), VK_TRUE, UINT64_MAX);
-    (void)result;
+void VulkanContext::setRecordingThreads(uint32_t threadCount) {
+    // Secondaries of frames in flight belong to the current pools
+    device->waitIdle();
+    recorder = std::make_unique<renderer::ParallelRecorder>(device.get(), queueFamilyIndex, framesInFlight, threadCount);
+    renderGraph->setRecorder(recorder.get());
+}
 
-    device->resetFences(1, &inFlightFences[currentFrame].get());
+void VulkanContext::waitForSlot() {
+    {
+        ENGINE_PROFILE_ZONE("Wait For Fence");
+        auto result = device->waitForFences(1, &inFlightFences[currentFrame].get(), VK_TRUE, UINT64_MAX);
+        (void)result;
+    }
+    // Without present_wait, the fence is the latest point a frame is seen to complete
+    if (!presentWaitSupported) {
+        latency.completed(slotFrames[currentFrame], CpuProfiler::nowUs());
+    }
+    frameWaited = true;
+}
 
+bool VulkanContext::pollPresents(uint64_t id, uint64_t timeoutNs) {
+    if (!presentWaitSupported || id == 0) return false;
     try {
-        auto acquire = device->acquireNextImageKHR(swapChain->getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame].get(), nullptr);
-        imageIndex = acquire.value;
+        auto result = device->waitForPresentKHR(swapChain->getSwapchain(), id, timeoutNs);
+        if (result == vk::Result::eTimeout) return false;
     } catch (const vk::OutOfDateKHRError&) {
-        return;
+        // Never shown; still closes its sample so later frames are not held back
+    }
+    latency.completed(id, CpuProfiler::nowUs());
+    return true;
+}
+
+void VulkanContext::waitForFrame() {
+    ENGINE_PROFILE_ZONE("Frame Pacing");
+    if (lowLatency && !frameWaited) {
+        waitForSlot();
+
+        // Render at most one frame ahead of the screen (or of the GPU without present_wait)
+        if (presentWaitSupported) {
+            ENGINE_PROFILE_ZONE("Wait For Present");
+            pollPresents(submittedFrames, PRESENT_WAIT_TIMEOUT_NS);
+        } else {
+            uint32_t previous = (currentFrame + framesInFlight - 1) % framesInFlight;
+            ENGINE_PROFILE_ZONE("Wait For Previous Frame");
+            auto result = device->waitForFences(1, &inFlightFences[previous].get(), VK_TRUE, UINT64_MAX);
+            (void)result;
+            latency.completed(slotFrames[previous], CpuProfiler::nowUs());
+        }
+    }
+
+    if (frameRateLimit > 0.0f) {
+        // sleep_for overshoots by up to a scheduler tick, so the last millisecond spins
+        double targetUs = lastPaceUs + 1e6 / frameRateLimit;
+        double nowUs = CpuProfiler::nowUs();
+        if (targetUs - nowUs > 1000.0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(targetUs - nowUs - 1000.0)));
+        }
+        while (CpuProfiler::nowUs() < targetUs) {
+            std::this_thread::yield();
+        }
+    }
+    // Late frames start a new period instead of letting the next ones catch up
+    lastPaceUs = CpuProfiler::nowUs();
+}
+
+void VulkanContext::markInputSampled() {
+    latency.sampleInput(CpuProfiler::nowUs());
+}
+
+void VulkanContext::beginFrame() {
+    if (!frameWaited) {
+        waitForSlot();
+    }
+    // Closes the samples of frames that reached the screen since the last poll
+    while (pollPresents(latency.oldestPending(), 0)) {}
+
+    device->resetFences(1, &inFlightFences[currentFrame].get());
+    frameWaited = false;
+
+    // Nothing recorded for this frame yet, so rebuilt pipelines can be swapped in
+    shaderReload->update();
+    // Heap slots released by the frame that last used this fence can be reused
+    bindlessHeap->beginFrame();
+    // So can the secondary command buffers that frame recorded
+    recorder->beginFrame(currentFrame);
+
+    if (swapChain) {
+        try {
+            ENGINE_PROFILE_ZONE("Acquire Image");
+            auto acquire = device->acquireNextImageKHR(swapChain->getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame].get(), nullptr);
+            imageIndex = acquire.value;
+        } catch (const vk::OutOfDateKHRError&) {
+            return;
+        }
+    } else {
+        imageIndex = 0;
     }
 
     commandBuffers[currentFrame]->reset();
     vk::CommandBufferBeginInfo beginInfo{};
     commandBuffers[currentFrame]->begin(beginInfo);
-}
 
-void VulkanContext::endFrameBlit(vk::Image sourceImage) {
-    auto cmd = commandBuffers[currentFrame].get();
+    // Submits the uploads recorded since last frame and takes ownership of their destinations
+    transferWaitValue = transferManager->beginFrame(commandBuffers[currentFrame].get());
 
-    // Transition swapchain image to TransferDst for blit
-    vk::ImageMemoryBarrier barrier{};
-    barrier.oldLayout = vk::ImageLayout::eUndefined;
-    barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = swapChain->getImages()[imageIndex];
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.srcAccessMask = vk::AccessFlagBits::eNone;
-    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-
-    cmd.pipelineBarrier(
-        vk::PipelineStageFlagBits::eTopOfPipe,
-        vk::PipelineStageFlagBits::eTransfer,
-        {}, nullptr, nullptr, barrier
-    );
+    // The fence above covers this slot's queries, so last use's timings are ready
+    gpuProfiler->beginFrame(commandBuffers[currentFrame].get(), currentFrame);
 
-    // Blit from sourceImage (storage result) to swapchain image
-    auto extent = swapChain->getExtent();
-    vk::ImageBlit blit{};
-    blit.srcOffsets[1] = vk::Offset3D{ static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
-    blit.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-    blit.srcSubresource.layerCount = 1;
-    blit.dstOffsets[1] = vk::Offset3D{ static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
-    blit.dstSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
-    blit.dstSubresource.layerCount = 1;
-
-    cmd.blitImage(
-        sourceImage, vk::ImageLayout::eTransferSrcOptimal,
-        swapChain->getImages()[imageIndex], vk::ImageLayout::eTransferDstOptimal,
-        1, &blit, vk::Filter::eLinear
-    );
-
-    // Transition swapchain to ColorAttachmentOptimal for ImGui overlay
-    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
-    barrier.newLayout = vk::ImageLayout::eColorAttachmentOptimal;
-    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-    barrier.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+    renderGraph->reset();
+    if (swapChain) {
+        targetImage = renderGraph->importExternalImage("Swapchain", swapChain->getImages()[imageIndex]);
+    } else {
+        targetImage = renderGraph->importImage("Offscreen Target", offscreenTarget.image.get());
+    }
+}
 
-    cmd.pipelineBarrier(
-        vk::PipelineStageFlagBits::eTransfer,
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        {}, nullptr, nullptr, barrier
-    );
+void VulkanContext::endFrameBlit(vk::Image sourceImage) {
+    auto source = renderGraph->importImage("Blit Source", sourceImage);
+
+    // The blit is the first write to the acquired image, so its old contents are discarded
+    renderGraph->addPass("Blit")
+        .read(source, renderer::ResourceUsage::TransferRead)
+        .discard(targetImage, renderer::ResourceUsage::TransferWrite)
+        .execute([this, sourceImage](vk::CommandBuffer cmd) {
+            auto extent = getTargetExtent();
+            vk::ImageBlit blit{};
+            blit.srcOffsets[1] = vk::Offset3D{ static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
+            blit.srcSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+            blit.srcSubresource.layerCount = 1;
+            blit.dstOffsets[1] = vk::Offset3D{ static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1 };
+            blit.dstSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+            blit.dstSubresource.layerCount = 1;
+
+            cmd.blitImage(
+                sourceImage, vk::ImageLayout::eTransferSrcOptimal,
+                swapChain ? swapChain->getImages()[imageIndex] : offscreenTarget.image.get(), vk::ImageLayout::eTransferDstOptimal,
+                1, &blit, vk::Filter::eLinear
+            );
+        });
 }
 
 void VulkanContext::endFramePresent() {
     auto cmd = commandBuffers[currentFrame].get();
 
-    // Transition swapchain image to Present layout
-    vk::ImageMemoryBarrier barrier{};
-    barrier.oldLayout = vk::ImageLayout::eColorAttachmentOptimal;
-    barrier.newLayout = vk::ImageLayout::ePresentSrcKHR;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = swapChain->getImages()[imageIndex];
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
-    barrier.dstAccessMask = vk::AccessFlagBits::eNone;
-
-    cmd.pipelineBarrier(
-        vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        vk::PipelineStageFlagBits::eBottomOfPipe,
-        {}, nullptr, nullptr, barrier
-    );
+    if (swapChain) {
+        renderGraph->addPass("Present").read(targetImage, renderer::ResourceUsage::Present);
+    } else if (captureRequested) {
+        auto capture = renderGraph->importBuffer("Capture Buffer", captureBuffer.buffer.get());
+        renderGraph->addPass("Capture")
+            .read(targetImage, renderer::ResourceUsage::TransferRead)
+            .write(capture, renderer::ResourceUsage::TransferWrite)
+            .execute([this](vk::CommandBuffer cmd) {
+                vk::BufferImageCopy region{};
+                region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = vk::Extent3D{ offscreenExtent.width, offscreenExtent.height, 1 };
+                cmd.copyImageToBuffer(offscreenTarget.image.get(), vk::ImageLayout::eTransferSrcOptimal,
+                                      captureBuffer.buffer.get(), 1, &region);
+            });
+        renderGraph->addPass("Capture Readback").read(capture, renderer::ResourceUsage::HostRead);
+
+        captureRequested = false;
+        capturePending = true;
+        captureSlot = currentFrame;
+    }
 
-    cmd.end();
+    {
+        ENGINE_PROFILE_ZONE("Record Commands");
+        gpuProfiler->beginScope(cmd, "Frame");
+        renderGraph->execute(cmd);
+        gpuProfiler->endScope(cmd);
+        gpuProfiler->endFrame();
+
+        cmd.end();
+    }
 
     vk::SubmitInfo submitInfo{};
-    vk::Semaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame].get() };
-    vk::PipelineStageFlags waitStages[] = { vk::PipelineStageFlagBits::eColorAttachmentOutput };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    std::vector<vk::Semaphore> waitSemaphores;
+    std::vector<vk::PipelineStageFlags> waitStages;
+    std::vector<uint64_t> waitValues; // Ignored for binary semaphores
+    vk::Semaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame].get() };
+    submittedFrames++;
+    slotFrames[currentFrame] = submittedFrames;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffers[currentFrame].get();
 
-    vk::Semaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame].get() };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    // Headless frames have no acquire to wait on and nothing to present
+    if (swapChain) {
+        // The acquire is waited on where the graph first touches the swapchain image (compute, transfer or color output)
+        waitSemaphores.push_back(imageAvailableSemaphores[currentFrame].get());
+        waitStages.push_back(renderGraph->getFirstStage(targetImage));
+        waitValues.push_back(0);
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = signalSemaphores;
+    }
+    // Uploads submitted at beginFrame; a GPU-side wait that has usually already passed
+    if (transferWaitValue > 0) {
+        waitSemaphores.push_back(transferManager->getTimeline());
+        waitStages.push_back(renderer::TransferManager::WAIT_STAGES);
+        waitValues.push_back(transferWaitValue);
+    }
 
-    graphicsQueue.submit(submitInfo, inFlightFences[currentFrame].get());
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+
+    {
+        ENGINE_PROFILE_ZONE("Queue Submit");
+        graphicsQueue.submit(submitInfo, inFlightFences[currentFrame].get());
+    }
 
-    vk::PresentInfoKHR presentInfo{};
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
-    
-    vk::SwapchainKHR swapChains[] = { swapChain->getSwapchain() };
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
-    presentInfo.pImageIndices = &imageIndex;
+    if (swapChain) {
+        vk::PresentInfoKHR presentInfo{};
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = signalSemaphores;
 
-    try {
-        auto resultPresent = graphicsQueue.presentKHR(presentInfo);
-        (void)resultPresent;
-    } catch (const vk::OutOfDateKHRError&) {
+        vk::SwapchainKHR swapChains[] = { swapChain->getSwapchain() };
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
+        presentInfo.pImageIndices = &imageIndex;
+
+        // The frame number doubles as the present id that waitForPresentKHR takes
+        vk::PresentIdKHR presentId{ 1, &submittedFrames };
+        if (presentWaitSupported) {
+            presentInfo.pNext = &presentId;
+        }
+
+        try {
+            ENGINE_PROFILE_ZONE("Queue Present");
+            auto resultPresent = graphicsQueue.presentKHR(presentInfo);
+            (void)resultPresent;
+        } catch (const vk::OutOfDateKHRError&) {
+        }
     }
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-}
+    latency.submitted(submittedFrames, CpuProfiler::nowUs());
 
-void VulkanContext::immediateSubmit(std::function<void(vk::CommandBuffer)> func) {
-    vk::CommandBufferAllocateInfo allocInfo{};
-    allocInfo.commandPool = commandPool.get();
-    allocInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocInfo.commandBufferCount = 1;
+    currentFrame = (currentFrame + 1) % framesInFlight;
+}
 
-    auto cmdBuffers = device->allocateCommandBuffersUnique(allocInfo);
-    auto cmd = cmdBuffers[0].get();
+bool VulkanContext::readCapture(std::vector<uint8_t>& rgba) {
+    if (!capturePending) return false;
 
-    vk::CommandBufferBeginInfo beginInfo{};
-    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-    cmd.begin(beginInfo);
-    func(cmd);
-    cmd.end();
+    // The capture pass made the copy visible to the host once this fence signals
+    auto result = device->waitForFences(1, &inFlightFences[captureSlot].get(), VK_TRUE, UINT64_MAX);
+    (void)result;
 
-    vk::SubmitInfo submitInfo{};
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &cmd;
-    graphicsQueue.submit(submitInfo, nullptr);
-    graphicsQueue.waitIdle();
+    rgba.resize(static_cast<size_t>(offscreenExtent.width) * offscreenExtent.height * 4);
+    std::memcpy(rgba.data(), captureMapped, rgba.size());
+    capturePending = false;
+    return true;
 }
 
 } // namespace engine::core
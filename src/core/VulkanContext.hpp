@@ -5,8 +5,15 @@
 #include <memory>
 #include <functional>
 #include "Window.hpp"
+#include "LatencyTracker.hpp"
 #include "renderer/Swapchain.hpp"
 #include "renderer/ResourceManager.hpp"
+#include "renderer/RenderGraph.hpp"
+#include "renderer/GpuProfiler.hpp"
+#include "renderer/ParallelRecorder.hpp"
+#include "renderer/ShaderHotReload.hpp"
+#include "renderer/BindlessHeap.hpp"
+#include "renderer/TransferManager.hpp"
 #include "renderer/BrickAtlas.hpp"
 #include "renderer/SparseMap.hpp"
 
@@ -14,62 +21,176 @@ namespace engine::core {
 
 class VulkanContext {
 public:
-    VulkanContext(Window& window);
+    // framesInFlight: frames the CPU may record ahead of the GPU, 1 to MAX_FRAMES_IN_FLIGHT.
+    // More overlap smooths out CPU spikes at the cost of a frame of latency each.
+    // presentMode falls back to FIFO when the surface does not support it.
+    explicit VulkanContext(Window& window, uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT,
+                           vk::PresentModeKHR presentMode = vk::PresentModeKHR::eMailbox);
+    // Headless: no surface, swapchain or present extensions; frames render into an
+    // offscreen target of the given size that can be read back with requestCapture
+    VulkanContext(uint32_t width, uint32_t height, uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
     ~VulkanContext();
 
     vk::Instance getInstance() const { return instance.get(); }
     vk::Device getDevice() const { return device.get(); }
     vk::PhysicalDevice getPhysicalDevice() const { return physicalDevice; }
     vk::SurfaceKHR getSurface() const { return surface.get(); }
+    // Null when headless
     renderer::Swapchain* getSwapchain() const { return swapChain.get(); }
+    bool isHeadless() const { return window == nullptr; }
     renderer::ResourceManager& getResourceManager() { return *resourceManager; }
+    // Uploads and deferred destruction; see TransferManager
+    renderer::TransferManager& getTransferManager() { return *transferManager; }
     renderer::BrickAtlas& getBrickAtlas() { return *brickAtlas; }
     renderer::SparseMap& getSparseMap() { return *sparseMap; }
+    // Reset by beginFrame, executed and submitted by endFramePresent
+    renderer::RenderGraph& getRenderGraph() { return *renderGraph; }
+    // The acquired swapchain image (or the offscreen target), imported into this frame's graph
+    renderer::RenderGraph::ImageHandle getTargetImage() const { return targetImage; }
+    // Size, format and per-image views of what frames end up in; indexed by getImageIndex
+    vk::Extent2D getTargetExtent() const { return swapChain ? swapChain->getExtent() : offscreenExtent; }
+    vk::Format getTargetFormat() const { return swapChain ? swapChain->getFormat() : OFFSCREEN_FORMAT; }
+    const std::vector<vk::ImageView>& getTargetImageViews() const { return swapChain ? swapChain->getImageViews() : offscreenViews; }
+    // Times every render graph pass plus the whole frame
+    renderer::GpuProfiler& getGpuProfiler() { return *gpuProfiler; }
+    // Per-thread, per-frame command pools; the render graph records its passes through it
+    renderer::ParallelRecorder& getRecorder() { return *recorder; }
+    // Threads recording render graph passes, including the main thread; 1 records inline.
+    // Waits for the device to go idle, so call it between frames.
+    void setRecordingThreads(uint32_t threadCount);
     vk::Queue getGraphicsQueue() const { return graphicsQueue; }
     uint32_t getQueueFamily() const { return queueFamilyIndex; }
     vk::CommandPool getCommandPool() const { return commandPool.get(); }
+    // Shared by every pipeline; loaded from PIPELINE_CACHE_PATH at startup and written back on shutdown
+    vk::PipelineCache getPipelineCache() const { return pipelineCache.get(); }
+    // Off until enabled; pipelines register themselves when created
+    renderer::ShaderHotReload& getShaderReload() { return *shaderReload; }
+    // Set 0 of every compute pipeline; resources are addressed by heap index
+    renderer::BindlessHeap& getBindlessHeap() { return *bindlessHeap; }
     uint32_t getImageIndex() const { return imageIndex; }
+    // Device supports float16_t arithmetic in shaders (enabled at device creation)
+    bool supportsShaderFloat16() const { return shaderFloat16Supported; }
+    // Compute passes can write the acquired swapchain image (storage usage + format-less writes)
+    bool supportsDirectPresent() const { return storageWriteWithoutFormat && (!swapChain || swapChain->supportsStorage()); }
 
-    void immediateSubmit(std::function<void(vk::CommandBuffer)> func);
-    
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         bool hasGraphicsFamily = false;
+        // Transfer-only family (DMA engine) when the device has one, else the graphics family
+        uint32_t transferFamily;
+        bool hasTransferFamily = false;
 
         bool isComplete() const { return hasGraphicsFamily; }
     };
 
+    // Pacing point at the top of the frame loop, before input is polled. Applies the frame
+    // cap, and in low latency mode also waits for this frame's slot and for the previous
+    // frame to reach the screen (or finish on the GPU without present_wait), so the input
+    // sampled afterwards is as fresh as possible. beginFrame skips the waits done here.
+    void waitForFrame();
+    // Input for the next frame was sampled now; starts its latency measurement
+    void markInputSampled();
     void beginFrame();
+    // Adds a pass copying sourceImage to the target image
     void endFrameBlit(vk::Image sourceImage);
+    // Executes and submits the graph, then presents (headless: only submits)
     void endFramePresent();
+
+    // Headless: copies this frame's target to a host buffer once it has been rendered.
+    // Call before endFramePresent, then readCapture before the same slot's next beginFrame.
+    void requestCapture() { captureRequested = true; }
+    // Waits for the captured frame and returns its pixels as tightly packed RGBA8 rows
+    bool readCapture(std::vector<uint8_t>& rgba);
+
     vk::CommandBuffer getCurrentCommandBuffer() const { return commandBuffers[currentFrame].get(); }
+    // Frame-in-flight slot being recorded; its fence has been waited on by beginFrame
+    uint32_t getCurrentFrame() const { return currentFrame; }
+    // Number of frame slots; per-frame resources keep this many copies
+    uint32_t getFramesInFlight() const { return framesInFlight; }
+
+    bool& getLowLatency() { return lowLatency; }
+    // Frames per second waitForFrame paces to; 0 = uncapped
+    float& getFrameRateLimit() { return frameRateLimit; }
+    // Present mode the swapchain ended up with (FIFO when headless)
+    vk::PresentModeKHR getPresentMode() const { return swapChain ? swapChain->getPresentMode() : vk::PresentModeKHR::eFifo; }
+    // VK_KHR_present_id + VK_KHR_present_wait are enabled: latency is measured up to the display
+    bool supportsPresentWait() const { return presentWaitSupported; }
+    const LatencyTracker& getLatency() const { return latency; }
+
+    // Upper bound for framesInFlight, usable to size per-frame arrays
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+    static constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+    // Recording threads at startup, lowered to half the hardware threads
+    static constexpr uint32_t DEFAULT_RECORDING_THREADS = 4;
+    static constexpr vk::Format OFFSCREEN_FORMAT = vk::Format::eR8G8B8A8Unorm;
+    static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+    // Bounds the low latency present wait, e.g. while the window is minimized
+    static constexpr uint64_t PRESENT_WAIT_TIMEOUT_NS = 100'000'000;
 
     QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice device);
 
 private:
-    Window& window;
+    Window* window = nullptr;
     vk::UniqueInstance instance;
     vk::DebugUtilsMessengerEXT debugMessenger;
     vk::PhysicalDevice physicalDevice;
     vk::UniqueDevice device;
     vk::Queue graphicsQueue;
+    vk::Queue transferQueue;
+    uint32_t transferFamily = 0;
     vk::UniqueSurfaceKHR surface;
     std::unique_ptr<renderer::Swapchain> swapChain;
+    vk::UniquePipelineCache pipelineCache;
+    std::unique_ptr<renderer::ShaderHotReload> shaderReload;
+    std::unique_ptr<renderer::BindlessHeap> bindlessHeap;
 
     std::vector<vk::UniqueSemaphore> imageAvailableSemaphores;
     std::vector<vk::UniqueSemaphore> renderFinishedSemaphores;
     std::vector<vk::UniqueFence> inFlightFences;
 
     std::unique_ptr<renderer::ResourceManager> resourceManager;
+    std::unique_ptr<renderer::TransferManager> transferManager;
     std::unique_ptr<renderer::BrickAtlas> brickAtlas;
     std::unique_ptr<renderer::SparseMap> sparseMap;
+    std::unique_ptr<renderer::RenderGraph> renderGraph;
+    std::unique_ptr<renderer::GpuProfiler> gpuProfiler;
+    std::unique_ptr<renderer::ParallelRecorder> recorder;
+    renderer::RenderGraph::ImageHandle targetImage;
+
+    // Headless target and its readback
+    vk::Extent2D offscreenExtent{};
+    renderer::ResourceManager::Image offscreenTarget;
+    std::vector<vk::ImageView> offscreenViews;
+    renderer::ResourceManager::Buffer captureBuffer;
+    void* captureMapped = nullptr;
+    bool captureRequested = false;
+    bool capturePending = false;
+    uint32_t captureSlot = 0;
+
+    // Frame pacing and latency
+    bool lowLatency = false;
+    float frameRateLimit = 0.0f;
+    bool presentWaitSupported = false;
+    bool frameWaited = false;        // waitForFrame already waited on the current slot
+    uint64_t submittedFrames = 0;    // Also the present id of the last presented frame
+    std::vector<uint64_t> slotFrames; // Frame id each slot last submitted
+    double lastPaceUs = 0.0;
+    LatencyTracker latency;
+
+    // Timeline value of the uploads the frame being recorded must wait for
+    uint64_t transferWaitValue = 0;
 
     vk::UniqueCommandPool commandPool;
     std::vector<vk::UniqueCommandBuffer> commandBuffers;
+    uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
     uint32_t currentFrame = 0;
     uint32_t imageIndex = 0;
     uint32_t queueFamilyIndex = 0;
+    bool shaderFloat16Supported = false;
+    bool storageWriteWithoutFormat = false;
 
+    void initialize(PFN_vkGetInstanceProcAddr getInstanceProcAddr, uint32_t width, uint32_t height,
+                    vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo);
     void createInstance();
     void createCommandPool();
     void createCommandBuffers();
@@ -77,9 +198,14 @@ private:
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createSyncObjects();
+    void waitForSlot();
+    // Waits up to timeoutNs for frame id to reach the screen and closes the latency samples
+    // up to it; false on timeout or without present_wait
+    bool pollPresents(uint64_t id, uint64_t timeoutNs);
     void createSurface();
-
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
+    void createOffscreenTarget(uint32_t width, uint32_t height);
+    void createPipelineCache();
+    void savePipelineCache();
 
     bool isDeviceSuitable(vk::PhysicalDevice device);
     
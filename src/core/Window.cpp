@@ -44,8 +44,10 @@ void Window::pollEvents() {
 void Window::keyCallback(GLFWwindow* win, int key, int /*scancode*/, int action, int /*mods*/) {
     auto* self = static_cast<Window*>(glfwGetWindowUserPointer(win));
     if (key >= 0 && key < 512) {
-        if (action == GLFW_PRESS)
+        if (action == GLFW_PRESS) {
             self->input.keys[key] = true;
+            self->input.keysPressed[key] = true;
+        }
         else if (action == GLFW_RELEASE)
             self->input.keys[key] = false;
     }
@@ -8,13 +8,18 @@
 #include <imgui_impl_vulkan.h>
 #include <iostream>
 #include <cmath>
+#include <cfloat>
+#include <random>
+#include <algorithm>
 
 namespace engine::editor {
 
 // Primitive type names for UI
 static const char* primitiveNames[] = { "Sphere", "Box", "Torus", "Capsule", "Cylinder" };
 static const char* operationNames[] = { "Union", "Subtraction", "Intersection", "SmoothUnion", "SmoothSub" };
-static const char* renderModeNames[] = { "Lit (Standard PBR)", "Normals", "Complexity (Steps)" };
+static const char* renderModeNames[] = { "Lit (Standard PBR)", "Normals", "Complexity (Steps)", "Light Clusters" };
+static const char* qualityNames[] = { "Low", "Medium", "High", "Ultra" };
+static const char* shadowResNames[] = { "Half", "Quarter" };
 static const char* brushModeNames[] = { "Raise", "Lower", "Flatten", "Smooth", "Paint" };
 static const char* layerNames[] = { "Grass (Base)", "Dirt (R)", "Rock (G)", "Snow (B)" };
 
@@ -23,9 +28,12 @@ static float brushRadius = 0.1f;
 static float brushStrength = 0.5f;
 static int brushMode = 0;
 static int paintLayer = 1; // Default to 'Dirt'
+// Latest completed hover pick; picks resolve asynchronously a few frames later
+static engine::renderer::SDFRenderer::SelectionData hoverSelection{ -1, 0, 0, 0 };
 static float targetHeight = 0.0f;
 static bool terrainToolsActive = false;
 static bool showGrid = false;
+static int selectedLight = -1;
 
 EditorUI::EditorUI(engine::core::VulkanContext& ctx, GLFWwindow* window) : context(ctx) {
     initImGui(window);
@@ -289,7 +297,7 @@ void EditorUI::buildPanels(engine::renderer::SDFRenderer& renderer, int& selecte
 
     // --- Display Settings ---
     ImGui::SetNextWindowPos(ImVec2(300, 10), ImGuiCond_FirstUseEver);
-    ImGui::SetNextWindowSize(ImVec2(280, 140), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(280, 280), ImGuiCond_FirstUseEver);
     ImGui::Begin("Display Settings", nullptr, ImGuiWindowFlags_NoCollapse);
     
     int renderMode = static_cast<int>(renderer.getRenderMode());
@@ -302,10 +310,253 @@ void EditorUI::buildPanels(engine::renderer::SDFRenderer& renderer, int& selecte
         renderer.getShowGround() = showGround;
     }
 
+    int quality = static_cast<int>(renderer.getQuality());
+    if (ImGui::Combo("Quality", &quality, qualityNames, IM_ARRAYSIZE(qualityNames))) {
+        renderer.getQuality() = static_cast<engine::renderer::QualityPreset>(quality);
+    }
+
+    ImGui::Checkbox("Stage Edits in Shared Memory", &renderer.getStageEdits());
+
+    if (renderer.supportsFp16Evaluation()) {
+        bool fp16 = renderer.usesFp16Evaluation();
+        if (ImGui::Checkbox("FP16 Distance Evaluation", &fp16)) {
+            renderer.setFp16Evaluation(fp16);
+        }
+    } else {
+        ImGui::TextDisabled("FP16 Distance Evaluation: unsupported");
+    }
+
+    int shadowRes = renderer.getShadowScale() == 4 ? 1 : 0;
+    if (ImGui::Combo("Shadow/AO Resolution", &shadowRes, shadowResNames, IM_ARRAYSIZE(shadowResNames))) {
+        renderer.setShadowScale(shadowRes == 1 ? 4 : 2);
+    }
+
+    if (renderer.supportsDirectPresent()) {
+        bool directPresent = renderer.usesDirectPresent();
+        if (ImGui::Checkbox("Direct Present (no blit)", &directPresent)) {
+            renderer.setDirectPresent(directPresent);
+        }
+    } else {
+        ImGui::TextDisabled("Direct Present: unsupported");
+    }
+
+    ImGui::Checkbox("Probe GI", &renderer.getProbeGI());
+    if (renderer.getProbeGI()) {
+        int rayBudget = static_cast<int>(renderer.getGIRayBudget());
+        if (ImGui::SliderInt("GI Rays/Frame", &rayBudget, 64, 65536, "%d", ImGuiSliderFlags_Logarithmic)) {
+            renderer.getGIRayBudget() = static_cast<uint32_t>(rayBudget);
+        }
+        ImGui::SliderFloat("GI Intensity", &renderer.getGIIntensity(), 0.0f, 2.0f, "%.2f");
+
+        // Whole probes per frame, so the refresh period follows from the budget
+        uint32_t probesPerFrame = std::max(renderer.getGIRayBudget() / engine::renderer::SDFRenderer::RAYS_PER_PROBE, 1u);
+        ImGui::Text("Full grid refresh: %u frames",
+                    (engine::renderer::SDFRenderer::PROBE_COUNT + probesPerFrame - 1) / probesPerFrame);
+    }
+
     ImGui::Separator();
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
     ImGui::Text("Objects: %d", (int)edits.size());
 
+    // Last executed frame
+    const auto& graphStats = context.getRenderGraph().getStats();
+    ImGui::Text("Graph: %u passes, %u levels, %u barriers", graphStats.passes, graphStats.levels,
+                graphStats.imageBarriers + graphStats.bufferBarriers);
+    ImGui::Text("Transients: %.1f MB (%.1f MB aliased)", graphStats.transientBytes / (1024.0 * 1024.0),
+                graphStats.aliasedBytes / (1024.0 * 1024.0));
+    ImGui::Text("Recording: %u threads, %u secondary buffers", context.getRecorder().getThreadCount(),
+                graphStats.secondaryBuffers);
+
+    auto memoryStats = context.getResourceManager().getStats();
+    ImGui::Text("GPU Memory: %.1f / %.1f MB, %u of %u device allocations", memoryStats.used / (1024.0 * 1024.0),
+                memoryStats.reserved / (1024.0 * 1024.0), memoryStats.deviceAllocations, memoryStats.maxDeviceAllocations);
+    if (ImGui::TreeNode("Memory Types")) {
+        for (const auto& type : memoryStats.types) {
+            bool deviceLocal = static_cast<bool>(type.flags & vk::MemoryPropertyFlagBits::eDeviceLocal);
+            bool hostVisible = static_cast<bool>(type.flags & vk::MemoryPropertyFlagBits::eHostVisible);
+            ImGui::Text("Type %u (%s%s%s)", type.memoryType, deviceLocal ? "device" : "",
+                        deviceLocal && hostVisible ? ", " : "", hostVisible ? "host" : "");
+            ImGui::Text("  %.1f / %.1f MB, %u allocations in %u blocks + %u dedicated",
+                        type.used / (1024.0 * 1024.0), type.reserved / (1024.0 * 1024.0),
+                        type.allocations, type.blocks, type.dedicated);
+            ImGui::Text("  Fragmentation %.0f%%, largest free %.1f MB", type.fragmentation * 100.0f,
+                        type.largestFree / (1024.0 * 1024.0));
+        }
+        ImGui::TreePop();
+    }
+
+    using HeapKind = engine::renderer::BindlessHeap::Kind;
+    auto& heap = context.getBindlessHeap();
+    ImGui::Text("Descriptor Heap: %u/%u storage images, %u/%u textures, %u/%u buffers",
+                heap.getUsed(HeapKind::StorageImage), heap.getCapacity(HeapKind::StorageImage),
+                heap.getUsed(HeapKind::SampledImage), heap.getCapacity(HeapKind::SampledImage),
+                heap.getUsed(HeapKind::StorageBuffer), heap.getCapacity(HeapKind::StorageBuffer));
+
+    auto& shaderReload = context.getShaderReload();
+    bool watchShaders = shaderReload.isEnabled();
+    if (ImGui::Checkbox("Shader Hot Reload", &watchShaders)) {
+        shaderReload.setEnabled(watchShaders);
+    }
+    std::string reloadStatus = shaderReload.getStatus();
+    if (!reloadStatus.empty()) {
+        ImGui::TextWrapped("%s", reloadStatus.c_str());
+    }
+
+    // --- Frame Pacing ---
+    ImGui::Separator();
+    vk::PresentModeKHR presentMode = context.getPresentMode();
+    ImGui::Text("Present Mode: %s", presentMode == vk::PresentModeKHR::eMailbox ? "Mailbox" :
+                                    presentMode == vk::PresentModeKHR::eImmediate ? "Immediate" : "FIFO");
+    ImGui::Checkbox("Low Latency", &context.getLowLatency());
+    float& frameRateLimit = context.getFrameRateLimit();
+    ImGui::SliderFloat("FPS Cap", &frameRateLimit, 0.0f, 240.0f, frameRateLimit > 0.0f ? "%.0f" : "Off");
+
+    // Up to the display with present_wait, else up to the frame's fence being seen signalled
+    const auto& latency = context.getLatency();
+    const auto& latencyHistory = latency.getHistory();
+    if (!latencyHistory.empty()) {
+        float latencyMs[engine::core::LatencyTracker::HISTORY_FRAMES];
+        int count = 0;
+        for (const auto& sample : latencyHistory) {
+            latencyMs[count++] = static_cast<float>(sample.completeMs);
+        }
+        auto average = latency.getAverage();
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%s %.1f ms (avg %.1f)",
+                 context.supportsPresentWait() ? "Input to present" : "Input to GPU done",
+                 latencyHistory.back().completeMs, average.completeMs);
+        ImGui::PlotLines("##Latency", latencyMs, count, 0, overlay, 0.0f, FLT_MAX, ImVec2(-1, 60));
+        ImGui::Text("Input to submit: %.1f ms avg", average.submitMs);
+    }
+
+    ImGui::End();
+
+    // --- GPU Profiler ---
+    auto& profiler = context.getGpuProfiler();
+    ImGui::SetNextWindowPos(ImVec2(590, 340), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(320, 320), ImGuiCond_FirstUseEver);
+    ImGui::Begin("GPU Profiler", nullptr, ImGuiWindowFlags_NoCollapse);
+
+    if (!profiler.isSupported()) {
+        ImGui::TextDisabled("Timestamps unsupported on this queue");
+    } else {
+        ImGui::Checkbox("Enabled", &profiler.getEnabled());
+
+        const auto& history = profiler.getHistory();
+        if (!history.empty()) {
+            float frameTimes[engine::renderer::GpuProfiler::HISTORY_FRAMES];
+            int count = 0;
+            for (const auto& frame : history) {
+                frameTimes[count++] = static_cast<float>(frame.gpuMs);
+            }
+            char overlay[32];
+            snprintf(overlay, sizeof(overlay), "GPU %.2f ms", history.back().gpuMs);
+            ImGui::PlotLines("##GpuFrame", frameTimes, count, 0, overlay, 0.0f, FLT_MAX, ImVec2(-1, 60));
+
+            // Latest frame's scopes, with each scope's average over the history
+            if (ImGui::BeginTable("GpuScopes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 150))) {
+                ImGui::TableSetupColumn("Pass");
+                ImGui::TableSetupColumn("ms", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+                ImGui::TableSetupColumn("avg", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+                ImGui::TableHeadersRow();
+                for (const auto& scope : history.back().scopes) {
+                    double sum = 0.0;
+                    int samples = 0;
+                    for (const auto& frame : history) {
+                        for (const auto& other : frame.scopes) {
+                            if (other.name == scope.name) {
+                                sum += other.endMs - other.startMs;
+                                samples++;
+                            }
+                        }
+                    }
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(scope.name.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", scope.endMs - scope.startMs);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", samples > 0 ? sum / samples : 0.0);
+                }
+                ImGui::EndTable();
+            }
+        }
+
+        if (ImGui::Button("Export Chrome Trace", ImVec2(-1, 0))) {
+            traceStatus = profiler.exportChromeTrace("gpu_trace.json") ? "Wrote gpu_trace.json" : "Failed to write gpu_trace.json";
+        }
+        if (!traceStatus.empty()) {
+            ImGui::TextDisabled("%s", traceStatus.c_str());
+        }
+    }
+
+    ImGui::End();
+
+    // --- Lights ---
+    auto& lights = renderer.getLights();
+    ImGui::SetNextWindowPos(ImVec2(590, 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(280, 320), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Lights", nullptr, ImGuiWindowFlags_NoCollapse);
+
+    if (ImGui::Button("+ Add Light", ImVec2(-1, 0)) && lights.size() < engine::renderer::SDFRenderer::MAX_LIGHTS) {
+        lights.push_back({ glm::vec3(0.0f, 2.0f, 3.0f), 8.0f, glm::vec3(1.0f, 0.8f, 0.6f), 4.0f });
+        selectedLight = static_cast<int>(lights.size()) - 1;
+        renderer.markLightsDirty();
+    }
+
+    // Stress test for the clustered path: fill the area around the origin
+    if (ImGui::Button("Scatter 256 Lights", ImVec2(-1, 0))) {
+        std::mt19937 rng(1234u + static_cast<uint32_t>(lights.size()));
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (int i = 0; i < 256 && lights.size() < engine::renderer::SDFRenderer::MAX_LIGHTS; i++) {
+            glm::vec3 position(unit(rng) * 80.0f - 40.0f, 0.5f + unit(rng) * 3.0f, unit(rng) * 80.0f - 40.0f);
+            glm::vec3 color(0.3f + 0.7f * unit(rng), 0.3f + 0.7f * unit(rng), 0.3f + 0.7f * unit(rng));
+            lights.push_back({ position, 3.0f + unit(rng) * 5.0f, color, 2.0f + unit(rng) * 4.0f });
+        }
+        renderer.markLightsDirty();
+    }
+
+    if (ImGui::Button("Clear", ImVec2(-1, 0))) {
+        lights.clear();
+        selectedLight = -1;
+        renderer.markLightsDirty();
+    }
+
+    ImGui::Text("Lights: %d / %u", static_cast<int>(lights.size()), engine::renderer::SDFRenderer::MAX_LIGHTS);
+    ImGui::Separator();
+
+    ImGui::BeginChild("LightList", ImVec2(0, 80));
+    for (int i = 0; i < static_cast<int>(lights.size()); i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "Point Light #%d", i);
+        if (ImGui::Selectable(label, selectedLight == i)) {
+            selectedLight = i;
+        }
+    }
+    ImGui::EndChild();
+
+    if (selectedLight >= 0 && selectedLight < static_cast<int>(lights.size())) {
+        auto& light = lights[selectedLight];
+        ImGui::Separator();
+        if (ImGui::DragFloat3("Position##Light", &light.position.x, 0.05f, -128.0f, 128.0f, "%.2f")) {
+            renderer.markLightsDirty();
+        }
+        if (ImGui::ColorEdit3("Color##Light", &light.color.x)) {
+            renderer.markLightsDirty();
+        }
+        if (ImGui::SliderFloat("Intensity", &light.intensity, 0.0f, 50.0f, "%.1f")) {
+            renderer.markLightsDirty();
+        }
+        if (ImGui::SliderFloat("Radius##Light", &light.radius, 0.5f, 50.0f, "%.1f")) {
+            renderer.markLightsDirty();
+        }
+        if (ImGui::Button("Delete Light", ImVec2(-1, 0))) {
+            lights.erase(lights.begin() + selectedLight);
+            selectedLight = -1;
+            renderer.markLightsDirty();
+        }
+    }
+
     ImGui::End();
 
     // --- Terrain Tools ---
@@ -335,14 +586,15 @@ void EditorUI::buildPanels(engine::renderer::SDFRenderer& renderer, int& selecte
             renderer.getShowGrid() = showGrid;
         }
 
-        // Logic for applying brush
+        // Logic for applying brush; any frame without a stamp ends the stroke
+        bool stamped = false;
         if (!ImGui::GetIO().WantCaptureMouse) {
-            // Trigger picking request for NEXT frame
+            // One single-ray pick per frame; act on the most recent completed result
             ImVec2 mousePos = ImGui::GetIO().MousePos;
-            renderer.triggerPicking(mousePos.x, mousePos.y);
-
-            // Check result from LAST frame
-            auto selection = renderer.getSelection();
+            renderer.requestPick(mousePos.x, mousePos.y, [](const engine::renderer::SDFRenderer::SelectionData& result) {
+                hoverSelection = result;
+            });
+            const auto& selection = hoverSelection;
             
             // Update brush cursor visual in renderer
             float visualRadius = (brushMode == 100) ? 0.0f : brushRadius; // Always show unless hidden
@@ -382,16 +634,21 @@ void EditorUI::buildPanels(engine::renderer::SDFRenderer& renderer, int& selecte
                      params.targetHeight = targetHeight;
                      
                      renderer.getTerrain().queueBrush(params);
+                     stamped = true;
                  }
             } else {
                 ImGui::Text("Hover: None/Sky");
             }
         } else {
-             renderer.triggerPicking(-1, -1); // Cancel picking if UI interaction
+             hoverSelection.hitIndex = -1; // Ignore picks while the UI has the mouse
              renderer.setBrush(0, -1000, 0, 0);
         }
+        if (!stamped) {
+            renderer.getTerrain().endStroke();
+        }
     } else {
         renderer.setBrush(0, -1000, 0, 0);
+        renderer.getTerrain().endStroke();
         renderer.getShowGrid() = false; // Optional: auto-hide grid when tool closed
     }
 
@@ -405,29 +662,35 @@ void EditorUI::buildPanels(engine::renderer::SDFRenderer& renderer, int& selecte
     ImGui::End();
 }
 
-void EditorUI::endFrame(vk::CommandBuffer cmd, vk::ImageView swapchainImageView, vk::Extent2D extent) {
+void EditorUI::endFrame(engine::renderer::RenderGraph& graph, engine::renderer::RenderGraph::ImageHandle target,
+                        vk::ImageView swapchainImageView, vk::Extent2D extent) {
     ImGui::Render();
 
-    // Begin dynamic rendering on the swapchain image
-    VkRenderingAttachmentInfo colorAttachment{};
-    colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
-    colorAttachment.imageView = static_cast<VkImageView>(swapchainImageView);
-    colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-
-    VkRenderingInfo renderInfo{};
-    renderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
-    renderInfo.renderArea.extent = {extent.width, extent.height};
-    renderInfo.layerCount = 1;
-    renderInfo.colorAttachmentCount = 1;
-    renderInfo.pColorAttachments = &colorAttachment;
-
-    pfnCmdBeginRendering(static_cast<VkCommandBuffer>(cmd), &renderInfo);
-
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), static_cast<VkCommandBuffer>(cmd));
-
-    pfnCmdEndRendering(static_cast<VkCommandBuffer>(cmd));
+    // Draw data stays valid until the next NewFrame, after the graph has executed
+    graph.addPass("ImGui Overlay")
+        .write(target, engine::renderer::ResourceUsage::ColorAttachment)
+        .execute([this, swapchainImageView, extent](vk::CommandBuffer cmd) {
+            // Begin dynamic rendering on the swapchain image
+            VkRenderingAttachmentInfo colorAttachment{};
+            colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            colorAttachment.imageView = static_cast<VkImageView>(swapchainImageView);
+            colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+            VkRenderingInfo renderInfo{};
+            renderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+            renderInfo.renderArea.extent = {extent.width, extent.height};
+            renderInfo.layerCount = 1;
+            renderInfo.colorAttachmentCount = 1;
+            renderInfo.pColorAttachments = &colorAttachment;
+
+            pfnCmdBeginRendering(static_cast<VkCommandBuffer>(cmd), &renderInfo);
+
+            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), static_cast<VkCommandBuffer>(cmd));
+
+            pfnCmdEndRendering(static_cast<VkCommandBuffer>(cmd));
+        });
 }
 
 bool EditorUI::wantsCaptureKeyboard() const {
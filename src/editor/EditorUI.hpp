@@ -17,7 +17,9 @@ public:
 
     void beginFrame();
     void buildPanels(engine::renderer::SDFRenderer& renderer, int& selectedIndex);
-    void endFrame(vk::CommandBuffer cmd, vk::ImageView swapchainImageView, vk::Extent2D extent);
+    // Adds the overlay pass drawing into the swapchain image
+    void endFrame(engine::renderer::RenderGraph& graph, engine::renderer::RenderGraph::ImageHandle target,
+                  vk::ImageView swapchainImageView, vk::Extent2D extent);
 
     bool wantsCaptureKeyboard() const;
     bool wantsCaptureMouse() const;
@@ -30,6 +32,8 @@ private:
     PFN_vkCmdBeginRendering pfnCmdBeginRendering = nullptr;
     PFN_vkCmdEndRendering pfnCmdEndRendering = nullptr;
 
+    std::string traceStatus; // Result of the last trace export
+
     void initImGui(GLFWwindow* window);
     void shutdownImGui();
 };
@@ -1,90 +1,202 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 #include "core/Window.hpp"
 #include "core/VulkanContext.hpp"
 #include "core/PhysicsSystem.hpp"
+#include "core/CpuProfiler.hpp"
+#include "core/ImageWriter.hpp"
 #include "renderer/SDFRenderer.hpp"
 #include "editor/EditorUI.hpp"
 
-int main() {
+namespace {
+
+void addDefaultScene(engine::renderer::SDFRenderer& renderer) {
+    auto& edits = renderer.getEdits();
+
+    // Sphere
+    engine::core::SDFEdit sphere{};
+    sphere.position = glm::vec3(0.0f, 1.0f, 5.0f);
+    sphere.rotation = glm::vec4(0, 0, 0, 1);
+    sphere.scale = glm::vec3(1.0f);
+    sphere.primitiveType = 0;
+    sphere.operation = 0;
+    sphere.blendFactor = 0.3f;
+    sphere.material.albedo = glm::vec3(0.9f, 0.3f, 0.2f);
+    sphere.material.roughness = 0.3f;
+    sphere.material.metallic = 0.0f;
+    edits.push_back(sphere);
+
+    // Box
+    engine::core::SDFEdit box{};
+    box.position = glm::vec3(3.0f, 0.8f, 5.0f);
+    box.rotation = glm::vec4(0, 0, 0, 1);
+    box.scale = glm::vec3(0.8f);
+    box.primitiveType = 1;
+    box.operation = 0;
+    box.blendFactor = 0.3f;
+    box.material.albedo = glm::vec3(0.3f, 0.7f, 0.9f);
+    box.material.roughness = 0.5f;
+    box.material.metallic = 0.2f;
+    edits.push_back(box);
+
+    // Torus
+    engine::core::SDFEdit torus{};
+    torus.position = glm::vec3(-2.5f, 0.7f, 6.0f);
+    torus.rotation = glm::vec4(0, 0, 0, 1);
+    torus.scale = glm::vec3(0.8f, 0.25f, 1.0f);
+    torus.primitiveType = 2;
+    torus.operation = 0;
+    torus.blendFactor = 0.3f;
+    torus.material.albedo = glm::vec3(0.9f, 0.8f, 0.2f);
+    torus.material.roughness = 0.3f;
+    torus.material.metallic = 0.8f;
+    edits.push_back(torus);
+
+    renderer.markEditsDirty();
+}
+
+bool parsePresentMode(const std::string& name, vk::PresentModeKHR& mode) {
+    static const std::map<std::string, vk::PresentModeKHR> modes = {
+        { "fifo", vk::PresentModeKHR::eFifo },
+        { "mailbox", vk::PresentModeKHR::eMailbox },
+        { "immediate", vk::PresentModeKHR::eImmediate }
+    };
+    auto it = modes.find(name);
+    if (it == modes.end()) return false;
+    mode = it->second;
+    return true;
+}
+
+struct HeadlessOptions {
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t frames = 60;
+    std::string output = "frame.png";
+};
+
+// Renders a fixed number of frames at a fixed timestep without a window, then
+// writes the last one to disk (.png, .ppm, anything else raw RGBA8)
+int runHeadless(const HeadlessOptions& options, uint32_t framesInFlight) {
+    engine::core::VulkanContext context(options.width, options.height, framesInFlight);
+    engine::renderer::SDFRenderer renderer(context);
+    addDefaultScene(renderer);
+
+    engine::core::InputState input{};
+    const float deltaTime = 1.0f / 60.0f;
+    for (uint32_t frame = 0; frame < options.frames; frame++) {
+        renderer.update(deltaTime, input, false);
+
+        context.beginFrame();
+        renderer.render(context.getRenderGraph());
+        if (!renderer.usesDirectPresent()) {
+            context.endFrameBlit(renderer.getOutputImage());
+        }
+        if (frame + 1 == options.frames) {
+            context.requestCapture();
+        }
+        context.endFramePresent();
+    }
+
+    std::vector<uint8_t> pixels;
+    bool written = context.readCapture(pixels) &&
+                   engine::core::ImageWriter::write(options.output, options.width, options.height, pixels.data());
+    context.getDevice().waitIdle();
+
+    if (!written) {
+        std::cerr << "Failed to write " << options.output << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << options.output << " (" << options.width << "x" << options.height
+              << ", frame " << options.frames << ")" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
     try {
+        // [--frames-in-flight N] [--present-mode fifo|mailbox|immediate] [--low-latency] [--fps-cap N]
+        // --headless [--size WxH] [--frames N] [--output path]
+        bool headless = false;
+        HeadlessOptions headlessOptions;
+        uint32_t framesInFlight = engine::core::VulkanContext::DEFAULT_FRAMES_IN_FLIGHT;
+        vk::PresentModeKHR presentMode = vk::PresentModeKHR::eMailbox;
+        bool lowLatency = false;
+        float frameRateLimit = 0.0f;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--headless") {
+                headless = true;
+            } else if (arg == "--size" && hasValue) {
+                if (std::sscanf(argv[++i], "%ux%u", &headlessOptions.width, &headlessOptions.height) != 2 ||
+                    headlessOptions.width == 0 || headlessOptions.height == 0) {
+                    throw std::runtime_error("--size expects WIDTHxHEIGHT");
+                }
+            } else if (arg == "--frames" && hasValue) {
+                headlessOptions.frames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+            } else if (arg == "--output" && hasValue) {
+                headlessOptions.output = argv[++i];
+            } else if (arg == "--frames-in-flight" && hasValue) {
+                framesInFlight = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+            } else if (arg == "--present-mode" && hasValue) {
+                if (!parsePresentMode(argv[++i], presentMode)) {
+                    throw std::runtime_error("--present-mode expects fifo, mailbox or immediate");
+                }
+            } else if (arg == "--low-latency") {
+                lowLatency = true;
+            } else if (arg == "--fps-cap" && hasValue) {
+                frameRateLimit = static_cast<float>(std::max(0.0, std::atof(argv[++i])));
+            } else {
+                throw std::runtime_error("Unknown argument: " + arg);
+            }
+        }
+        if (headless) {
+            return runHeadless(headlessOptions, framesInFlight);
+        }
+
+        ENGINE_PROFILE_THREAD("Main");
+
         // 1. Window
         engine::core::Window window(1280, 720, "SDF Playground - Vulkan 1.4 + Jolt");
 
         // 2. Vulkan Context
-        engine::core::VulkanContext context(window);
+        engine::core::VulkanContext context(window, framesInFlight, presentMode);
+        context.getLowLatency() = lowLatency;
+        context.getFrameRateLimit() = frameRateLimit;
 
         // 3. Physics
         engine::core::PhysicsSystem physics;
 
         // 4. SDF Renderer
         engine::renderer::SDFRenderer renderer(context);
+        // Edited shaders are recompiled and swapped in while running
+        context.getShaderReload().setEnabled(true);
  
         // 5. Editor UI (ImGui)
         engine::editor::EditorUI editor(context, window.getGLFWwindow());
 
         // 6. Add default scene objects
-        {
-            auto& edits = renderer.getEdits();
-            
-            // Sphere
-            engine::core::SDFEdit sphere{};
-            sphere.position = glm::vec3(0.0f, 1.0f, 5.0f);
-            sphere.rotation = glm::vec4(0, 0, 0, 1);
-            sphere.scale = glm::vec3(1.0f);
-            sphere.primitiveType = 0;
-            sphere.operation = 0;
-            sphere.blendFactor = 0.3f;
-            sphere.material.albedo = glm::vec3(0.9f, 0.3f, 0.2f);
-            sphere.material.roughness = 0.3f;
-            sphere.material.metallic = 0.0f;
-            edits.push_back(sphere);
-
-            // Box
-            engine::core::SDFEdit box{};
-            box.position = glm::vec3(3.0f, 0.8f, 5.0f);
-            box.rotation = glm::vec4(0, 0, 0, 1);
-            box.scale = glm::vec3(0.8f);
-            box.primitiveType = 1;
-            box.operation = 0;
-            box.blendFactor = 0.3f;
-            box.material.albedo = glm::vec3(0.3f, 0.7f, 0.9f);
-            box.material.roughness = 0.5f;
-            box.material.metallic = 0.2f;
-            edits.push_back(box);
-
-            // Torus
-            engine::core::SDFEdit torus{};
-            torus.position = glm::vec3(-2.5f, 0.7f, 6.0f);
-            torus.rotation = glm::vec4(0, 0, 0, 1);
-            torus.scale = glm::vec3(0.8f, 0.25f, 1.0f);
-            torus.primitiveType = 2;
-            torus.operation = 0;
-            torus.blendFactor = 0.3f;
-            torus.material.albedo = glm::vec3(0.9f, 0.8f, 0.2f);
-            torus.material.roughness = 0.3f;
-            torus.material.metallic = 0.8f;
-            edits.push_back(torus);
-
-            renderer.markEditsDirty();
-        }
+        addDefaultScene(renderer);
 
         std::cout << "Playground ready! RMB+WASD to fly, scroll for speed." << std::endl;
 
         // 7. Main Loop
         float lastFrameTime = static_cast<float>(glfwGetTime());
         int selectedEdit = 0;
-        bool pendingPick = false;
+        bool firstFrame = true;
 
         while (!window.shouldClose()) {
+            ENGINE_PROFILE_ZONE("Frame");
+            // Frame cap, and in low latency mode the GPU/present wait, before input is sampled
+            context.waitForFrame();
             window.pollEvents();
-
-            if (pendingPick) {
-                int hit = renderer.getSelection().hitIndex;
-                if (hit > 0) { // 1+ are edits
-                    selectedEdit = hit - 1;
-                }
-                pendingPick = false;
-            }
+            context.markInputSampled();
 
             float currentTime = static_cast<float>(glfwGetTime());
             float deltaTime = currentTime - lastFrameTime;
@@ -97,37 +209,61 @@ int main() {
             physics.update(deltaTime);
             renderer.update(deltaTime, window.getInput(), imguiCapture);
 
-            // Handle picking
+            // F9 dumps the recent CPU zones and GPU scopes into one trace
+            if (window.getInput().isKeyPressed(GLFW_KEY_F9)) {
+                bool written = engine::core::CpuProfiler::exportChromeTrace("trace.json", [&context](std::ostream& out) {
+                    context.getGpuProfiler().writeTraceEvents(out);
+                });
+                std::cout << (written ? "Wrote trace.json" : "Failed to write trace.json") << std::endl;
+            }
+
+            // Handle picking (result arrives a few frames later, without stalling)
             if (window.getInput().mouseClicked[0] && !imguiCapture) {
-                renderer.triggerPicking(
+                renderer.requestPick(
                     static_cast<float>(window.getInput().mouseX), 
-                    static_cast<float>(window.getInput().mouseY)
+                    static_cast<float>(window.getInput().mouseY),
+                    [&selectedEdit](const engine::renderer::SDFRenderer::SelectionData& selection) {
+                        if (selection.hitIndex > 0) { // 1+ are edits
+                            selectedEdit = selection.hitIndex - 1;
+                        }
+                    }
                 );
-                pendingPick = true;
             }
 
             // Begin frame
             context.beginFrame();
-            auto cmd = context.getCurrentCommandBuffer();
+            auto& graph = context.getRenderGraph();
 
             // Compute SDF render
-            renderer.render(cmd);
+            renderer.render(graph);
 
-            // Blit compute result to swapchain
-            context.endFrameBlit(renderer.getOutputImage());
+            // Lighting either wrote the swapchain image already or left the result to blit
+            if (!renderer.usesDirectPresent()) {
+                context.endFrameBlit(renderer.getOutputImage());
+            }
 
             // ImGui overlay
-            editor.beginFrame();
-            editor.buildPanels(renderer, selectedEdit);
+            {
+                ENGINE_PROFILE_ZONE("Editor UI");
+                editor.beginFrame();
+                editor.buildPanels(renderer, selectedEdit);
+            }
             renderer.markEditsDirty(); // Always upload (edits may change via UI)
 
             auto swapExtent = context.getSwapchain()->getExtent();
             auto imageViews = context.getSwapchain()->getImageViews();
             vk::ImageView currentView = imageViews[context.getImageIndex()];
-            editor.endFrame(cmd, currentView, swapExtent);
+            editor.endFrame(graph, context.getTargetImage(), currentView, swapExtent);
 
-            // Present
+            // Present: records every pass with its barriers and submits
             context.endFramePresent();
+
+            // Launch cost up to the first submitted frame, including pipeline variants built on first use
+            if (firstFrame) {
+                firstFrame = false;
+                std::cout << "Startup: first frame submitted after "
+                          << static_cast<int>(engine::core::CpuProfiler::nowUs() / 1000.0) << " ms" << std::endl;
+            }
         }
 
         context.getDevice().waitIdle();
@@ -0,0 +1,153 @@
+#include "BindlessHeap.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace engine::renderer {
+
+BindlessHeap::BindlessHeap(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t framesInFlight)
+    : device(device), framesInFlight(framesInFlight) {
+    auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+    const auto& limits = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+
+    Array& storageImages = arrays[static_cast<uint32_t>(Kind::StorageImage)];
+    storageImages.type = vk::DescriptorType::eStorageImage;
+    storageImages.capacity = std::min({ MAX_STORAGE_IMAGES, limits.maxDescriptorSetUpdateAfterBindStorageImages,
+                                        limits.maxPerStageDescriptorUpdateAfterBindStorageImages });
+
+    Array& sampledImages = arrays[static_cast<uint32_t>(Kind::SampledImage)];
+    sampledImages.type = vk::DescriptorType::eCombinedImageSampler;
+    sampledImages.capacity = std::min({ MAX_SAMPLED_IMAGES, limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                                        limits.maxDescriptorSetUpdateAfterBindSamplers,
+                                        limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                        limits.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+    Array& storageBuffers = arrays[static_cast<uint32_t>(Kind::StorageBuffer)];
+    storageBuffers.type = vk::DescriptorType::eStorageBuffer;
+    storageBuffers.capacity = std::min({ MAX_STORAGE_BUFFERS, limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+                                         limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+    // Slots may be written while the set is bound, and unwritten slots stay empty
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+    std::vector<vk::DescriptorPoolSize> poolSizes;
+    std::vector<vk::DescriptorBindingFlags> bindingFlags;
+    for (uint32_t kind = 0; kind < KIND_COUNT; kind++) {
+        Array& array = arrays[kind];
+        array.slots = TlsfAllocator(array.capacity);
+        bindings.push_back({ kind, array.type, array.capacity, vk::ShaderStageFlagBits::eCompute });
+        poolSizes.push_back({ array.type, array.capacity });
+        bindingFlags.push_back(vk::DescriptorBindingFlagBits::ePartiallyBound |
+                               vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+                               vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending);
+    }
+
+    vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    flagsInfo.pBindingFlags = bindingFlags.data();
+
+    vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    layout = device.createDescriptorSetLayoutUnique(layoutInfo);
+
+    vk::DescriptorPoolCreateInfo poolInfo{};
+    poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    pool = device.createDescriptorPoolUnique(poolInfo);
+
+    vk::DescriptorSetAllocateInfo allocInfo{};
+    allocInfo.descriptorPool = pool.get();
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout.get();
+    set = device.allocateDescriptorSets(allocInfo)[0];
+}
+
+BindlessHeap::~BindlessHeap() {}
+
+BindlessHeap::Index BindlessHeap::allocate(Kind kind, uint32_t count) {
+    Array& array = arrays[static_cast<uint32_t>(kind)];
+    TlsfAllocator::Range range = array.slots.allocate(count, 1);
+    if (range.handle == TlsfAllocator::INVALID) {
+        throw std::runtime_error("Bindless heap is full");
+    }
+    Index index = static_cast<Index>(range.offset);
+    array.handles[index] = range.handle;
+    return index;
+}
+
+void BindlessHeap::write(Kind kind, Index index, const vk::DescriptorImageInfo* images,
+                         const vk::DescriptorBufferInfo* buffer, uint32_t count) {
+    vk::WriteDescriptorSet write{ set, static_cast<uint32_t>(kind), index, count,
+                                  arrays[static_cast<uint32_t>(kind)].type, images, buffer, nullptr };
+    device.updateDescriptorSets(write, nullptr);
+}
+
+BindlessHeap::Index BindlessHeap::addStorageImage(vk::ImageView view) {
+    Index index = allocate(Kind::StorageImage, 1);
+    setStorageImage(index, view);
+    return index;
+}
+
+BindlessHeap::Index BindlessHeap::addStorageImages(const std::vector<vk::ImageView>& views) {
+    Index index = allocate(Kind::StorageImage, static_cast<uint32_t>(views.size()));
+    std::vector<vk::DescriptorImageInfo> infos;
+    for (vk::ImageView view : views) {
+        infos.push_back({ nullptr, view, vk::ImageLayout::eGeneral });
+    }
+    write(Kind::StorageImage, index, infos.data(), nullptr, static_cast<uint32_t>(infos.size()));
+    return index;
+}
+
+BindlessHeap::Index BindlessHeap::addSampledImage(vk::ImageView view, vk::Sampler sampler) {
+    Index index = allocate(Kind::SampledImage, 1);
+    setSampledImage(index, view, sampler);
+    return index;
+}
+
+BindlessHeap::Index BindlessHeap::addStorageBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range) {
+    Index index = allocate(Kind::StorageBuffer, 1);
+    setStorageBuffer(index, buffer, offset, range);
+    return index;
+}
+
+void BindlessHeap::setStorageImage(Index index, vk::ImageView view) {
+    vk::DescriptorImageInfo info{ nullptr, view, vk::ImageLayout::eGeneral };
+    write(Kind::StorageImage, index, &info, nullptr, 1);
+}
+
+void BindlessHeap::setSampledImage(Index index, vk::ImageView view, vk::Sampler sampler) {
+    vk::DescriptorImageInfo info{ sampler, view, vk::ImageLayout::eGeneral };
+    write(Kind::SampledImage, index, &info, nullptr, 1);
+}
+
+void BindlessHeap::setStorageBuffer(Index index, vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range) {
+    vk::DescriptorBufferInfo info{ buffer, offset, range };
+    write(Kind::StorageBuffer, index, nullptr, &info, 1);
+}
+
+void BindlessHeap::release(Kind kind, Index index) {
+    if (index == INVALID) return;
+    released.push_back({ frameCounter, kind, index });
+}
+
+void BindlessHeap::beginFrame() {
+    frameCounter++;
+    while (!released.empty() && released.front().frame + framesInFlight <= frameCounter) {
+        Array& array = arrays[static_cast<uint32_t>(released.front().kind)];
+        auto it = array.handles.find(released.front().index);
+        if (it != array.handles.end()) {
+            array.slots.free(it->second);
+            array.handles.erase(it);
+        }
+        released.pop_front();
+    }
+}
+
+uint32_t BindlessHeap::getUsed(Kind kind) const {
+    return static_cast<uint32_t>(arrays[static_cast<uint32_t>(kind)].slots.getUsed());
+}
+
+} // namespace engine::renderer
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "TlsfAllocator.hpp"
+
+namespace engine::renderer {
+
+// Global descriptor heap shared by every compute pipeline as set 0: one update-after-bind
+// set holding large, partially bound arrays of storage images, combined image samplers
+// and storage buffers. Resources are added once and keep their index, which shaders get
+// through push constants (directly or via a resource table buffer), so new resources
+// never change a layout or need a rebind. Used from the main thread.
+class BindlessHeap {
+public:
+    using Index = uint32_t;
+    static constexpr Index INVALID = UINT32_MAX;
+
+    // Value is the binding of the array; must match common/Bindless.glsl
+    enum class Kind : uint32_t {
+        StorageImage = 0,
+        SampledImage = 1,
+        StorageBuffer = 2
+    };
+    static constexpr uint32_t KIND_COUNT = 3;
+
+    BindlessHeap(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t framesInFlight);
+    ~BindlessHeap();
+
+    // Images are accessed in eGeneral, the layout the render graph keeps them in
+    Index addStorageImage(vk::ImageView view);
+    // Consecutive slots (e.g. one per mip level), addressed as first index + i
+    Index addStorageImages(const std::vector<vk::ImageView>& views);
+    Index addSampledImage(vk::ImageView view, vk::Sampler sampler);
+    // offset must be a multiple of minStorageBufferOffsetAlignment
+    Index addStorageBuffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+
+    // Point a slot at a new resource in place. Only for slots no frame in flight can
+    // still read (e.g. after a waitIdle); otherwise release the slot and add a new one.
+    void setStorageImage(Index index, vk::ImageView view);
+    void setSampledImage(Index index, vk::ImageView view, vk::Sampler sampler);
+    void setStorageBuffer(Index index, vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+
+    // Frees a slot (or a whole addStorageImages range) once the frames in flight are done with it
+    void release(Kind kind, Index index);
+
+    // Frame start, after the frame's fence wait: recycles slots released framesInFlight frames ago
+    void beginFrame();
+
+    vk::DescriptorSetLayout getLayout() const { return layout.get(); }
+    vk::DescriptorSet getSet() const { return set; }
+    void bind(vk::CommandBuffer cmd, vk::PipelineLayout pipelineLayout) const {
+        cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, 1, &set, 0, nullptr);
+    }
+
+    uint32_t getCapacity(Kind kind) const { return arrays[static_cast<uint32_t>(kind)].capacity; }
+    uint32_t getUsed(Kind kind) const;
+
+    // Array sizes, lowered to the device's update-after-bind limits
+    static constexpr uint32_t MAX_STORAGE_IMAGES = 8192;
+    static constexpr uint32_t MAX_SAMPLED_IMAGES = 8192;
+    static constexpr uint32_t MAX_STORAGE_BUFFERS = 8192;
+
+private:
+    struct Array {
+        vk::DescriptorType type;
+        uint32_t capacity = 0;
+        TlsfAllocator slots{ 1 };
+        std::unordered_map<Index, uint32_t> handles; // First slot -> allocator handle
+    };
+
+    struct Released {
+        uint64_t frame;
+        Kind kind;
+        Index index;
+    };
+
+    vk::Device device;
+    uint32_t framesInFlight;
+    vk::UniqueDescriptorSetLayout layout;
+    vk::UniqueDescriptorPool pool;
+    vk::DescriptorSet set;
+    Array arrays[KIND_COUNT];
+
+    std::deque<Released> released;
+    uint64_t frameCounter = 0;
+
+    Index allocate(Kind kind, uint32_t count);
+    void write(Kind kind, Index index, const vk::DescriptorImageInfo* images, const vk::DescriptorBufferInfo* buffer, uint32_t count);
+};
+
+} // namespace engine::renderer
@@ -3,9 +3,10 @@
 
 namespace engine::renderer {
 
-ComputePipeline::ComputePipeline(vk::Device device, const std::string& shaderPath, const std::vector<vk::DescriptorSetLayout>& layouts,
-                                 const std::vector<vk::PushConstantRange>& pushConstantRanges)
-    : device(device) {
+ComputePipeline::ComputePipeline(vk::Device device, vk::PipelineCache pipelineCache, const std::string& shaderPath, const std::vector<vk::DescriptorSetLayout>& layouts,
+                                 const std::vector<vk::PushConstantRange>& pushConstantRanges,
+                                 const SpecializationConstants& defaultConstants)
+    : device(device), pipelineCache(pipelineCache), shaderPath(shaderPath), defaultConstants(defaultConstants) {
     
     // Load SPIR-V binary
     std::ifstream file(shaderPath, std::ios::ate | std::ios::binary);
@@ -16,6 +17,7 @@ ComputePipeline::ComputePipeline(vk::Device device, const std::string& shaderPat
         if (!file.is_open()) {
             throw std::runtime_error("failed to open shader file: " + shaderPath + " (also checked " + fallback + ")");
         }
+        this->shaderPath = fallback;
     }
 
     size_t fileSize = (size_t)file.tellg();
@@ -24,8 +26,6 @@ ComputePipeline::ComputePipeline(vk::Device device, const std::string& shaderPat
     file.read((char*)buffer.data(), fileSize);
     file.close();
 
-    vk::UniqueShaderModule shaderModule = createShaderModule(buffer);
-
     vk::PipelineLayoutCreateInfo layoutInfo{};
     layoutInfo.setLayoutCount = static_cast<uint32_t>(layouts.size());
     layoutInfo.pSetLayouts = layouts.data();
@@ -33,23 +33,87 @@ ComputePipeline::ComputePipeline(vk::Device device, const std::string& shaderPat
     layoutInfo.pPushConstantRanges = pushConstantRanges.data();
     pipelineLayout = device.createPipelineLayoutUnique(layoutInfo);
 
-    vk::ComputePipelineCreateInfo pipelineInfo{};
-    pipelineInfo.layout = pipelineLayout.get();
-    pipelineInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
-    pipelineInfo.stage.module = shaderModule.get();
-    pipelineInfo.stage.pName = "main";
-
-    auto result = device.createComputePipelineUnique(nullptr, pipelineInfo);
-    pipeline = std::move(result.value);
+    // The module is kept alive so further specialized variants can be created later
+    program = buildProgram(device, pipelineCache, pipelineLayout.get(), buffer, { defaultConstants });
+    defaultPipeline = getPipeline(defaultConstants);
 }
 
 ComputePipeline::~ComputePipeline() {}
 
-vk::UniqueShaderModule ComputePipeline::createShaderModule(const std::vector<uint32_t>& code) {
+vk::Pipeline ComputePipeline::getPipeline(const SpecializationConstants& constants) {
+    auto it = program.variants.find(constants);
+    if (it == program.variants.end()) {
+        auto variant = createVariant(device, pipelineCache, pipelineLayout.get(), program.module.get(), constants);
+        it = program.variants.emplace(constants, std::move(variant)).first;
+    }
+    return it->second.get();
+}
+
+std::vector<SpecializationConstants> ComputePipeline::getVariantKeys() const {
+    std::vector<SpecializationConstants> keys;
+    keys.reserve(program.variants.size());
+    for (const auto& [constants, pipeline] : program.variants) {
+        keys.push_back(constants);
+    }
+    return keys;
+}
+
+ComputePipeline::Program ComputePipeline::buildProgram(vk::Device device, vk::PipelineCache pipelineCache, vk::PipelineLayout layout,
+                                                       const std::vector<uint32_t>& spirv,
+                                                       const std::vector<SpecializationConstants>& keys) {
     vk::ShaderModuleCreateInfo createInfo{};
-    createInfo.codeSize = code.size() * sizeof(uint32_t);
-    createInfo.pCode = code.data();
-    return device.createShaderModuleUnique(createInfo);
+    createInfo.codeSize = spirv.size() * sizeof(uint32_t);
+    createInfo.pCode = spirv.data();
+
+    Program built;
+    built.spirv = spirv;
+    built.module = device.createShaderModuleUnique(createInfo);
+    for (const auto& constants : keys) {
+        built.variants.emplace(constants, createVariant(device, pipelineCache, layout, built.module.get(), constants));
+    }
+    return built;
+}
+
+ComputePipeline::Program ComputePipeline::replaceProgram(Program&& rebuilt) {
+    Program previous = std::move(program);
+    program = std::move(rebuilt);
+    defaultPipeline = getPipeline(defaultConstants);
+    return previous;
+}
+
+void ComputePipeline::addVariants(Program&& built) {
+    if (built.spirv != program.spirv) return;
+    for (auto& [constants, pipeline] : built.variants) {
+        program.variants.try_emplace(constants, std::move(pipeline));
+    }
+}
+
+vk::UniquePipeline ComputePipeline::createVariant(vk::Device device, vk::PipelineCache pipelineCache, vk::PipelineLayout layout,
+                                                  vk::ShaderModule module, const SpecializationConstants& constants) {
+    std::vector<vk::SpecializationMapEntry> entries;
+    std::vector<uint32_t> data;
+    entries.reserve(constants.size());
+    data.reserve(constants.size());
+    for (const auto& [id, value] : constants) {
+        entries.emplace_back(id, static_cast<uint32_t>(data.size() * sizeof(uint32_t)), sizeof(uint32_t));
+        data.push_back(value);
+    }
+
+    vk::SpecializationInfo specInfo{};
+    specInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+    specInfo.pMapEntries = entries.data();
+    specInfo.dataSize = data.size() * sizeof(uint32_t);
+    specInfo.pData = data.data();
+
+    vk::ComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.layout = layout;
+    pipelineInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.stage.pSpecializationInfo = constants.empty() ? nullptr : &specInfo;
+
+    auto result = device.createComputePipelineUnique(pipelineCache, pipelineInfo);
+    return std::move(result.value);
 }
 
 } // namespace engine::renderer
@@ -1,26 +1,72 @@
 #pragma once
 
 #include <vulkan/vulkan.hpp>
+#include <bit>
+#include <cstdint>
+#include <map>
 #include <vector>
 #include <string>
 
 namespace engine::renderer {
 
+// Specialization constant values keyed by constant_id. Every value is 32 bits
+// (int, uint, bool as VkBool32, or float via specFloat). IDs the shader does not
+// declare are ignored, so one set can be shared by several pipelines.
+using SpecializationConstants = std::map<uint32_t, uint32_t>;
+
+inline uint32_t specFloat(float value) { return std::bit_cast<uint32_t>(value); }
+
 class ComputePipeline {
 public:
-    ComputePipeline(vk::Device device, const std::string& shaderPath, const std::vector<vk::DescriptorSetLayout>& layouts, 
-                    const std::vector<vk::PushConstantRange>& pushConstantRanges = {});
+    // pipelineCache may be null; VulkanContext's is persisted across runs
+    ComputePipeline(vk::Device device, vk::PipelineCache pipelineCache, const std::string& shaderPath, const std::vector<vk::DescriptorSetLayout>& layouts, 
+                    const std::vector<vk::PushConstantRange>& pushConstantRanges = {},
+                    const SpecializationConstants& defaultConstants = {});
     ~ComputePipeline();
 
-    vk::Pipeline getPipeline() const { return pipeline.get(); }
+    // Variant built with the constructor's default constants
+    vk::Pipeline getPipeline() const { return defaultPipeline; }
+    // Variant for the given constants, compiled on first use and cached afterwards
+    vk::Pipeline getPipeline(const SpecializationConstants& constants);
+    bool hasVariant(const SpecializationConstants& constants) const { return program.variants.contains(constants); }
     vk::PipelineLayout getLayout() const { return pipelineLayout.get(); }
 
+    // Shader module plus every variant compiled from it
+    struct Program {
+        std::vector<uint32_t> spirv; // Source of the module, for variants built off-thread
+        vk::UniqueShaderModule module;
+        std::map<SpecializationConstants, vk::UniquePipeline> variants;
+    };
+
+    // SPIR-V file the pipeline was loaded from (after the build/ fallback)
+    const std::string& getShaderPath() const { return shaderPath; }
+    // SPIR-V of the current program, which follows hot reloads
+    const std::vector<uint32_t>& getSpirv() const { return program.spirv; }
+    std::vector<SpecializationConstants> getVariantKeys() const;
+    // Compiles a program with the given variants. Reads no member state, so shader hot
+    // reload can run it on a worker thread while this pipeline keeps being used.
+    static Program buildProgram(vk::Device device, vk::PipelineCache pipelineCache, vk::PipelineLayout layout,
+                                const std::vector<uint32_t>& spirv, const std::vector<SpecializationConstants>& keys);
+    // Swaps in a rebuilt program; returns the old one, which frames in flight may still use.
+    // Variants missing from the new program are compiled from it on first use.
+    Program replaceProgram(Program&& rebuilt);
+    // Adds variants built elsewhere with buildProgram; ones already present are kept.
+    // Pipelines do not reference their module after creation, so the built one is dropped.
+    // A build from SPIR-V that a hot reload has replaced since is discarded whole, leaving
+    // its variants missing so the caller builds them again.
+    void addVariants(Program&& built);
+
 private:
     vk::Device device;
+    vk::PipelineCache pipelineCache;
+    std::string shaderPath;
     vk::UniquePipelineLayout pipelineLayout;
-    vk::UniquePipeline pipeline;
+    Program program;
+    SpecializationConstants defaultConstants;
+    vk::Pipeline defaultPipeline;
 
-    vk::UniqueShaderModule createShaderModule(const std::vector<uint32_t>& code);
+    static vk::UniquePipeline createVariant(vk::Device device, vk::PipelineCache pipelineCache, vk::PipelineLayout layout,
+                                            vk::ShaderModule module, const SpecializationConstants& constants);
 };
 
 } // namespace engine::renderer
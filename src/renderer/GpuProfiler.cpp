@@ -0,0 +1,177 @@
+#include "GpuProfiler.hpp"
+#include "core/CpuProfiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace engine::renderer {
+
+namespace {
+
+// Pass names are plain identifiers, but keep the JSON valid regardless
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+GpuProfiler::GpuProfiler(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t framesInFlight)
+    : device(device) {
+    auto limits = physicalDevice.getProperties().limits;
+    uint32_t validBits = physicalDevice.getQueueFamilyProperties()[queueFamily].timestampValidBits;
+    supported = validBits > 0 && limits.timestampPeriod > 0.0f;
+    if (!supported) {
+        std::cout << "GPU profiler: timestamps not supported on the graphics queue" << std::endl;
+        return;
+    }
+
+    timestampPeriodNs = limits.timestampPeriod;
+    timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+    vk::QueryPoolCreateInfo poolInfo{};
+    poolInfo.queryType = vk::QueryType::eTimestamp;
+    poolInfo.queryCount = MAX_SCOPES * 2;
+
+    slots.resize(framesInFlight);
+    for (auto& slot : slots) {
+        slot.pool = device.createQueryPoolUnique(poolInfo);
+    }
+}
+
+void GpuProfiler::beginFrame(vk::CommandBuffer cmd, uint32_t frameSlot) {
+    current = nullptr;
+    if (!supported) return;
+
+    FrameSlot& slot = slots[frameSlot];
+    if (slot.recorded) {
+        collect(slot);
+    }
+
+    slot.queryCount = 0;
+    slot.scopes.clear();
+    slot.open.clear();
+    slot.recorded = false;
+    if (!enabled) return;
+
+    cmd.resetQueryPool(slot.pool.get(), 0, MAX_SCOPES * 2);
+    slot.frameNumber = frameCounter++;
+    current = &slot;
+}
+
+void GpuProfiler::beginScope(vk::CommandBuffer cmd, const std::string& name) {
+    if (!current || current->queryCount + 2 > MAX_SCOPES * 2) return;
+
+    uint32_t query = current->queryCount;
+    current->queryCount += 2;
+    current->open.push_back(static_cast<uint32_t>(current->scopes.size()));
+    current->scopes.push_back({ name, query, query + 1 });
+
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, current->pool.get(), query);
+}
+
+void GpuProfiler::endScope(vk::CommandBuffer cmd) {
+    if (!current || current->open.empty()) return;
+
+    const PendingScope& scope = current->scopes[current->open.back()];
+    current->open.pop_back();
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, current->pool.get(), scope.endQuery);
+}
+
+void GpuProfiler::endFrame() {
+    if (!current) return;
+
+    // Scopes left open (or dropped past MAX_SCOPES) have no end query written
+    for (uint32_t index : current->open) {
+        current->scopes[index].endQuery = UINT32_MAX;
+    }
+    current->open.clear();
+    current->submitUs = core::CpuProfiler::nowUs();
+    current->recorded = true;
+    current = nullptr;
+}
+
+void GpuProfiler::flush() {
+    // Oldest frame first, so the history stays in order
+    std::vector<FrameSlot*> recorded;
+    for (auto& slot : slots) {
+        if (slot.recorded) recorded.push_back(&slot);
+    }
+    std::sort(recorded.begin(), recorded.end(), [](const FrameSlot* a, const FrameSlot* b) {
+        return a->frameNumber < b->frameNumber;
+    });
+    for (FrameSlot* slot : recorded) {
+        collect(*slot);
+        slot->recorded = false;
+    }
+}
+
+void GpuProfiler::collect(FrameSlot& slot) {
+    if (slot.queryCount == 0) return;
+
+    // The slot's fence has signalled, so every written query is available
+    std::vector<uint64_t> timestamps(slot.queryCount);
+    vk::Result result = device.getQueryPoolResults(
+        slot.pool.get(), 0, slot.queryCount,
+        timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64
+    );
+    if (result != vk::Result::eSuccess) return;
+
+    FrameTimings frame;
+    frame.frameNumber = slot.frameNumber;
+    frame.submitUs = slot.submitUs;
+
+    uint64_t first = UINT64_MAX, last = 0;
+    for (const auto& scope : slot.scopes) {
+        if (scope.endQuery == UINT32_MAX) continue;
+        first = std::min(first, timestamps[scope.beginQuery] & timestampMask);
+        last = std::max(last, timestamps[scope.endQuery] & timestampMask);
+    }
+    if (first == UINT64_MAX) return;
+
+    auto toMs = [&](uint64_t ticks) { return static_cast<double>(ticks - first) * timestampPeriodNs * 1e-6; };
+    for (const auto& scope : slot.scopes) {
+        if (scope.endQuery == UINT32_MAX) continue;
+        frame.scopes.push_back({ scope.name, toMs(timestamps[scope.beginQuery] & timestampMask),
+                                 toMs(timestamps[scope.endQuery] & timestampMask) });
+    }
+    frame.gpuMs = toMs(last);
+
+    history.push_back(std::move(frame));
+    while (history.size() > HISTORY_FRAMES) {
+        history.pop_front();
+    }
+}
+
+bool GpuProfiler::exportChromeTrace(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":1,\"args\":{\"sort_index\":1}}";
+    writeTraceEvents(file);
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
+
+void GpuProfiler::writeTraceEvents(std::ostream& out) const {
+    // GPU and CPU clocks are not calibrated against each other: each frame's scopes are
+    // placed from the moment it was submitted, which keeps them in order on the timeline
+    out << ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}";
+    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Graphics Queue\"}}";
+    for (const auto& frame : history) {
+        for (const auto& scope : frame.scopes) {
+            out << ",\n{\"name\":\"" << escapeJson(scope.name) << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":0"
+                << ",\"ts\":" << frame.submitUs + scope.startMs * 1000.0
+                << ",\"dur\":" << (scope.endMs - scope.startMs) * 1000.0
+                << ",\"args\":{\"frame\":" << frame.frameNumber << "}}";
+        }
+    }
+}
+
+} // namespace engine::renderer
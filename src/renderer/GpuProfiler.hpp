@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace engine::renderer {
+
+// GPU timestamps around named scopes, one query pool per frame in flight. A slot's
+// results are read in beginFrame, after its fence has signalled, so reading never
+// waits on the GPU; timings therefore lag recording by the number of frames in flight.
+class GpuProfiler {
+public:
+    struct Scope {
+        std::string name;
+        double startMs; // Relative to the frame's first timestamp
+        double endMs;
+    };
+
+    struct FrameTimings {
+        uint64_t frameNumber = 0;
+        double submitUs = 0.0; // CPU time of the submission, on the profiler's clock
+        double gpuMs = 0.0;    // First to last timestamp
+        std::vector<Scope> scopes;
+    };
+
+    GpuProfiler(vk::Device device, vk::PhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t framesInFlight);
+
+    // False when the queue cannot write timestamps; every call is then a no-op
+    bool isSupported() const { return supported; }
+    bool& getEnabled() { return enabled; }
+
+    // Collects the slot's previous results and resets its queries; call right after the fence wait
+    void beginFrame(vk::CommandBuffer cmd, uint32_t frameSlot);
+    void beginScope(vk::CommandBuffer cmd, const std::string& name);
+    void endScope(vk::CommandBuffer cmd);
+    // Marks the frame as submitted now
+    void endFrame();
+    // Collects every submitted slot; only valid once the device is idle
+    void flush();
+
+    // Oldest first, up to HISTORY_FRAMES
+    const std::deque<FrameTimings>& getHistory() const { return history; }
+    // Writes the history as Chrome trace events ("X" phase, microseconds) on a "GPU" track
+    bool exportChromeTrace(const std::string& path) const;
+    // Appends the same events to an open trace, each with a leading ",\n" (see CpuProfiler::exportChromeTrace)
+    void writeTraceEvents(std::ostream& out) const;
+
+    static constexpr uint32_t MAX_SCOPES = 64;
+    static constexpr size_t HISTORY_FRAMES = 240;
+
+private:
+    struct PendingScope {
+        std::string name;
+        uint32_t beginQuery, endQuery;
+    };
+
+    struct FrameSlot {
+        vk::UniqueQueryPool pool;
+        uint32_t queryCount = 0;
+        std::vector<PendingScope> scopes;
+        std::vector<uint32_t> open; // Indices into scopes still waiting for endScope
+        uint64_t frameNumber = 0;
+        double submitUs = 0.0;
+        bool recorded = false;
+    };
+
+    vk::Device device;
+    bool supported = false;
+    bool enabled = true;
+    double timestampPeriodNs = 1.0;
+    uint64_t timestampMask = ~0ull;
+
+    std::vector<FrameSlot> slots;
+    FrameSlot* current = nullptr;
+    uint64_t frameCounter = 0;
+    std::deque<FrameTimings> history;
+
+    void collect(FrameSlot& slot);
+};
+
+} // namespace engine::renderer
@@ -0,0 +1,66 @@
+#include "ParallelRecorder.hpp"
+#include "core/CpuProfiler.hpp"
+#include <algorithm>
+
+namespace engine::renderer {
+
+ParallelRecorder::ParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t threadCount)
+    : device(device), threadPool(std::clamp(threadCount, 1u, MAX_THREADS) - 1, "Command Recording") {
+    // Short-lived buffers, reset as a whole pool once per frame
+    vk::CommandPoolCreateInfo poolInfo{};
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    poolInfo.queueFamilyIndex = queueFamily;
+
+    pools.resize(framesInFlight);
+    for (auto& framePools : pools) {
+        framePools.resize(threadPool.getThreadCount());
+        for (auto& thread : framePools) {
+            thread.pool = device.createCommandPoolUnique(poolInfo);
+        }
+    }
+}
+
+ParallelRecorder::~ParallelRecorder() {}
+
+void ParallelRecorder::beginFrame(uint32_t frame) {
+    currentFrame = frame;
+    for (auto& thread : pools[frame]) {
+        device.resetCommandPool(thread.pool.get());
+        thread.used = 0;
+    }
+}
+
+vk::CommandBuffer ParallelRecorder::acquire(uint32_t thread) {
+    ThreadCommands& commands = pools[currentFrame][thread];
+    if (commands.used == commands.buffers.size()) {
+        vk::CommandBufferAllocateInfo allocInfo{};
+        allocInfo.commandPool = commands.pool.get();
+        allocInfo.level = vk::CommandBufferLevel::eSecondary;
+        allocInfo.commandBufferCount = 1;
+        commands.buffers.push_back(device.allocateCommandBuffers(allocInfo)[0]);
+    }
+    return commands.buffers[commands.used++];
+}
+
+std::vector<vk::CommandBuffer> ParallelRecorder::record(const std::vector<const RecordFn*>& jobs) {
+    ENGINE_PROFILE_ZONE("Parallel Record");
+    std::vector<vk::CommandBuffer> recorded(jobs.size());
+
+    threadPool.run(static_cast<uint32_t>(jobs.size()), [&](uint32_t index, uint32_t thread) {
+        ENGINE_PROFILE_ZONE("Record Secondary");
+        vk::CommandBuffer cmd = acquire(thread);
+
+        vk::CommandBufferInheritanceInfo inheritance{};
+        vk::CommandBufferBeginInfo beginInfo{};
+        beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+        beginInfo.pInheritanceInfo = &inheritance;
+        cmd.begin(beginInfo);
+        (*jobs[index])(cmd);
+        cmd.end();
+
+        recorded[index] = cmd;
+    });
+    return recorded;
+}
+
+} // namespace engine::renderer
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <functional>
+#include <vector>
+#include "core/ThreadPool.hpp"
+
+namespace engine::renderer {
+
+// Records command buffer callbacks into secondary command buffers on worker threads.
+// Every thread has its own command pool per frame in flight, so recording takes no
+// locks; a pool is reset only after its frame's fence has been waited on. The caller
+// stitches the results into the frame's primary command buffer with executeCommands,
+// in whatever order it submits work.
+class ParallelRecorder {
+public:
+    using RecordFn = std::function<void(vk::CommandBuffer)>;
+
+    // threadCount includes the calling thread; 1 records everything on the caller
+    ParallelRecorder(vk::Device device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t threadCount);
+    ~ParallelRecorder();
+
+    // Frame start, after the frame's fence wait: recycles the command buffers of that slot
+    void beginFrame(uint32_t frame);
+
+    // Records jobs[i] into the i-th returned secondary command buffer and returns once all
+    // are recorded. Jobs run concurrently, so they must not write state another job reads
+    // (e.g. compile pipeline variants up front). No render pass is inherited; state such
+    // as pipelines, descriptor sets and push constants is not inherited either.
+    std::vector<vk::CommandBuffer> record(const std::vector<const RecordFn*>& jobs);
+
+    uint32_t getThreadCount() const { return threadPool.getThreadCount(); }
+
+    // Upper bound for threadCount
+    static constexpr uint32_t MAX_THREADS = 8;
+
+private:
+    struct ThreadCommands {
+        vk::UniqueCommandPool pool;
+        std::vector<vk::CommandBuffer> buffers; // Freed with the pool
+        uint32_t used = 0;
+    };
+
+    vk::Device device;
+    std::vector<std::vector<ThreadCommands>> pools; // [frame][thread]
+    uint32_t currentFrame = 0;
+    core::ThreadPool threadPool; // Declared last: workers stop before the pools go
+
+    vk::CommandBuffer acquire(uint32_t thread);
+};
+
+} // namespace engine::renderer
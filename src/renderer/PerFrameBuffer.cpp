@@ -0,0 +1,31 @@
+#include "PerFrameBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace engine::renderer {
+
+PerFrameBuffer::PerFrameBuffer(ResourceManager& resourceManager, vk::DeviceSize slotSize, vk::DeviceSize alignment,
+                               uint32_t framesInFlight, vk::BufferUsageFlags usage)
+    : slotSize(slotSize), slotVersions(framesInFlight, 0) {
+    alignment = std::max<vk::DeviceSize>(alignment, 1);
+    slotStride = (slotSize + alignment - 1) / alignment * alignment;
+    buffer = resourceManager.createBuffer(
+        slotStride * framesInFlight,
+        usage,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+    );
+}
+
+bool PerFrameBuffer::update(uint32_t frame, const void* data, vk::DeviceSize size) {
+    if (slotVersions[frame] == version) return false;
+    slotVersions[frame] = version;
+
+    size = std::min(size, slotSize);
+    if (size > 0) {
+        auto* slot = static_cast<uint8_t*>(buffer.memory.getMappedData()) + slotStride * frame;
+        std::memcpy(slot, data, size);
+    }
+    return true;
+}
+
+} // namespace engine::renderer
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+#include "ResourceManager.hpp"
+
+namespace engine::renderer {
+
+// Host-written data the GPU reads every frame, with one copy per frame in flight. The
+// copies are slots of a single persistently mapped buffer, each bound as its own storage
+// buffer range (one bindless heap slot per frame). Writes go to the slot of the frame
+// being recorded, whose fence beginFrame has already waited on, so an earlier frame
+// never sees them.
+class PerFrameBuffer {
+public:
+    PerFrameBuffer() = default;
+    // slotSize is rounded up to alignment (minStorageBufferOffsetAlignment)
+    PerFrameBuffer(ResourceManager& resourceManager, vk::DeviceSize slotSize, vk::DeviceSize alignment,
+                   uint32_t framesInFlight, vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer);
+
+    // New contents: every slot is rewritten by its frame's next update
+    void invalidate() { version++; }
+    // Copies size bytes into frame's slot unless it already holds the current version.
+    // Returns whether anything was written.
+    bool update(uint32_t frame, const void* data, vk::DeviceSize size);
+
+    vk::Buffer getBuffer() const { return buffer.buffer.get(); }
+    // Descriptor range: one slot
+    vk::DeviceSize getSlotSize() const { return slotSize; }
+    // Byte offset of frame's slot
+    vk::DeviceSize getOffset(uint32_t frame) const { return slotStride * frame; }
+
+private:
+    ResourceManager::Buffer buffer;
+    vk::DeviceSize slotSize = 0;
+    vk::DeviceSize slotStride = 0;
+    uint64_t version = 1;
+    std::vector<uint64_t> slotVersions; // Version each slot holds; 0 = never written
+};
+
+} // namespace engine::renderer
@@ -0,0 +1,602 @@
+#include "RenderGraph.hpp"
+#include "ResourceManager.hpp"
+#include "GpuProfiler.hpp"
+#include "ParallelRecorder.hpp"
+#include "core/CpuProfiler.hpp"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+namespace engine::renderer {
+
+namespace {
+
+struct UsageInfo {
+    vk::PipelineStageFlags stages;
+    vk::AccessFlags access;
+    vk::ImageLayout layout;
+};
+
+UsageInfo usageInfo(ResourceUsage usage) {
+    switch (usage) {
+    case ResourceUsage::ComputeRead:
+        return { vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eGeneral };
+    case ResourceUsage::ComputeWrite:
+        return { vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite, vk::ImageLayout::eGeneral };
+    case ResourceUsage::ComputeReadWrite:
+        return { vk::PipelineStageFlagBits::eComputeShader,
+                 vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, vk::ImageLayout::eGeneral };
+    case ResourceUsage::IndirectRead:
+        return { vk::PipelineStageFlagBits::eDrawIndirect, vk::AccessFlagBits::eIndirectCommandRead, vk::ImageLayout::eGeneral };
+    case ResourceUsage::TransferRead:
+        return { vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead, vk::ImageLayout::eTransferSrcOptimal };
+    case ResourceUsage::TransferWrite:
+        return { vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eTransferDstOptimal };
+    case ResourceUsage::ColorAttachment:
+        return { vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                 vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite,
+                 vk::ImageLayout::eColorAttachmentOptimal };
+    case ResourceUsage::HostRead:
+        return { vk::PipelineStageFlagBits::eHost, vk::AccessFlagBits::eHostRead, vk::ImageLayout::eGeneral };
+    case ResourceUsage::Present:
+        return { vk::PipelineStageFlagBits::eBottomOfPipe, vk::AccessFlagBits::eNone, vk::ImageLayout::ePresentSrcKHR };
+    }
+    throw std::runtime_error("Unknown resource usage");
+}
+
+const vk::AccessFlags WRITE_ACCESS = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite |
+                                     vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eHostWrite |
+                                     vk::AccessFlagBits::eMemoryWrite;
+
+// A pass's uses of one resource range, combined
+struct Access {
+    bool isImage;
+    uint32_t resource;
+    uint32_t baseMip, mipCount;
+    UsageInfo info;
+    bool write;
+    bool discard;
+};
+
+bool rangesOverlap(uint32_t baseA, uint32_t countA, uint32_t baseB, uint32_t countB) {
+    return baseA < baseB + countB && baseB < baseA + countA;
+}
+
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ImageHandle image, ResourceUsage usage, uint32_t baseMip, uint32_t mipCount) {
+    uses.push_back({ true, image.index, usage, false, false, baseMip, mipCount });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ImageHandle image, ResourceUsage usage, uint32_t baseMip, uint32_t mipCount) {
+    uses.push_back({ true, image.index, usage, true, false, baseMip, mipCount });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::discard(ImageHandle image, ResourceUsage usage) {
+    uses.push_back({ true, image.index, usage, true, true, 0, VK_REMAINING_MIP_LEVELS });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(BufferHandle buffer, ResourceUsage usage) {
+    uses.push_back({ false, buffer.index, usage, false, false, 0, 1 });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(BufferHandle buffer, ResourceUsage usage) {
+    uses.push_back({ false, buffer.index, usage, true, false, 0, 1 });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::execute(std::function<void(vk::CommandBuffer)> fn) {
+    callback = std::move(fn);
+    return *this;
+}
+
+RenderGraph::RenderGraph(vk::Device device, ResourceManager& resourceManager)
+    : device(device), resourceManager(resourceManager) {}
+
+RenderGraph::~RenderGraph() {
+    // Images before the memory they are bound to
+    allocations.clear();
+    transientMemory = {};
+}
+
+void RenderGraph::reset() {
+    images.clear();
+    buffers.clear();
+    transients.clear();
+    passes.clear();
+}
+
+RenderGraph::ImageHandle RenderGraph::importImage(const std::string& name, vk::Image image, uint32_t mipLevels, vk::ImageLayout initialLayout) {
+    // Importing the same image twice in a frame yields the same handle, so both users share its state
+    for (uint32_t i = 0; i < images.size(); i++) {
+        if (images[i].image == image) return { i };
+    }
+
+    images.push_back({ name, image, mipLevels, false, -1, {} });
+
+    auto& states = imageStates[image];
+    if (states.size() != mipLevels) {
+        SubresourceState initial{};
+        initial.layout = initialLayout;
+        states.assign(mipLevels, initial);
+    }
+    return { static_cast<uint32_t>(images.size() - 1) };
+}
+
+RenderGraph::ImageHandle RenderGraph::importExternalImage(const std::string& name, vk::Image image) {
+    images.push_back({ name, image, 1, true, -1, {} });
+    imageStates[image].assign(1, SubresourceState{});
+    return { static_cast<uint32_t>(images.size() - 1) };
+}
+
+RenderGraph::BufferHandle RenderGraph::importBuffer(const std::string& name, vk::Buffer buffer) {
+    for (uint32_t i = 0; i < buffers.size(); i++) {
+        if (buffers[i].buffer == buffer) return { i };
+    }
+
+    buffers.push_back({ name, buffer });
+    bufferStates.try_emplace(buffer);
+    return { static_cast<uint32_t>(buffers.size() - 1) };
+}
+
+RenderGraph::ImageHandle RenderGraph::createImage(const std::string& name, const TransientImageDesc& desc) {
+    transients.push_back({ name, desc });
+    images.push_back({ name, nullptr, 1, false, static_cast<int32_t>(transients.size() - 1), {} });
+    return { static_cast<uint32_t>(images.size() - 1) };
+}
+
+RenderGraph::PassBuilder& RenderGraph::addPass(const std::string& name) {
+    PassBuilder& pass = passes.emplace_back();
+    pass.name = name;
+    return pass;
+}
+
+vk::ImageView RenderGraph::getTransientView(const std::string& name) const {
+    for (const auto& allocation : allocations) {
+        if (allocation.name == name) return allocation.view.get();
+    }
+    return nullptr;
+}
+
+vk::Image RenderGraph::getTransientImage(const std::string& name) const {
+    for (const auto& allocation : allocations) {
+        if (allocation.name == name) return allocation.image.get();
+    }
+    return nullptr;
+}
+
+vk::PipelineStageFlags RenderGraph::getFirstStage(ImageHandle image) const {
+    vk::PipelineStageFlags stage = images[image.index].firstStage;
+    return stage ? stage : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eAllCommands);
+}
+
+std::vector<uint32_t> RenderGraph::computeLevels() {
+    auto resolveMips = [&](const PassBuilder::Use& use) {
+        if (!use.isImage) return std::pair<uint32_t, uint32_t>(0, 1);
+        uint32_t levels = images[use.resource].mipLevels;
+        uint32_t count = use.mipCount == VK_REMAINING_MIP_LEVELS ? levels - use.baseMip : use.mipCount;
+        return std::pair<uint32_t, uint32_t>(use.baseMip, count);
+    };
+
+    // A pass runs one level after the latest earlier pass it has a hazard with:
+    // any write to a shared range, or two reads that need different image layouts
+    auto conflicts = [&](const PassBuilder& earlier, const PassBuilder& later) {
+        for (const auto& a : earlier.uses) {
+            for (const auto& b : later.uses) {
+                if (a.isImage != b.isImage || a.resource != b.resource) continue;
+                auto [baseA, countA] = resolveMips(a);
+                auto [baseB, countB] = resolveMips(b);
+                if (!rangesOverlap(baseA, countA, baseB, countB)) continue;
+                if (a.write || b.write) return true;
+                if (a.isImage && usageInfo(a.usage).layout != usageInfo(b.usage).layout) return true;
+            }
+        }
+        return false;
+    };
+
+    std::vector<uint32_t> levels(passes.size(), 0);
+    for (size_t i = 0; i < passes.size(); i++) {
+        for (size_t j = 0; j < i; j++) {
+            if (conflicts(passes[j], passes[i])) {
+                levels[i] = std::max(levels[i], levels[j] + 1);
+            }
+        }
+    }
+    return levels;
+}
+
+void RenderGraph::allocateTransients(const std::vector<uint32_t>& passLevels) {
+    if (transients.empty()) return;
+
+    for (size_t p = 0; p < passes.size(); p++) {
+        for (const auto& use : passes[p].uses) {
+            if (!use.isImage || images[use.resource].transient < 0) continue;
+            Transient& transient = transients[images[use.resource].transient];
+            transient.firstLevel = std::min(transient.firstLevel, passLevels[p]);
+            transient.lastLevel = std::max(transient.lastLevel, passLevels[p]);
+        }
+    }
+
+    // Unused transients still get memory of their own (their views may be bound)
+    auto lifetimesOverlap = [&](const Transient& a, const Transient& b) {
+        if (a.firstLevel == UINT32_MAX || b.firstLevel == UINT32_MAX) return true;
+        return a.firstLevel <= b.lastLevel && b.firstLevel <= a.lastLevel;
+    };
+
+    // Placement only depends on the descriptions and which lifetimes overlap, not on
+    // absolute levels, so passes that come and go (picks, brush strokes) keep the plan
+    std::string signature;
+    for (size_t i = 0; i < transients.size(); i++) {
+        const TransientImageDesc& desc = transients[i].desc;
+        signature += transients[i].name + ":" + std::to_string(desc.width) + "x" + std::to_string(desc.height) + ":" +
+                     std::to_string(static_cast<uint32_t>(desc.format)) + ":" +
+                     std::to_string(static_cast<VkImageUsageFlags>(desc.usage)) + ":";
+        for (size_t j = 0; j < transients.size(); j++) {
+            signature += lifetimesOverlap(transients[i], transients[j]) ? '1' : '0';
+        }
+        signature += ";";
+    }
+
+    if (signature != allocationSignature) {
+        // Earlier frames may still reference the old images
+        device.waitIdle();
+        for (const auto& allocation : allocations) {
+            imageStates.erase(allocation.image.get());
+        }
+        allocations.clear();
+        transientMemory = {};
+
+        std::vector<vk::MemoryRequirements> requirements(transients.size());
+        uint32_t memoryTypeBits = ~0u;
+        vk::DeviceSize maxAlignment = 1;
+        allocations.resize(transients.size());
+        for (size_t i = 0; i < transients.size(); i++) {
+            const TransientImageDesc& desc = transients[i].desc;
+
+            vk::ImageCreateInfo imageInfo{};
+            imageInfo.imageType = vk::ImageType::e2D;
+            imageInfo.extent = vk::Extent3D{ desc.width, desc.height, 1 };
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = desc.format;
+            imageInfo.tiling = vk::ImageTiling::eOptimal;
+            imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+            imageInfo.usage = desc.usage;
+            imageInfo.samples = vk::SampleCountFlagBits::e1;
+            imageInfo.sharingMode = vk::SharingMode::eExclusive;
+
+            allocations[i].name = transients[i].name;
+            allocations[i].desc = desc;
+            allocations[i].image = device.createImageUnique(imageInfo);
+            requirements[i] = device.getImageMemoryRequirements(allocations[i].image.get());
+            allocations[i].size = requirements[i].size;
+            memoryTypeBits &= requirements[i].memoryTypeBits;
+            maxAlignment = std::max(maxAlignment, requirements[i].alignment);
+        }
+
+        // Largest first, each at the lowest offset clear of every placed image it is alive with
+        std::vector<uint32_t> order(transients.size());
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return requirements[a].size > requirements[b].size;
+        });
+
+        std::vector<uint32_t> placed;
+        vk::DeviceSize totalSize = 0;
+        vk::DeviceSize requestedSize = 0;
+        for (uint32_t i : order) {
+            vk::DeviceSize offset = 0;
+            bool moved = true;
+            while (moved) {
+                moved = false;
+                for (uint32_t other : placed) {
+                    if (!lifetimesOverlap(transients[i], transients[other])) continue;
+                    const auto& o = allocations[other];
+                    if (offset < o.offset + o.size && o.offset < offset + allocations[i].size) {
+                        offset = alignUp(o.offset + o.size, requirements[i].alignment);
+                        moved = true;
+                    }
+                }
+            }
+            allocations[i].offset = offset;
+            placed.push_back(i);
+            totalSize = std::max(totalSize, offset + allocations[i].size);
+            requestedSize += allocations[i].size;
+        }
+
+        if (memoryTypeBits == 0) {
+            throw std::runtime_error("Render graph transients have no common memory type");
+        }
+
+        vk::MemoryRequirements heapRequirements{};
+        heapRequirements.size = totalSize;
+        heapRequirements.alignment = maxAlignment;
+        heapRequirements.memoryTypeBits = memoryTypeBits;
+        transientMemory = resourceManager.allocate(heapRequirements, vk::MemoryPropertyFlagBits::eDeviceLocal, true);
+
+        for (uint32_t i = 0; i < allocations.size(); i++) {
+            auto& allocation = allocations[i];
+            device.bindImageMemory(allocation.image.get(), transientMemory.getMemory(), transientMemory.getOffset() + allocation.offset);
+            allocation.view = resourceManager.createImageView(allocation.image.get(), allocation.desc.format, vk::ImageViewType::e2D, 0, 1);
+
+            for (uint32_t j = 0; j < allocations.size(); j++) {
+                const auto& other = allocations[j];
+                if (i != j && allocation.offset < other.offset + other.size && other.offset < allocation.offset + allocation.size) {
+                    allocation.aliases.push_back(j);
+                }
+            }
+        }
+
+        stats.transientBytes = totalSize;
+        stats.aliasedBytes = requestedSize - totalSize;
+        allocationSignature = signature;
+
+        for (auto& callback : reallocCallbacks) {
+            callback();
+        }
+    }
+
+    // Contents never survive the frame; the stages of the last use are kept for the next first use
+    for (const auto& allocation : allocations) {
+        auto& states = imageStates[allocation.image.get()];
+        states.resize(1);
+        states[0].layout = vk::ImageLayout::eUndefined;
+    }
+    for (auto& image : images) {
+        if (image.transient >= 0) image.image = allocations[image.transient].image.get();
+    }
+}
+
+RenderGraph::SubresourceState& RenderGraph::stateOf(bool isImage, uint32_t resource, uint32_t mip) {
+    if (isImage) return imageStates[images[resource].image][mip];
+    return bufferStates[buffers[resource].buffer];
+}
+
+void RenderGraph::execute(vk::CommandBuffer cmd) {
+    ENGINE_PROFILE_ZONE("Render Graph Execute");
+    vk::DeviceSize transientBytes = stats.transientBytes;
+    vk::DeviceSize aliasedBytes = stats.aliasedBytes;
+    stats = {};
+    stats.transientBytes = transientBytes;
+    stats.aliasedBytes = aliasedBytes;
+
+    std::vector<uint32_t> passLevels = computeLevels();
+    allocateTransients(passLevels);
+
+    uint32_t levelCount = 0;
+    for (uint32_t level : passLevels) levelCount = std::max(levelCount, level + 1);
+    stats.passes = static_cast<uint32_t>(passes.size());
+    stats.levels = levelCount;
+
+    // Callbacks only read state captured when the pass was added, so every pass can be
+    // recorded at once; barriers stay in the primary buffer between the secondaries
+    std::vector<vk::CommandBuffer> secondaries(passes.size());
+    if (recorder && recorder->getThreadCount() > 1) {
+        std::vector<uint32_t> recorded;
+        std::vector<const ParallelRecorder::RecordFn*> jobs;
+        for (uint32_t p = 0; p < passes.size(); p++) {
+            if (passes[p].callback) {
+                recorded.push_back(p);
+                jobs.push_back(&passes[p].callback);
+            }
+        }
+        std::vector<vk::CommandBuffer> buffers = recorder->record(jobs);
+        for (size_t i = 0; i < recorded.size(); i++) {
+            secondaries[recorded[i]] = buffers[i];
+        }
+        stats.secondaryBuffers = static_cast<uint32_t>(buffers.size());
+    }
+
+    // Transients whose memory another image used earlier this frame
+    std::vector<bool> transientTouched(allocations.size(), false);
+
+    struct PendingImageBarrier {
+        vk::ImageLayout oldLayout, newLayout;
+        vk::AccessFlags srcAccess, dstAccess;
+    };
+    struct PendingBufferBarrier {
+        vk::AccessFlags srcAccess, dstAccess;
+    };
+
+    for (uint32_t level = 0; level < levelCount; level++) {
+        std::map<std::pair<vk::Image, uint32_t>, PendingImageBarrier> pendingImages;
+        std::map<vk::Buffer, PendingBufferBarrier> pendingBuffers;
+        vk::PipelineStageFlags srcStages, dstStages;
+
+        for (size_t p = 0; p < passes.size(); p++) {
+            if (passLevels[p] != level) continue;
+
+            // Several uses of the same range in one pass become one access
+            std::vector<Access> accesses;
+            for (const auto& use : passes[p].uses) {
+                uint32_t baseMip = use.baseMip, mipCount = 1;
+                if (use.isImage) {
+                    uint32_t levels = images[use.resource].mipLevels;
+                    mipCount = use.mipCount == VK_REMAINING_MIP_LEVELS ? levels - use.baseMip : use.mipCount;
+                }
+                UsageInfo info = usageInfo(use.usage);
+
+                auto existing = std::find_if(accesses.begin(), accesses.end(), [&](const Access& a) {
+                    return a.isImage == use.isImage && a.resource == use.resource && a.baseMip == baseMip && a.mipCount == mipCount;
+                });
+                if (existing == accesses.end()) {
+                    accesses.push_back({ use.isImage, use.resource, baseMip, mipCount, info, use.write, use.discard });
+                    continue;
+                }
+                if (use.isImage && existing->info.layout != info.layout) {
+                    throw std::runtime_error("Pass '" + passes[p].name + "' uses image '" + images[use.resource].name + "' in two layouts");
+                }
+                existing->info.stages |= info.stages;
+                existing->info.access |= info.access;
+                existing->write = existing->write || use.write;
+                existing->discard = existing->discard && use.discard;
+            }
+
+            for (const Access& access : accesses) {
+                const UsageInfo& info = access.info;
+                if (access.isImage && !images[access.resource].firstStage) {
+                    images[access.resource].firstStage = info.stages;
+                }
+
+                for (uint32_t mip = access.baseMip; mip < access.baseMip + access.mipCount; mip++) {
+                    SubresourceState& state = stateOf(access.isImage, access.resource, mip);
+
+                    // A second reader in the same batch only widens the barrier already queued
+                    if (!access.write && access.isImage) {
+                        auto pending = pendingImages.find({ images[access.resource].image, mip });
+                        if (pending != pendingImages.end()) {
+                            pending->second.dstAccess |= info.access;
+                            dstStages |= info.stages;
+                            state.readStages |= info.stages;
+                            state.visibleStages |= info.stages;
+                            state.visibleAccess |= info.access;
+                            continue;
+                        }
+                    } else if (!access.write) {
+                        auto pending = pendingBuffers.find(buffers[access.resource].buffer);
+                        if (pending != pendingBuffers.end()) {
+                            pending->second.dstAccess |= info.access;
+                            dstStages |= info.stages;
+                            state.readStages |= info.stages;
+                            state.visibleStages |= info.stages;
+                            state.visibleAccess |= info.access;
+                            continue;
+                        }
+                    }
+
+                    bool transition = access.isImage && state.layout != info.layout;
+                    vk::ImageLayout oldLayout = state.layout;
+                    vk::PipelineStageFlags src;
+                    vk::AccessFlags srcAccess;
+                    bool needed = false;
+
+                    if (transition || access.write) {
+                        // Layout change, or write after read/write
+                        src = state.writeStages | state.readStages;
+                        srcAccess = state.writeAccess;
+                        needed = transition || src;
+                        if (access.discard) oldLayout = vk::ImageLayout::eUndefined;
+                    } else {
+                        // Read after write, unless the write was already made visible here
+                        src = state.writeStages;
+                        srcAccess = state.writeAccess;
+                        needed = state.writeStages &&
+                                 ((state.visibleStages & info.stages) != info.stages ||
+                                  (state.visibleAccess & info.access) != info.access);
+                    }
+
+                    // First use of aliased memory waits for every image sharing it
+                    int32_t transient = access.isImage ? images[access.resource].transient : -1;
+                    if (transient >= 0 && !transientTouched[transient]) {
+                        transientTouched[transient] = true;
+                        for (uint32_t alias : allocations[transient].aliases) {
+                            const SubresourceState& aliasState = imageStates[allocations[alias].image.get()][0];
+                            src |= aliasState.writeStages | aliasState.readStages;
+                            srcAccess |= aliasState.writeAccess;
+                            needed = true;
+                        }
+                    }
+
+                    if (needed) {
+                        // Nothing to wait on: chain to whatever external wait covers the first use (acquire semaphore)
+                        srcStages |= src ? src : info.stages;
+                        dstStages |= info.stages;
+                        if (access.isImage) {
+                            pendingImages[{ images[access.resource].image, mip }] = { oldLayout, info.layout, srcAccess, info.access };
+                        } else {
+                            pendingBuffers[buffers[access.resource].buffer] = { srcAccess, info.access };
+                        }
+                    }
+
+                    if (transition || access.write) {
+                        state.layout = access.isImage ? info.layout : state.layout;
+                        state.writeStages = info.stages;
+                        state.writeAccess = access.write ? (info.access & WRITE_ACCESS) : vk::AccessFlags{};
+                        state.readStages = access.write ? vk::PipelineStageFlags{} : info.stages;
+                        state.visibleStages = access.write ? vk::PipelineStageFlags{} : info.stages;
+                        state.visibleAccess = access.write ? vk::AccessFlags{} : info.access;
+                    } else {
+                        state.readStages |= info.stages;
+                        if (needed) {
+                            state.visibleStages |= info.stages;
+                            state.visibleAccess |= info.access;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!pendingImages.empty() || !pendingBuffers.empty()) {
+            // Consecutive mips with identical transitions share one barrier
+            std::vector<vk::ImageMemoryBarrier> imageBarriers;
+            for (const auto& [key, pending] : pendingImages) {
+                if (!imageBarriers.empty()) {
+                    vk::ImageMemoryBarrier& last = imageBarriers.back();
+                    if (last.image == key.first &&
+                        last.subresourceRange.baseMipLevel + last.subresourceRange.levelCount == key.second &&
+                        last.oldLayout == pending.oldLayout && last.newLayout == pending.newLayout &&
+                        last.srcAccessMask == pending.srcAccess && last.dstAccessMask == pending.dstAccess) {
+                        last.subresourceRange.levelCount++;
+                        continue;
+                    }
+                }
+
+                vk::ImageMemoryBarrier barrier{};
+                barrier.oldLayout = pending.oldLayout;
+                barrier.newLayout = pending.newLayout;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = key.first;
+                barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+                barrier.subresourceRange.baseMipLevel = key.second;
+                barrier.subresourceRange.levelCount = 1;
+                barrier.subresourceRange.baseArrayLayer = 0;
+                barrier.subresourceRange.layerCount = 1;
+                barrier.srcAccessMask = pending.srcAccess;
+                barrier.dstAccessMask = pending.dstAccess;
+                imageBarriers.push_back(barrier);
+            }
+
+            std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+            for (const auto& [buffer, pending] : pendingBuffers) {
+                vk::BufferMemoryBarrier barrier{};
+                barrier.srcAccessMask = pending.srcAccess;
+                barrier.dstAccessMask = pending.dstAccess;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.buffer = buffer;
+                barrier.offset = 0;
+                barrier.size = VK_WHOLE_SIZE;
+                bufferBarriers.push_back(barrier);
+            }
+
+            cmd.pipelineBarrier(srcStages, dstStages, {}, nullptr, bufferBarriers, imageBarriers);
+
+            stats.barrierBatches++;
+            stats.imageBarriers += static_cast<uint32_t>(imageBarriers.size());
+            stats.bufferBarriers += static_cast<uint32_t>(bufferBarriers.size());
+        }
+
+        for (size_t p = 0; p < passes.size(); p++) {
+            if (passLevels[p] == level && passes[p].callback) {
+                if (profiler) profiler->beginScope(cmd, passes[p].name);
+                if (secondaries[p]) {
+                    cmd.executeCommands(secondaries[p]);
+                } else {
+                    passes[p].callback(cmd);
+                }
+                if (profiler) profiler->endScope(cmd);
+            }
+        }
+    }
+}
+
+} // namespace engine::renderer
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ResourceManager.hpp"
+
+namespace engine::renderer {
+
+class GpuProfiler;
+class ParallelRecorder;
+
+// How a pass touches a resource. Each usage maps to a pipeline stage, access mask
+// and, for images, the layout the pass expects.
+enum class ResourceUsage {
+    ComputeRead,      // Storage or sampled reads from a compute shader (eGeneral)
+    ComputeWrite,
+    ComputeReadWrite,
+    IndirectRead,     // Dispatch/draw indirect arguments
+    TransferRead,
+    TransferWrite,
+    ColorAttachment,  // Read + write as a color attachment
+    HostRead,         // Mapped readback after the frame's fence
+    Present
+};
+
+// Per-frame pass list with automatic synchronization. Passes declare which
+// images/buffers they read and write; execute() orders them by dependency level,
+// emits one merged barrier batch per level and aliases the memory of transient
+// images whose lifetimes do not overlap.
+//
+// Resource state is tracked per physical image (per mip level) and buffer and
+// carries over between frames, so the first barrier of a frame waits on exactly
+// what the previous frame left behind.
+class RenderGraph {
+public:
+    struct ImageHandle { uint32_t index = UINT32_MAX; };
+    struct BufferHandle { uint32_t index = UINT32_MAX; };
+
+    struct TransientImageDesc {
+        uint32_t width = 0, height = 0;
+        vk::Format format = vk::Format::eUndefined;
+        vk::ImageUsageFlags usage;
+
+        bool operator==(const TransientImageDesc&) const = default;
+    };
+
+    class PassBuilder {
+    public:
+        // Mip ranges default to every level of the image
+        PassBuilder& read(ImageHandle image, ResourceUsage usage, uint32_t baseMip = 0, uint32_t mipCount = VK_REMAINING_MIP_LEVELS);
+        PassBuilder& write(ImageHandle image, ResourceUsage usage, uint32_t baseMip = 0, uint32_t mipCount = VK_REMAINING_MIP_LEVELS);
+        // Write that does not need the previous contents: the transition starts from eUndefined
+        PassBuilder& discard(ImageHandle image, ResourceUsage usage);
+        PassBuilder& read(BufferHandle buffer, ResourceUsage usage);
+        PassBuilder& write(BufferHandle buffer, ResourceUsage usage);
+        // Recording callback; passes without one only contribute synchronization (e.g. present)
+        PassBuilder& execute(std::function<void(vk::CommandBuffer)> callback);
+
+    private:
+        friend class RenderGraph;
+        struct Use {
+            bool isImage;
+            uint32_t resource;
+            ResourceUsage usage;
+            bool write;
+            bool discard;
+            uint32_t baseMip, mipCount;
+        };
+        std::string name;
+        std::vector<Use> uses;
+        std::function<void(vk::CommandBuffer)> callback;
+    };
+
+    struct Stats {
+        uint32_t passes = 0;
+        uint32_t levels = 0;
+        uint32_t barrierBatches = 0;
+        uint32_t imageBarriers = 0;
+        uint32_t bufferBarriers = 0;
+        vk::DeviceSize transientBytes = 0; // Memory actually allocated for transients
+        vk::DeviceSize aliasedBytes = 0;   // Memory saved by aliasing
+        uint32_t secondaryBuffers = 0;     // Passes recorded in parallel
+    };
+
+    RenderGraph(vk::Device device, ResourceManager& resourceManager);
+    ~RenderGraph();
+
+    // Starts a new frame: drops last frame's passes and handles, keeps tracked state
+    void reset();
+
+    // initialLayout is only used the first time the image is seen
+    ImageHandle importImage(const std::string& name, vk::Image image, uint32_t mipLevels = 1,
+                            vk::ImageLayout initialLayout = vk::ImageLayout::eUndefined);
+    // Image synchronized outside the graph (swapchain): no state is carried over, and its
+    // first use only chains to a semaphore wait on that use's stage (see getFirstStage)
+    ImageHandle importExternalImage(const std::string& name, vk::Image image);
+    BufferHandle importBuffer(const std::string& name, vk::Buffer buffer);
+    // Image owned by the graph and only valid within the frame; contents start undefined
+    ImageHandle createImage(const std::string& name, const TransientImageDesc& desc);
+    // Drops the tracked state of an image that is about to be destroyed
+    void forgetImage(vk::Image image) { imageStates.erase(image); }
+
+    // The returned builder stays valid until reset()
+    PassBuilder& addPass(const std::string& name);
+
+    // Orders passes, allocates transients and records everything with its barriers
+    void execute(vk::CommandBuffer cmd);
+
+    // View of a transient image by name (null before its first allocation)
+    vk::ImageView getTransientView(const std::string& name) const;
+    // Image of a transient by name, for pass callbacks that copy from it
+    vk::Image getTransientImage(const std::string& name) const;
+    // Runs after transients are (re)allocated, which invalidates earlier views
+    void addReallocCallback(std::function<void()> callback) { reallocCallbacks.push_back(std::move(callback)); }
+
+    // Stage of the image's first use in the executed frame, e.g. the swapchain acquire wait stage
+    vk::PipelineStageFlags getFirstStage(ImageHandle image) const;
+    const Stats& getStats() const { return stats; }
+    // Wraps every recorded pass in a timestamp scope named after it
+    void setProfiler(GpuProfiler* gpuProfiler) { profiler = gpuProfiler; }
+    // Records pass callbacks into secondary command buffers on the recorder's threads, then
+    // executes them in pass order between the graph's barriers. Null records inline.
+    void setRecorder(ParallelRecorder* parallelRecorder) { recorder = parallelRecorder; }
+
+private:
+    struct SubresourceState {
+        vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+        vk::PipelineStageFlags writeStages;   // Last write (or layout transition)
+        vk::AccessFlags writeAccess;
+        vk::PipelineStageFlags readStages;    // Reads since that write
+        vk::PipelineStageFlags visibleStages; // Stages/accesses the write was already made visible to
+        vk::AccessFlags visibleAccess;
+    };
+
+    struct ImageResource {
+        std::string name;
+        vk::Image image;
+        uint32_t mipLevels = 1;
+        bool external = false;
+        int32_t transient = -1; // Index into transients
+        vk::PipelineStageFlags firstStage;
+    };
+
+    struct BufferResource {
+        std::string name;
+        vk::Buffer buffer;
+    };
+
+    struct Transient {
+        std::string name;
+        TransientImageDesc desc;
+        uint32_t firstLevel = UINT32_MAX, lastLevel = 0;
+    };
+
+    // Physical transient image, kept across frames while the allocation plan is unchanged
+    struct TransientAllocation {
+        std::string name;
+        TransientImageDesc desc;
+        vk::UniqueImage image;
+        vk::UniqueImageView view;
+        vk::DeviceSize offset = 0, size = 0;
+        std::vector<uint32_t> aliases; // Allocations whose memory overlaps this one
+    };
+
+    vk::Device device;
+    ResourceManager& resourceManager;
+
+    std::vector<ImageResource> images;
+    std::vector<BufferResource> buffers;
+    std::vector<Transient> transients;
+    std::deque<PassBuilder> passes;
+
+    // Tracked state, keyed by physical resource so it survives re-imports
+    std::unordered_map<vk::Image, std::vector<SubresourceState>> imageStates;
+    std::unordered_map<vk::Buffer, SubresourceState> bufferStates;
+
+    std::vector<TransientAllocation> allocations;
+    ResourceManager::Allocation transientMemory;
+    std::string allocationSignature;
+    std::vector<std::function<void()>> reallocCallbacks;
+
+    Stats stats;
+    GpuProfiler* profiler = nullptr;
+    ParallelRecorder* recorder = nullptr;
+
+    std::vector<uint32_t> computeLevels();
+    void allocateTransients(const std::vector<uint32_t>& passLevels);
+    SubresourceState& stateOf(bool isImage, uint32_t resource, uint32_t mip);
+};
+
+} // namespace engine::renderer
@@ -1,9 +1,58 @@
 #include "ResourceManager.hpp"
+#include <algorithm>
+#include <utility>
 
 namespace engine::renderer {
 
+// A pooled vkAllocateMemory, mapped once for its lifetime when host visible
+struct ResourceManager::Allocation::Block {
+    vk::UniqueDeviceMemory memory;
+    uint8_t* mapped = nullptr;
+    TlsfAllocator allocator;
+
+    explicit Block(vk::DeviceSize size) : allocator(size) {}
+};
+
+ResourceManager::Allocation::Allocation(Allocation&& other) noexcept {
+    *this = std::move(other);
+}
+
+ResourceManager::Allocation& ResourceManager::Allocation::operator=(Allocation&& other) noexcept {
+    if (this != &other) {
+        release();
+        owner = std::exchange(other.owner, nullptr);
+        memory = std::exchange(other.memory, nullptr);
+        offset = other.offset;
+        size = other.size;
+        mapped = std::exchange(other.mapped, nullptr);
+        memoryType = other.memoryType;
+        block = std::exchange(other.block, nullptr);
+        handle = std::exchange(other.handle, TlsfAllocator::INVALID);
+    }
+    return *this;
+}
+
+ResourceManager::Allocation::~Allocation() {
+    release();
+}
+
+void ResourceManager::Allocation::release() {
+    if (owner) {
+        owner->free(*this);
+        owner = nullptr;
+    }
+}
+
 ResourceManager::ResourceManager(vk::Device device, vk::PhysicalDevice physicalDevice)
-    : device(device), physicalDevice(physicalDevice) {}
+    : device(device), physicalDevice(physicalDevice) {
+    memoryProperties = physicalDevice.getMemoryProperties();
+    auto limits = physicalDevice.getProperties().limits;
+    bufferImageGranularity = std::max<vk::DeviceSize>(limits.bufferImageGranularity, 1);
+    maxAllocationCount = limits.maxMemoryAllocationCount;
+    pools.resize(memoryProperties.memoryTypeCount);
+}
+
+ResourceManager::~ResourceManager() {}
 
 ResourceManager::Buffer ResourceManager::createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties) {
     Buffer buffer;
@@ -15,19 +64,19 @@ ResourceManager::Buffer ResourceManager::createBuffer(vk::DeviceSize size, vk::B
 
     buffer.buffer = device.createBufferUnique(bufferInfo);
 
-    vk::MemoryRequirements memRequirements = device.getBufferMemoryRequirements(buffer.buffer.get());
-
-    vk::MemoryAllocateInfo allocInfo{};
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    auto requirements = device.getBufferMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(
+        vk::BufferMemoryRequirementsInfo2{ buffer.buffer.get() });
+    const auto& memRequirements = requirements.get<vk::MemoryRequirements2>().memoryRequirements;
+    const auto& dedicatedRequirements = requirements.get<vk::MemoryDedicatedRequirements>();
+    bool dedicated = dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation;
 
-    buffer.memory = device.allocateMemoryUnique(allocInfo);
-    device.bindBufferMemory(buffer.buffer.get(), buffer.memory.get(), 0);
+    buffer.memory = allocateMemory(memRequirements, properties, false, dedicated, nullptr, buffer.buffer.get());
+    device.bindBufferMemory(buffer.buffer.get(), buffer.memory.getMemory(), buffer.memory.getOffset());
 
     return buffer;
 }
 
-ResourceManager::Image ResourceManager::createImage(uint32_t width, uint32_t height, uint32_t depth, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::ImageViewType viewType) {
+ResourceManager::Image ResourceManager::createImage(uint32_t width, uint32_t height, uint32_t depth, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::ImageViewType viewType, uint32_t mipLevels) {
     Image image;
 
     vk::ImageCreateInfo imageInfo{};
@@ -35,7 +84,7 @@ ResourceManager::Image ResourceManager::createImage(uint32_t width, uint32_t hei
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = depth;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
@@ -46,35 +95,145 @@ ResourceManager::Image ResourceManager::createImage(uint32_t width, uint32_t hei
 
     image.image = device.createImageUnique(imageInfo);
 
-    vk::MemoryRequirements memRequirements = device.getImageMemoryRequirements(image.image.get());
+    auto requirements = device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(
+        vk::ImageMemoryRequirementsInfo2{ image.image.get() });
+    const auto& memRequirements = requirements.get<vk::MemoryRequirements2>().memoryRequirements;
+    const auto& dedicatedRequirements = requirements.get<vk::MemoryDedicatedRequirements>();
+    bool dedicated = dedicatedRequirements.requiresDedicatedAllocation || dedicatedRequirements.prefersDedicatedAllocation ||
+                     memRequirements.size >= DEDICATED_IMAGE_SIZE;
 
-    vk::MemoryAllocateInfo allocInfo{};
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    image.memory = allocateMemory(memRequirements, properties, tiling == vk::ImageTiling::eOptimal, dedicated, image.image.get(), nullptr);
+    device.bindImageMemory(image.image.get(), image.memory.getMemory(), image.memory.getOffset());
+
+    image.view = createImageView(image.image.get(), format, viewType, 0, mipLevels);
 
-    image.memory = device.allocateMemoryUnique(allocInfo);
-    device.bindImageMemory(image.image.get(), image.memory.get(), 0);
+    return image;
+}
 
+vk::UniqueImageView ResourceManager::createImageView(vk::Image image, vk::Format format, vk::ImageViewType viewType, uint32_t baseMipLevel, uint32_t levelCount) {
     vk::ImageViewCreateInfo viewInfo{};
-    viewInfo.image = image.image.get();
+    viewInfo.image = image;
     viewInfo.viewType = viewType;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+    viewInfo.subresourceRange.levelCount = levelCount;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
-    image.view = device.createImageViewUnique(viewInfo);
+    return device.createImageViewUnique(viewInfo);
+}
 
-    return image;
+ResourceManager::Allocation ResourceManager::allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool optimalImage) {
+    return allocateMemory(requirements, properties, optimalImage, false, nullptr, nullptr);
 }
 
-uint32_t ResourceManager::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) {
-    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+ResourceManager::Allocation ResourceManager::allocateMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties,
+                                                            bool optimalImage, bool dedicated, vk::Image dedicatedImage, vk::Buffer dedicatedBuffer) {
+    uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+    vk::DeviceSize blockSize = getBlockSize(memoryType);
+
+    std::lock_guard<std::mutex> lock(mutex);
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+    // Anything over half a block would mostly waste the rest of it
+    if (dedicated || requirements.size > blockSize / 2) {
+        return allocateDedicated(memoryType, requirements.size, dedicatedImage, dedicatedBuffer);
+    }
+
+    // Optimal images take whole granularity pages, so no linear resource can share one with them
+    vk::DeviceSize granularity = optimalImage ? bufferImageGranularity : 1;
+    auto& pool = pools[memoryType];
+
+    auto suballocate = [&](Allocation::Block& block) {
+        Allocation allocation;
+        auto range = block.allocator.allocate(requirements.size, requirements.alignment, granularity);
+        if (range.handle == TlsfAllocator::INVALID) return allocation;
+
+        allocation.owner = this;
+        allocation.memory = block.memory.get();
+        allocation.offset = range.offset;
+        allocation.size = requirements.size;
+        allocation.mapped = block.mapped ? block.mapped + range.offset : nullptr;
+        allocation.memoryType = memoryType;
+        allocation.block = &block;
+        allocation.handle = range.handle;
+        return allocation;
+    };
+
+    for (auto& block : pool.blocks) {
+        Allocation allocation = suballocate(*block);
+        if (allocation) return allocation;
+    }
+
+    auto block = std::make_unique<Allocation::Block>(blockSize);
+    vk::MemoryAllocateInfo allocInfo{};
+    allocInfo.allocationSize = blockSize;
+    allocInfo.memoryTypeIndex = memoryType;
+    block->memory = device.allocateMemoryUnique(allocInfo);
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+        block->mapped = static_cast<uint8_t*>(device.mapMemory(block->memory.get(), 0, VK_WHOLE_SIZE));
+    }
+    pool.blocks.push_back(std::move(block));
+
+    Allocation allocation = suballocate(*pool.blocks.back());
+    if (!allocation) {
+        throw std::runtime_error("failed to suballocate from a new memory block");
+    }
+    return allocation;
+}
+
+ResourceManager::Allocation ResourceManager::allocateDedicated(uint32_t memoryType, vk::DeviceSize size, vk::Image image, vk::Buffer buffer) {
+    vk::MemoryDedicatedAllocateInfo dedicatedInfo{ image, buffer };
+    vk::MemoryAllocateInfo allocInfo{};
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+    if (image || buffer) {
+        allocInfo.pNext = &dedicatedInfo;
+    }
+
+    Allocation allocation;
+    allocation.memory = device.allocateMemory(allocInfo);
+    allocation.owner = this;
+    allocation.size = size;
+    allocation.memoryType = memoryType;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+        allocation.mapped = device.mapMemory(allocation.memory, 0, VK_WHOLE_SIZE);
+    }
+
+    pools[memoryType].dedicatedCount++;
+    pools[memoryType].dedicatedBytes += size;
+    return allocation;
+}
+
+void ResourceManager::free(Allocation& allocation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& pool = pools[allocation.memoryType];
+
+    if (!allocation.block) {
+        device.freeMemory(allocation.memory);
+        pool.dedicatedCount--;
+        pool.dedicatedBytes -= allocation.size;
+        return;
+    }
+
+    allocation.block->allocator.free(allocation.handle);
+
+    // Keep one empty block per type so a resize does not hit the driver twice
+    if (allocation.block->allocator.isEmpty() && pool.blocks.size() > 1) {
+        pool.blocks.erase(std::find_if(pool.blocks.begin(), pool.blocks.end(),
+                                       [&](const auto& block) { return block.get() == allocation.block; }));
+    }
+}
+
+vk::DeviceSize ResourceManager::getBlockSize(uint32_t memoryType) const {
+    // Small heaps (e.g. the 256 MB host-visible VRAM window) get smaller blocks
+    vk::DeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+    return std::min(DEFAULT_BLOCK_SIZE, heapSize / 8);
+}
+
+uint32_t ResourceManager::findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
             return i;
         }
     }
@@ -82,4 +241,43 @@ uint32_t ResourceManager::findMemoryType(uint32_t typeFilter, vk::MemoryProperty
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
+ResourceManager::MemoryStats ResourceManager::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryStats stats;
+    stats.maxDeviceAllocations = maxAllocationCount;
+
+    for (uint32_t type = 0; type < pools.size(); type++) {
+        const auto& pool = pools[type];
+        if (pool.blocks.empty() && pool.dedicatedCount == 0) continue;
+
+        MemoryTypeStats typeStats;
+        typeStats.memoryType = type;
+        typeStats.flags = memoryProperties.memoryTypes[type].propertyFlags;
+        typeStats.blocks = static_cast<uint32_t>(pool.blocks.size());
+        typeStats.dedicated = pool.dedicatedCount;
+        typeStats.allocations = pool.dedicatedCount;
+        typeStats.reserved = pool.dedicatedBytes;
+        typeStats.used = pool.dedicatedBytes;
+
+        vk::DeviceSize freeBytes = 0;
+        for (const auto& block : pool.blocks) {
+            const auto& allocator = block->allocator;
+            typeStats.allocations += allocator.getAllocationCount();
+            typeStats.reserved += allocator.getSize();
+            typeStats.used += allocator.getUsed();
+            typeStats.largestFree = std::max(typeStats.largestFree, allocator.getLargestFree());
+            freeBytes += allocator.getSize() - allocator.getUsed();
+        }
+        if (freeBytes > 0) {
+            typeStats.fragmentation = 1.0f - static_cast<float>(typeStats.largestFree) / static_cast<float>(freeBytes);
+        }
+
+        stats.reserved += typeStats.reserved;
+        stats.used += typeStats.used;
+        stats.deviceAllocations += typeStats.blocks + typeStats.dedicated;
+        stats.types.push_back(typeStats);
+    }
+    return stats;
+}
+
 } // namespace engine::renderer
@@ -1,32 +1,121 @@
 #pragma once
 
 #include <vulkan/vulkan.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "TlsfAllocator.hpp"
 
 namespace engine::renderer {
 
+// Creates buffers and images and places them in pooled device memory: large blocks per
+// memory type, suballocated with a TLSF allocator. Large images (and anything the driver
+// asks to keep separate) get dedicated allocations.
 class ResourceManager {
 public:
     ResourceManager(vk::Device device, vk::PhysicalDevice physicalDevice);
+    ~ResourceManager();
+
+    // Device memory range owned by one resource, given back when destroyed. Host-visible
+    // memory stays mapped for its whole lifetime. Must not outlive the ResourceManager.
+    class Allocation {
+    public:
+        Allocation() = default;
+        Allocation(Allocation&& other) noexcept;
+        Allocation& operator=(Allocation&& other) noexcept;
+        ~Allocation();
+
+        vk::DeviceMemory getMemory() const { return memory; }
+        vk::DeviceSize getOffset() const { return offset; }
+        vk::DeviceSize getSize() const { return size; }
+        // Start of this range in host memory; null unless the memory type is host visible
+        void* getMappedData() const { return mapped; }
+        explicit operator bool() const { return owner != nullptr; }
+
+    private:
+        friend class ResourceManager;
+        struct Block;
+
+        ResourceManager* owner = nullptr;
+        vk::DeviceMemory memory;
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+        void* mapped = nullptr;
+        uint32_t memoryType = 0;
+        Block* block = nullptr; // Null for dedicated allocations
+        uint32_t handle = TlsfAllocator::INVALID;
+
+        void release();
+    };
 
     struct Buffer {
         vk::UniqueBuffer buffer;
-        vk::UniqueDeviceMemory memory;
+        Allocation memory;
     };
 
     struct Image {
         vk::UniqueImage image;
-        vk::UniqueDeviceMemory memory;
+        Allocation memory;
         vk::UniqueImageView view;
     };
 
     Buffer createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties);
-    Image createImage(uint32_t width, uint32_t height, uint32_t depth, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::ImageViewType viewType = vk::ImageViewType::e2D);
+    Image createImage(uint32_t width, uint32_t height, uint32_t depth, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::ImageViewType viewType = vk::ImageViewType::e2D, uint32_t mipLevels = 1);
+    // View of a subset of an image's mip levels (e.g. a single level for storage writes)
+    vk::UniqueImageView createImageView(vk::Image image, vk::Format format, vk::ImageViewType viewType, uint32_t baseMipLevel, uint32_t levelCount);
+
+    // Memory for resources the caller binds itself. optimalImage keeps the range clear of
+    // linear resources by bufferImageGranularity.
+    Allocation allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool optimalImage);
 
     uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties);
 
+    struct MemoryTypeStats {
+        uint32_t memoryType = 0;
+        vk::MemoryPropertyFlags flags;
+        uint32_t blocks = 0;
+        uint32_t dedicated = 0;
+        uint32_t allocations = 0;      // Suballocations plus dedicated allocations
+        vk::DeviceSize reserved = 0;   // Device memory allocated from the driver
+        vk::DeviceSize used = 0;       // Handed out to resources, padding included
+        vk::DeviceSize largestFree = 0;
+        float fragmentation = 0.0f;    // 1 - largest free range / all free space in the blocks
+    };
+
+    struct MemoryStats {
+        std::vector<MemoryTypeStats> types; // Memory types with at least one allocation
+        vk::DeviceSize reserved = 0;
+        vk::DeviceSize used = 0;
+        uint32_t deviceAllocations = 0;    // Live vkAllocateMemory calls
+        uint32_t maxDeviceAllocations = 0; // maxMemoryAllocationCount
+    };
+    MemoryStats getStats() const;
+
 private:
+    // Images at least this large get their own allocation
+    static constexpr vk::DeviceSize DEDICATED_IMAGE_SIZE = 32ull * 1024 * 1024;
+    static constexpr vk::DeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+    struct Pool {
+        std::vector<std::unique_ptr<Allocation::Block>> blocks;
+        uint32_t dedicatedCount = 0;
+        vk::DeviceSize dedicatedBytes = 0;
+    };
+
     vk::Device device;
     vk::PhysicalDevice physicalDevice;
+    vk::PhysicalDeviceMemoryProperties memoryProperties;
+    vk::DeviceSize bufferImageGranularity = 1;
+    uint32_t maxAllocationCount = 0;
+
+    mutable std::mutex mutex;
+    std::vector<Pool> pools; // One per memory type
+
+    Allocation allocateMemory(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties,
+                              bool optimalImage, bool dedicated, vk::Image dedicatedImage, vk::Buffer dedicatedBuffer);
+    Allocation allocateDedicated(uint32_t memoryType, vk::DeviceSize size, vk::Image image, vk::Buffer buffer);
+    vk::DeviceSize getBlockSize(uint32_t memoryType) const;
+    void free(Allocation& allocation);
 };
 
 } // namespace engine::renderer
@@ -1,12 +1,17 @@
 #include "SDFRenderer.hpp"
+#include "core/CpuProfiler.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstring>
+#include <memory>
 #include <GLFW/glfw3.h>
+#include <glm/gtc/packing.hpp>
 
 namespace engine::renderer {
 
 SDFRenderer::SDFRenderer(core::VulkanContext& context) : context(context) {
-    descriptorManager = std::make_unique<DescriptorManager>(context.getDevice());
-
+    resourceSlots.fill(BindlessHeap::INVALID);
     terrain = std::make_unique<Terrain>(context);
 
     // Create a linear sampler for terrain
@@ -29,36 +34,37 @@ SDFRenderer::SDFRenderer(core::VulkanContext& context) : context(context) {
 
     terrainSampler = context.getDevice().createSampler(samplerInfo);
 
-    std::vector<vk::DescriptorSetLayoutBinding> bindings = {
-        { 0, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute },  // Brick Atlas
-        { 1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute },  // Sparse Map
-        { 2, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute },  // Out Image
-        { 3, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute }, // Edit Buffer
-        { 4, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute }, // Selection Buffer
-        { 5, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute }, // Terrain Height
-        { 6, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute }  // Terrain Splat
-    };
-    descriptorSetLayout = descriptorManager->createLayout(bindings);
-    descriptorSet = descriptorManager->allocateSet(descriptorSetLayout);
+    // Edits, lights and the resource table are rewritten from the CPU while earlier frames
+    // still read them, so each frame in flight gets its own copy
+    vk::DeviceSize storageAlignment = context.getPhysicalDevice().getProperties().limits.minStorageBufferOffsetAlignment;
+    editBuffer = PerFrameBuffer(context.getResourceManager(), sizeof(core::SDFEdit) * MAX_EDITS, storageAlignment,
+                                context.getFramesInFlight());
+    lightBuffer = PerFrameBuffer(context.getResourceManager(), sizeof(core::PointLight) * MAX_LIGHTS, storageAlignment,
+                                 context.getFramesInFlight());
+    resourceTable = PerFrameBuffer(context.getResourceManager(), sizeof(uint32_t) * resourceSlots.size(), storageAlignment,
+                                   context.getFramesInFlight());
+
+    // Fixed-size light list per cluster; the grid does not depend on resolution
+    clusterLightBuffer = context.getResourceManager().createBuffer(
+        sizeof(uint32_t) * CLUSTER_STRIDE * CLUSTER_X * CLUSTER_Y * CLUSTER_Z,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal
+    );
 
-    // Create SDF Edit buffer (max 256 edits)
-    editBuffer = context.getResourceManager().createBuffer(
-        sizeof(core::SDFEdit) * 256,
+    // Cleared on the first frame; a probe is only sampled once it has been traced
+    probeBuffer = context.getResourceManager().createBuffer(
+        sizeof(float) * 16 * PROBE_COUNT,
         vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
-        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+        vk::MemoryPropertyFlagBits::eDeviceLocal
     );
 
-    // Create selection buffer (hit index + vec3 pos)
-    selectionBuffer = context.getResourceManager().createBuffer(
-        sizeof(SelectionData),
-        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+    // Pick readback ring: one slot per frame in flight, mapped for the renderer's lifetime
+    pickBuffer = context.getResourceManager().createBuffer(
+        sizeof(PickEntry) * MAX_PICKS_PER_FRAME * context.getFramesInFlight(),
+        vk::BufferUsageFlagBits::eStorageBuffer,
         vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
     );
-
-    SelectionData clearVal{-1, 0, 0, 0};
-    void* clearPtr = context.getDevice().mapMemory(selectionBuffer.memory.get(), 0, sizeof(SelectionData));
-    std::memcpy(clearPtr, &clearVal, sizeof(SelectionData));
-    context.getDevice().unmapMemory(selectionBuffer.memory.get());
+    pickMapped = static_cast<PickEntry*>(pickBuffer.memory.getMappedData());
 
     // Push constant range
     vk::PushConstantRange pushConstantRange{};
@@ -66,14 +72,90 @@ SDFRenderer::SDFRenderer(core::VulkanContext& context) : context(context) {
     pushConstantRange.offset = 0;
     pushConstantRange.size = sizeof(PushConstants);
 
-    computePipeline = std::make_unique<ComputePipeline>(
-        context.getDevice(), 
-        "shaders/SDFCompute.spv", 
-        std::vector<vk::DescriptorSetLayout>{ descriptorSetLayout },
+    // All passes take their resources from the bindless heap and share one push constant block
+    vk::DescriptorSetLayout heapLayout = context.getBindlessHeap().getLayout();
+    tileCullPipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/SDFTileCull.spv",
+        std::vector<vk::DescriptorSetLayout>{ heapLayout },
+        std::vector<vk::PushConstantRange>{ pushConstantRange }
+    );
+    lightCullPipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/SDFLightCull.spv",
+        std::vector<vk::DescriptorSetLayout>{ heapLayout },
+        std::vector<vk::PushConstantRange>{ pushConstantRange }
+    );
+    probeUpdatePipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/SDFProbeUpdate.spv",
+        std::vector<vk::DescriptorSetLayout>{ heapLayout },
+        std::vector<vk::PushConstantRange>{ pushConstantRange }
+    );
+    visibilityPipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/SDFVisibility.spv",
+        std::vector<vk::DescriptorSetLayout>{ heapLayout },
+        std::vector<vk::PushConstantRange>{ pushConstantRange }
+    );
+    shadowPipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/SDFShadow.spv",
+        std::vector<vk::DescriptorSetLayout>{ heapLayout },
+        std::vector<vk::PushConstantRange>{ pushConstantRange }
+    );
+    // The march passes have a half-precision build for devices with shaderFloat16. Both are
+    // loaded so EngineBench --fp16-check can compare them in one run.
+    if (context.supportsShaderFloat16()) {
+        visibilityFp16Pipeline = std::make_unique<ComputePipeline>(
+            context.getDevice(),
+            context.getPipelineCache(),
+            "shaders/SDFVisibilityFP16.spv",
+            std::vector<vk::DescriptorSetLayout>{ heapLayout },
+            std::vector<vk::PushConstantRange>{ pushConstantRange }
+        );
+        shadowFp16Pipeline = std::make_unique<ComputePipeline>(
+            context.getDevice(),
+            context.getPipelineCache(),
+            "shaders/SDFShadowFP16.spv",
+            std::vector<vk::DescriptorSetLayout>{ heapLayout },
+            std::vector<vk::PushConstantRange>{ pushConstantRange }
+        );
+        fp16Evaluation = true;
+    }
+    lightingPipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/SDFLighting.spv",
+        std::vector<vk::DescriptorSetLayout>{ heapLayout },
+        std::vector<vk::PushConstantRange>{ pushConstantRange }
+    );
+    pickPipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/SDFPick.spv",
+        std::vector<vk::DescriptorSetLayout>{ heapLayout },
         std::vector<vk::PushConstantRange>{ pushConstantRange }
     );
 
-    auto extent = context.getSwapchain()->getExtent();
+    // Direct present: lighting stores straight into the swapchain image, skipping outputImage and the blit
+    if (context.supportsDirectPresent()) {
+        lightingPresentPipeline = std::make_unique<ComputePipeline>(
+            context.getDevice(),
+            context.getPipelineCache(),
+            "shaders/SDFLightingPresent.spv",
+            std::vector<vk::DescriptorSetLayout>{ heapLayout },
+            std::vector<vk::PushConstantRange>{ pushConstantRange }
+        );
+        directPresent = true;
+    }
+
+    auto extent = context.getTargetExtent();
     outputWidth = extent.width;
     outputHeight = extent.height;
 
@@ -86,6 +168,11 @@ SDFRenderer::SDFRenderer(core::VulkanContext& context) : context(context) {
         vk::ImageViewType::e2D
     );
 
+    createScreenResources();
+
+    // G-Buffer views change whenever the graph re-plans its transient memory
+    context.getRenderGraph().addReallocCallback([this] { updateGBufferSlots(); });
+
     pushConstants.camPosX = camPosX;
     pushConstants.camPosY = camPosY;
     pushConstants.camPosZ = camPosZ;
@@ -93,35 +180,90 @@ SDFRenderer::SDFRenderer(core::VulkanContext& context) : context(context) {
     pushConstants.resY = static_cast<float>(outputHeight);
     pushConstants.time = 0.0f;
     pushConstants.editCount = 0.0f;
-    pushConstants.mouseX = -1.0f;
-    pushConstants.mouseY = -1.0f;
-    pushConstants.renderMode = renderMode;
-    pushConstants.showGround = showGround ? 1 : 0;
+    pushConstants.lightCount = 0;
+    pushConstants.probeOffset = 0;
+    pushConstants.giIntensity = giIntensity;
+    pushConstants.pickBase = 0;
+    pushConstants.pickCount = 0;
     pushConstants.brushX = 0;
     pushConstants.brushY = 0;
     pushConstants.brushZ = 0;
     pushConstants.brushRadius = 0;
-    pushConstants.showGrid = showGrid ? 1 : 0;
+    pushConstants.shadowScale = static_cast<float>(shadowScale);
+    pushConstants.frameIndex = 0;
+    pushConstants.historyValid = 0;
+
+    registerResources();
+
+    // Every preset is compiled up front through the pipeline cache, so switching presets
+    // never waits on a compile. Other toggles build their variants in the background.
+    activeVariant = currentVariant();
+    specConstants = buildSpecializationConstants(activeVariant);
+    for (QualityPreset preset : { QualityPreset::Low, QualityPreset::Medium, QualityPreset::High, QualityPreset::Ultra }) {
+        VariantState state = activeVariant;
+        state.quality = preset;
+        SpecializationConstants constants = buildSpecializationConstants(state);
+        for (ComputePipeline* pipeline : getPipelines()) {
+            pipeline->getPipeline(constants);
+        }
+    }
 
-    createDescriptorSets();
+    for (ComputePipeline* pipeline : getPipelines()) {
+        context.getShaderReload().watch(pipeline);
+    }
 }
 
 SDFRenderer::~SDFRenderer() {
+    // The variant build uses the pipeline layouts
+    if (pendingVariants.valid()) {
+        pendingVariants.wait();
+    }
+    for (ComputePipeline* pipeline : getPipelines()) {
+        context.getShaderReload().unwatch(pipeline);
+    }
     if (terrainSampler) {
         context.getDevice().destroySampler(terrainSampler);
     }
+
+    auto& heap = context.getBindlessHeap();
+    for (uint32_t frame = 0; frame < context.getFramesInFlight(); frame++) {
+        heap.release(BindlessHeap::Kind::StorageBuffer, tableSlots[frame]);
+        heap.release(BindlessHeap::Kind::StorageBuffer, editSlots[frame]);
+        heap.release(BindlessHeap::Kind::StorageBuffer, lightSlots[frame]);
+    }
+    heap.release(BindlessHeap::Kind::StorageImage, presentSlot);
+    for (ResourceSlot entry : { ResourceSlot::BrickAtlas, ResourceSlot::SparseMap, ResourceSlot::Output,
+                                ResourceSlot::GBufferDepth, ResourceSlot::GBufferNormal, ResourceSlot::GBufferAlbedo,
+                                ResourceSlot::GBufferInfo, ResourceSlot::ShadowHistory }) {
+        heap.release(BindlessHeap::Kind::StorageImage, slot(entry));
+    }
+    for (ResourceSlot entry : { ResourceSlot::TerrainHeight, ResourceSlot::TerrainSplat, ResourceSlot::TerrainMinMax }) {
+        heap.release(BindlessHeap::Kind::SampledImage, slot(entry));
+    }
+    for (ResourceSlot entry : { ResourceSlot::Picks, ResourceSlot::HitList, ResourceSlot::TileEdits,
+                                ResourceSlot::ClusterLights, ResourceSlot::Probes }) {
+        heap.release(BindlessHeap::Kind::StorageBuffer, slot(entry));
+    }
 }
 
 void SDFRenderer::update(float deltaTime, const core::InputState& input, bool imguiCapture) {
+    ENGINE_PROFILE_ZONE("Renderer Update");
+    // Last frame's camera becomes the reprojection source
+    pushConstants.prevCamPosX = pushConstants.camPosX;
+    pushConstants.prevCamPosY = pushConstants.camPosY;
+    pushConstants.prevCamPosZ = pushConstants.camPosZ;
+    pushConstants.prevCamDirX = pushConstants.camDirX;
+    pushConstants.prevCamDirY = pushConstants.camDirY;
+    pushConstants.prevCamDirZ = pushConstants.camDirZ;
+
     totalTime += deltaTime;
     pushConstants.time = totalTime;
-    pushConstants.renderMode = renderMode;
-    pushConstants.showGround = showGround ? 1 : 0;
-    pushConstants.showGrid = showGrid ? 1 : 0;
     pushConstants.brushX = brushX;
     pushConstants.brushY = brushY;
     pushConstants.brushZ = brushZ;
     pushConstants.brushRadius = brushRadius;
+    pushConstants.shadowScale = static_cast<float>(shadowScale);
+    pushConstants.giIntensity = giIntensity;
 
     // Camera control: only when right-click is held and ImGui doesn't capture
     if (input.mouseCaptured && !imguiCapture) {
@@ -195,166 +337,544 @@ void SDFRenderer::update(float deltaTime, const core::InputState& input, bool im
     pushConstants.camDirZ = dirZ;
     pushConstants.editCount = static_cast<float>(edits.size());
 
-    // Reset picking if not explicitly requested this frame
-    if (!pickingRequested) {
-        pushConstants.mouseX = -1.0f;
-        pushConstants.mouseY = -1.0f;
-    }
-
-    // Upload edits if changed
+    // New versions of edits and lights; each frame slot picks them up in render
     if (editsDirty) {
-        updateEditBuffer();
+        editBuffer.invalidate();
         editsDirty = false;
     }
+
+    if (lightsDirty) {
+        lightBuffer.invalidate();
+        lightsDirty = false;
+    }
+    pushConstants.lightCount = static_cast<uint32_t>(std::min<size_t>(lights.size(), MAX_LIGHTS));
 }
 
-void SDFRenderer::render(vk::CommandBuffer commandBuffer) {
+void SDFRenderer::render(RenderGraph& graph) {
+    ENGINE_PROFILE_ZONE("Renderer Declare Passes");
     if (terrain) {
-        terrain->executePending(commandBuffer);
-    }
-
-    vk::ImageMemoryBarrier barrier{};
-    barrier.oldLayout = vk::ImageLayout::eUndefined;
-    barrier.newLayout = vk::ImageLayout::eGeneral;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = outputImage.image.get();
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.srcAccessMask = vk::AccessFlagBits::eNone;
-    barrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
-
-    commandBuffer.pipelineBarrier(
-        vk::PipelineStageFlagBits::eTopOfPipe,
-        vk::PipelineStageFlagBits::eComputeShader,
-        {}, nullptr, nullptr, barrier
-    );
+        terrain->executePending(graph);
+    }
 
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline->getPipeline());
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipeline->getLayout(), 0, 1, &descriptorSet, 0, nullptr);
-    
-    commandBuffer.pushConstants(
-        computePipeline->getLayout(),
-        vk::ShaderStageFlagBits::eCompute,
-        0, sizeof(PushConstants), &pushConstants
-    );
+    uint32_t frame = context.getCurrentFrame();
+    updateEditBuffer(frame);
+    updateLightBuffer(frame);
+
+    // This frame's copy of the resource table, with its per-frame entries filled in
+    auto table = resourceSlots;
+    table[static_cast<size_t>(ResourceSlot::Edits)] = editSlots[frame];
+    table[static_cast<size_t>(ResourceSlot::Lights)] = lightSlots[frame];
+    if (directPresent) {
+        table[static_cast<size_t>(ResourceSlot::PresentTarget)] = presentSlot + context.getImageIndex();
+    }
+    resourceTable.invalidate();
+    resourceTable.update(frame, table.data(), sizeof(table));
+    pushConstants.resourceTable = tableSlots[frame];
+
+    uint32_t pickCount = resolvePicks();
+
+    // Passes follow the active variant, which may trail the toggles while a build runs
+    selectVariants();
+    uint32_t activeMode = activeVariant.renderMode;
+
+    // Fixed ray budget: a window of whole probes, advancing round-robin through the grid
+    bool updateProbes = activeVariant.probeGI && activeMode == 0;
+    uint32_t probeUpdates = std::clamp(giRayBudget / RAYS_PER_PROBE, 1u, PROBE_COUNT);
+    pushConstants.probeOffset = probeCursor;
+    if (updateProbes) {
+        probeCursor = (probeCursor + probeUpdates) % PROBE_COUNT;
+    }
+
+    // History is only meaningful if last frame produced it in the lit view
+    pushConstants.historyValid = (historyInitialized && lastRenderMode == 0 && activeMode == 0) ? 1 : 0;
+    lastRenderMode = activeMode;
+    historyInitialized = true;
+
+    // Depth and normal become copyable once a capture has been requested
+    if (gbufferCaptureRequested && !gbufferCaptureBuffer.buffer) {
+        gbufferCaptureBuffer = context.getResourceManager().createBuffer(
+            (sizeof(float) + sizeof(uint16_t) * 4) * outputWidth * outputHeight,
+            vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+        );
+    }
+    vk::ImageUsageFlags readback = gbufferCaptureBuffer.buffer ? vk::ImageUsageFlagBits::eTransferSrc : vk::ImageUsageFlags{};
+
+    // The G-Buffer only lives from visibility to lighting, so the graph owns (and may alias) it
+    auto gbufferTarget = [&](const char* name, vk::Format format, vk::ImageUsageFlags usage) {
+        return graph.createImage(name, { outputWidth, outputHeight, format, vk::ImageUsageFlagBits::eStorage | usage });
+    };
+    auto depth = gbufferTarget(GBUFFER_DEPTH, vk::Format::eR32Sfloat, readback);
+    auto normal = gbufferTarget(GBUFFER_NORMAL, vk::Format::eR16G16B16A16Sfloat, readback);
+    auto albedo = gbufferTarget(GBUFFER_ALBEDO, vk::Format::eR8G8B8A8Unorm, {});
+    auto info = gbufferTarget(GBUFFER_INFO, vk::Format::eR32Uint, {});
+
+    auto heightmap = graph.importImage("Terrain Height", terrain->getHeightmap().image.get(), 1, vk::ImageLayout::eGeneral);
+    auto splatmap = graph.importImage("Terrain Splat", terrain->getSplatmap().image.get(), 1, vk::ImageLayout::eGeneral);
+    auto minMax = graph.importImage("Terrain MinMax", terrain->getMinMaxPyramid().image.get(), terrain->getPyramidLevels(), vk::ImageLayout::eGeneral);
+    auto historyCurrent = graph.importImage("Shadow History", shadowHistory[pushConstants.frameIndex & 1u].image.get());
+    auto historyPrevious = graph.importImage("Shadow History (previous)", shadowHistory[(pushConstants.frameIndex + 1u) & 1u].image.get());
+    auto output = directPresent ? context.getTargetImage() : graph.importImage("Output", outputImage.image.get());
+
+    auto hitList = graph.importBuffer("Hit List", hitListBuffer.buffer.get());
+    auto tileEdits = graph.importBuffer("Tile Edits", tileEditBuffer.buffer.get());
+    auto clusterLights = graph.importBuffer("Cluster Lights", clusterLightBuffer.buffer.get());
+    auto probes = graph.importBuffer("Probes", probeBuffer.buffer.get());
+    auto picks = graph.importBuffer("Pick Ring", pickBuffer.buffer.get());
+
+    // Passes record when the graph executes, so they take this frame's constants by value
+    auto bind = [this, specConstants = specConstants, constants = pushConstants](vk::CommandBuffer cmd, ComputePipeline& pipeline) {
+        cmd.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline.getPipeline(specConstants));
+        context.getBindlessHeap().bind(cmd, pipeline.getLayout());
+        cmd.pushConstants(pipeline.getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PushConstants), &constants);
+    };
 
     uint32_t groupX = (outputWidth + 7) / 8;
     uint32_t groupY = (outputHeight + 7) / 8;
-    commandBuffer.dispatch(groupX, groupY, 1);
-
-    // After dispatch, if we were picking, we need a barrier to ensure write is visible to host
-    if (pickingRequested) {
-        vk::BufferMemoryBarrier pickingBarrier{};
-        pickingBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
-        pickingBarrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
-        pickingBarrier.buffer = selectionBuffer.buffer.get();
-        pickingBarrier.offset = 0;
-        pickingBarrier.size = sizeof(SelectionData);
-
-        commandBuffer.pipelineBarrier(
-            vk::PipelineStageFlagBits::eComputeShader,
-            vk::PipelineStageFlagBits::eHost,
-            {}, nullptr, pickingBarrier, nullptr
-        );
-        pickingRequested = false; 
+
+    // Reset the hit list: empty dispatch (0, 1, 1) and zero count
+    graph.addPass("Hit List Reset")
+        .write(hitList, ResourceUsage::TransferWrite)
+        .execute([buffer = hitListBuffer.buffer.get()](vk::CommandBuffer cmd) {
+            const uint32_t hitListHeader[4] = { 0, 1, 1, 0 };
+            cmd.updateBuffer(buffer, 0, sizeof(hitListHeader), hitListHeader);
+        });
+
+    if (!probesInitialized) {
+        graph.addPass("Probe Clear")
+            .write(probes, ResourceUsage::TransferWrite)
+            .execute([buffer = probeBuffer.buffer.get()](vk::CommandBuffer cmd) {
+                cmd.fillBuffer(buffer, 0, VK_WHOLE_SIZE, 0);
+            });
+        probesInitialized = true;
     }
 
-    barrier.oldLayout = vk::ImageLayout::eGeneral;
-    barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
-    barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
-    barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+    // Tile cull: one group per visibility group builds that tile's edit list
+    graph.addPass("Tile Cull")
+        .write(tileEdits, ResourceUsage::ComputeWrite)
+        .execute([=, this](vk::CommandBuffer cmd) {
+            bind(cmd, *tileCullPipeline);
+            cmd.dispatch(groupX, groupY, 1);
+        });
+
+    // Light cull: one group per cluster; the lighting pass skips the lists when there are no lights
+    if (pushConstants.lightCount > 0) {
+        graph.addPass("Light Cull")
+            .write(clusterLights, ResourceUsage::ComputeWrite)
+            .execute([=, this](vk::CommandBuffer cmd) {
+                bind(cmd, *lightCullPipeline);
+                cmd.dispatch(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+            });
+    }
 
-    commandBuffer.pipelineBarrier(
-        vk::PipelineStageFlagBits::eComputeShader,
-        vk::PipelineStageFlagBits::eTransfer,
-        {}, nullptr, nullptr, barrier
-    );
+    // Probe update: RAYS_PER_PROBE rays for each probe in this frame's window
+    if (updateProbes) {
+        graph.addPass("Probe Update")
+            .write(probes, ResourceUsage::ComputeReadWrite)
+            .read(heightmap, ResourceUsage::ComputeRead)
+            .read(splatmap, ResourceUsage::ComputeRead)
+            .read(minMax, ResourceUsage::ComputeRead)
+            .execute([=, this](vk::CommandBuffer cmd) {
+                bind(cmd, *probeUpdatePipeline);
+                cmd.dispatch(probeUpdates, 1, 1);
+            });
+    }
+
+    // Visibility: march primary rays into the G-Buffer, append lit pixels to the hit list
+    bool fp16 = fp16Evaluation;
+    graph.addPass("Visibility")
+        .discard(depth, ResourceUsage::ComputeWrite)
+        .discard(normal, ResourceUsage::ComputeWrite)
+        .discard(albedo, ResourceUsage::ComputeWrite)
+        .discard(info, ResourceUsage::ComputeWrite)
+        .write(historyCurrent, ResourceUsage::ComputeWrite)
+        .write(hitList, ResourceUsage::ComputeReadWrite)
+        .read(tileEdits, ResourceUsage::ComputeRead)
+        .read(heightmap, ResourceUsage::ComputeRead)
+        .read(splatmap, ResourceUsage::ComputeRead)
+        .read(minMax, ResourceUsage::ComputeRead)
+        .execute([=, this](vk::CommandBuffer cmd) {
+            bind(cmd, fp16 ? *visibilityFp16Pipeline : *visibilityPipeline);
+            cmd.dispatch(groupX, groupY, 1);
+        });
+
+    // Shadow/AO: only the compacted lit pixels, sized by the visibility pass
+    if (activeMode == 0) {
+        graph.addPass("Shadow")
+            .read(hitList, ResourceUsage::IndirectRead)
+            .read(hitList, ResourceUsage::ComputeRead)
+            .read(depth, ResourceUsage::ComputeRead)
+            .read(normal, ResourceUsage::ComputeRead)
+            .read(historyPrevious, ResourceUsage::ComputeRead)
+            .write(historyCurrent, ResourceUsage::ComputeReadWrite)
+            .read(heightmap, ResourceUsage::ComputeRead)
+            .read(minMax, ResourceUsage::ComputeRead)
+            .execute([=, this, buffer = hitListBuffer.buffer.get()](vk::CommandBuffer cmd) {
+                bind(cmd, fp16 ? *shadowFp16Pipeline : *shadowPipeline);
+                cmd.dispatchIndirect(buffer, 0);
+            });
+    }
+
+    // Lighting: resolve G-Buffer, shade and tonemap into the output (or swapchain) image
+    bool present = directPresent;
+    graph.addPass("Lighting")
+        .read(depth, ResourceUsage::ComputeRead)
+        .read(normal, ResourceUsage::ComputeRead)
+        .read(albedo, ResourceUsage::ComputeRead)
+        .read(info, ResourceUsage::ComputeRead)
+        .read(historyCurrent, ResourceUsage::ComputeRead)
+        .read(clusterLights, ResourceUsage::ComputeRead)
+        .read(probes, ResourceUsage::ComputeRead)
+        .discard(output, ResourceUsage::ComputeWrite)
+        .execute([=, this](vk::CommandBuffer cmd) {
+            bind(cmd, present ? *lightingPresentPipeline : *lightingPipeline);
+            cmd.dispatch(groupX, groupY, 1);
+        });
+
+    // G-Buffer capture: the targets only exist within the frame, so they are copied out here
+    if (gbufferCaptureRequested) {
+        auto capture = graph.importBuffer("G-Buffer Capture", gbufferCaptureBuffer.buffer.get());
+        graph.addPass("G-Buffer Capture")
+            .read(depth, ResourceUsage::TransferRead)
+            .read(normal, ResourceUsage::TransferRead)
+            .write(capture, ResourceUsage::TransferWrite)
+            .execute([&graph, width = outputWidth, height = outputHeight,
+                      buffer = gbufferCaptureBuffer.buffer.get()](vk::CommandBuffer cmd) {
+                vk::BufferImageCopy region{};
+                region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+                region.imageSubresource.layerCount = 1;
+                region.imageExtent = vk::Extent3D{ width, height, 1 };
+                cmd.copyImageToBuffer(graph.getTransientImage(GBUFFER_DEPTH), vk::ImageLayout::eTransferSrcOptimal,
+                                      buffer, 1, &region);
+                region.bufferOffset = sizeof(float) * width * height;
+                cmd.copyImageToBuffer(graph.getTransientImage(GBUFFER_NORMAL), vk::ImageLayout::eTransferSrcOptimal,
+                                      buffer, 1, &region);
+            });
+        graph.addPass("G-Buffer Readback").read(capture, ResourceUsage::HostRead);
+        gbufferCaptureRequested = false;
+        gbufferCapturePending = true;
+    }
+
+    // Pick: one invocation per queued ray, results read back after this frame's fence
+    if (pickCount > 0) {
+        graph.addPass("Pick")
+            .write(picks, ResourceUsage::ComputeReadWrite)
+            .read(heightmap, ResourceUsage::ComputeRead)
+            .read(minMax, ResourceUsage::ComputeRead)
+            .execute([=, this](vk::CommandBuffer cmd) {
+                bind(cmd, *pickPipeline);
+                cmd.dispatch((pickCount + 63) / 64, 1, 1);
+            });
+        graph.addPass("Pick Readback").read(picks, ResourceUsage::HostRead);
+    }
+
+    pushConstants.frameIndex++;
 }
 
-void SDFRenderer::updateEditBuffer() {
-    if (edits.empty()) return;
+std::vector<ComputePipeline*> SDFRenderer::getPipelines() const {
+    std::vector<ComputePipeline*> pipelines;
+    for (ComputePipeline* pipeline : { tileCullPipeline.get(), lightCullPipeline.get(), probeUpdatePipeline.get(),
+                                       visibilityPipeline.get(), shadowPipeline.get(), visibilityFp16Pipeline.get(),
+                                       shadowFp16Pipeline.get(), lightingPipeline.get(), lightingPresentPipeline.get(),
+                                       pickPipeline.get() }) {
+        if (pipeline) pipelines.push_back(pipeline);
+    }
+    return pipelines;
+}
+
+void SDFRenderer::selectVariants() {
+    // A build that raced a hot reload is dropped by addVariants; its pipeline then shows
+    // up as missing below and is queued again from the new SPIR-V
+    if (pendingVariants.valid() && pendingVariants.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        auto programs = pendingVariants.get();
+        for (size_t i = 0; i < programs.size(); i++) {
+            pendingPipelines[i]->addVariants(std::move(programs[i]));
+        }
+        pendingPipelines.clear();
+    }
+
+    VariantState requested = currentVariant();
+    if (requested != activeVariant && !pendingVariants.valid()) {
+        SpecializationConstants constants = buildSpecializationConstants(requested);
+        std::vector<ComputePipeline*> missing;
+        for (ComputePipeline* pipeline : getPipelines()) {
+            if (!pipeline->hasVariant(constants)) missing.push_back(pipeline);
+        }
+
+        if (missing.empty()) {
+            activeVariant = requested;
+            specConstants = std::move(constants);
+        } else {
+            // The worker gets copies of the SPIR-V, since hot reload may swap programs meanwhile.
+            // Layouts live as long as the pipelines, and the destructor waits for the build.
+            std::vector<std::pair<vk::PipelineLayout, std::vector<uint32_t>>> sources;
+            for (ComputePipeline* pipeline : missing) {
+                sources.emplace_back(pipeline->getLayout(), pipeline->getSpirv());
+            }
+            pendingPipelines = std::move(missing);
+            pendingVariants = std::async(std::launch::async,
+                [device = context.getDevice(), cache = context.getPipelineCache(), sources = std::move(sources), constants] {
+                    std::vector<ComputePipeline::Program> programs;
+                    for (const auto& [layout, spirv] : sources) {
+                        programs.push_back(ComputePipeline::buildProgram(device, cache, layout, spirv, { constants }));
+                    }
+                    return programs;
+                });
+        }
+    }
+
+    // Hot reload rebuilds the variants in use when it started, so one may still be missing
+    // after a swap. Compile it here: passes may record on worker threads, which only look up.
+    for (ComputePipeline* pipeline : getPipelines()) {
+        pipeline->getPipeline(specConstants);
+    }
+}
 
-    size_t uploadSize = sizeof(core::SDFEdit) * edits.size();
-    if (uploadSize > sizeof(core::SDFEdit) * 256) {
-        uploadSize = sizeof(core::SDFEdit) * 256;
+void SDFRenderer::waitForVariants() {
+    selectVariants();
+    if (pendingVariants.valid()) {
+        pendingVariants.wait();
+        selectVariants();
     }
+}
+
+SpecializationConstants SDFRenderer::buildSpecializationConstants(const VariantState& state) {
+    struct Tier { uint32_t marchSteps, shadowSteps, aoTaps; float maxDist; uint32_t pointShadows; };
+    static constexpr Tier tiers[] = {
+        {  64, 16, 3,  60.0f, 1 }, // Low
+        {  96, 24, 4,  80.0f, 2 }, // Medium
+        { 128, 32, 5, 100.0f, 2 }, // High
+        { 256, 64, 6, 200.0f, 4 }  // Ultra
+    };
+    static_assert(std::ranges::all_of(tiers, [](const Tier& tier) { return tier.pointShadows <= MAX_POINT_SHADOWS; }),
+                  "pointShadows must not exceed the lighting shader's array size");
+    const Tier& tier = tiers[static_cast<uint32_t>(state.quality)];
+
+    return {
+        { static_cast<uint32_t>(SpecConstant::MaxMarchSteps), tier.marchSteps },
+        { static_cast<uint32_t>(SpecConstant::ShadowSteps), tier.shadowSteps },
+        { static_cast<uint32_t>(SpecConstant::AOTaps), tier.aoTaps },
+        { static_cast<uint32_t>(SpecConstant::MaxMarchDist), specFloat(tier.maxDist) },
+        { static_cast<uint32_t>(SpecConstant::RenderMode), state.renderMode },
+        { static_cast<uint32_t>(SpecConstant::ShowGround), state.showGround ? VK_TRUE : VK_FALSE },
+        { static_cast<uint32_t>(SpecConstant::ShowGrid), state.showGrid ? VK_TRUE : VK_FALSE },
+        { static_cast<uint32_t>(SpecConstant::StageEdits), state.stageEdits ? VK_TRUE : VK_FALSE },
+        { static_cast<uint32_t>(SpecConstant::PointShadows), tier.pointShadows },
+        { static_cast<uint32_t>(SpecConstant::ProbeGI), state.probeGI ? VK_TRUE : VK_FALSE }
+    };
+}
+
+void SDFRenderer::createScreenResources() {
+    auto& rm = context.getResourceManager();
 
-    void* data = context.getDevice().mapMemory(
-        editBuffer.memory.get(), 0, uploadSize
+    createShadowHistory();
+
+    // 16 byte header (VkDispatchIndirectCommand + count) followed by one packed pixel per hit
+    hitListBuffer = rm.createBuffer(
+        sizeof(uint32_t) * 4 + sizeof(uint32_t) * outputWidth * outputHeight,
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal
+    );
+
+    // One fixed-size edit list per 8x8 visibility tile
+    uint32_t tileCount = ((outputWidth + 7) / 8) * ((outputHeight + 7) / 8);
+    tileEditBuffer = rm.createBuffer(
+        sizeof(uint32_t) * TILE_STRIDE * tileCount,
+        vk::BufferUsageFlagBits::eStorageBuffer,
+        vk::MemoryPropertyFlagBits::eDeviceLocal
     );
-    std::memcpy(data, edits.data(), uploadSize);
-    context.getDevice().unmapMemory(editBuffer.memory.get());
 }
 
-void SDFRenderer::createDescriptorSets() {
-    vk::DescriptorImageInfo atlasInfo{};
-    atlasInfo.imageView = context.getBrickAtlas().getAtlasView();
-    atlasInfo.imageLayout = vk::ImageLayout::eGeneral;
-
-    vk::DescriptorImageInfo mapInfo{};
-    mapInfo.imageView = context.getSparseMap().getMapView();
-    mapInfo.imageLayout = vk::ImageLayout::eGeneral;
-
-    vk::DescriptorImageInfo outInfo{};
-    outInfo.imageView = outputImage.view.get();
-    outInfo.imageLayout = vk::ImageLayout::eGeneral;
-
-    vk::DescriptorBufferInfo editBufInfo{};
-    editBufInfo.buffer = editBuffer.buffer.get();
-    editBufInfo.offset = 0;
-    editBufInfo.range = sizeof(core::SDFEdit) * 256;
-
-    vk::DescriptorBufferInfo selectBufInfo{};
-    selectBufInfo.buffer = selectionBuffer.buffer.get();
-    selectBufInfo.offset = 0;
-    selectBufInfo.range = sizeof(SelectionData);
-
-    vk::DescriptorImageInfo diffInfo{};
-    diffInfo.imageLayout = vk::ImageLayout::eGeneral; // Using General as it's also storage
-    diffInfo.imageView = terrain->getHeightmap().view.get();
-    diffInfo.sampler = terrainSampler;
-
-    vk::DescriptorImageInfo splatInfo{};
-    splatInfo.imageLayout = vk::ImageLayout::eGeneral;
-    splatInfo.imageView = terrain->getSplatmap().view.get();
-    splatInfo.sampler = terrainSampler;
-
-    std::vector<vk::WriteDescriptorSet> writes = {
-        { descriptorSet, 0, 0, 1, vk::DescriptorType::eStorageImage, &atlasInfo, nullptr, nullptr },
-        { descriptorSet, 1, 0, 1, vk::DescriptorType::eStorageImage, &mapInfo, nullptr, nullptr },
-        { descriptorSet, 2, 0, 1, vk::DescriptorType::eStorageImage, &outInfo, nullptr, nullptr },
-        { descriptorSet, 3, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &editBufInfo, nullptr },
-        { descriptorSet, 4, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &selectBufInfo, nullptr },
-        { descriptorSet, 5, 0, 1, vk::DescriptorType::eCombinedImageSampler, &diffInfo, nullptr, nullptr },
-        { descriptorSet, 6, 0, 1, vk::DescriptorType::eCombinedImageSampler, &splatInfo, nullptr, nullptr }
+void SDFRenderer::createShadowHistory() {
+    uint32_t width = (outputWidth + shadowScale - 1) / shadowScale;
+    uint32_t height = (outputHeight + shadowScale - 1) / shadowScale;
+
+    // Frames in flight may still use the old images and their heap slots
+    auto& heap = context.getBindlessHeap();
+    heap.release(BindlessHeap::Kind::StorageImage, slot(ResourceSlot::ShadowHistory));
+    for (auto& history : shadowHistory) {
+        if (history.image) {
+            context.getRenderGraph().forgetImage(history.image.get());
+            context.getTransferManager().destroyLater(std::move(history));
+        }
+        history = context.getResourceManager().createImage(
+            width, height, 1,
+            vk::Format::eR16G16B16A16Sfloat,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eStorage,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            vk::ImageViewType::e2D
+        );
+    }
+    slot(ResourceSlot::ShadowHistory) = heap.addStorageImages({ shadowHistory[0].view.get(), shadowHistory[1].view.get() });
+    historyInitialized = false;
+}
+
+void SDFRenderer::setShadowScale(uint32_t scale) {
+    if (scale == shadowScale || (scale != 2 && scale != 4)) return;
+
+    // New images in new heap slots; the old ones are freed once in-flight frames finish
+    shadowScale = scale;
+    pushConstants.shadowScale = static_cast<float>(shadowScale);
+    createShadowHistory();
+}
+
+void SDFRenderer::updateEditBuffer(uint32_t frame) {
+    ENGINE_PROFILE_ZONE("Upload Edits");
+
+    size_t uploadSize = sizeof(core::SDFEdit) * std::min<size_t>(edits.size(), MAX_EDITS);
+    editBuffer.update(frame, edits.data(), uploadSize);
+}
+
+void SDFRenderer::updateLightBuffer(uint32_t frame) {
+    ENGINE_PROFILE_ZONE("Upload Lights");
+
+    size_t uploadSize = sizeof(core::PointLight) * std::min<size_t>(lights.size(), MAX_LIGHTS);
+    lightBuffer.update(frame, lights.data(), uploadSize);
+}
+
+void SDFRenderer::registerResources() {
+    auto& heap = context.getBindlessHeap();
+
+    slot(ResourceSlot::BrickAtlas) = heap.addStorageImage(context.getBrickAtlas().getAtlasView());
+    slot(ResourceSlot::SparseMap) = heap.addStorageImage(context.getSparseMap().getMapView());
+    slot(ResourceSlot::Output) = heap.addStorageImage(outputImage.view.get());
+    slot(ResourceSlot::Picks) = heap.addStorageBuffer(pickBuffer.buffer.get());
+
+    // Only read with texelFetch, so the linear sampler's filtering never applies to the pyramid
+    slot(ResourceSlot::TerrainHeight) = heap.addSampledImage(terrain->getHeightmap().view.get(), terrainSampler);
+    slot(ResourceSlot::TerrainSplat) = heap.addSampledImage(terrain->getSplatmap().view.get(), terrainSampler);
+    slot(ResourceSlot::TerrainMinMax) = heap.addSampledImage(terrain->getMinMaxPyramid().view.get(), terrainSampler);
+
+    slot(ResourceSlot::HitList) = heap.addStorageBuffer(hitListBuffer.buffer.get());
+    slot(ResourceSlot::TileEdits) = heap.addStorageBuffer(tileEditBuffer.buffer.get());
+    slot(ResourceSlot::ClusterLights) = heap.addStorageBuffer(clusterLightBuffer.buffer.get());
+    slot(ResourceSlot::Probes) = heap.addStorageBuffer(probeBuffer.buffer.get());
+
+    // One heap slot per frame copy
+    for (uint32_t frame = 0; frame < context.getFramesInFlight(); frame++) {
+        tableSlots[frame] = heap.addStorageBuffer(resourceTable.getBuffer(), resourceTable.getOffset(frame),
+                                                  resourceTable.getSlotSize());
+        editSlots[frame] = heap.addStorageBuffer(editBuffer.getBuffer(), editBuffer.getOffset(frame),
+                                                 editBuffer.getSlotSize());
+        lightSlots[frame] = heap.addStorageBuffer(lightBuffer.getBuffer(), lightBuffer.getOffset(frame),
+                                                  lightBuffer.getSlotSize());
+    }
+
+    if (directPresent) {
+        presentSlot = heap.addStorageImages(context.getTargetImageViews());
+    }
+
+    updateGBufferSlots();
+}
+
+void SDFRenderer::updateGBufferSlots() {
+    // The G-Buffer is allocated by the graph on its first execute, which calls back here.
+    // Re-planning waits for the device to go idle, so the slots can be rewritten in place.
+    RenderGraph& graph = context.getRenderGraph();
+    auto& heap = context.getBindlessHeap();
+    std::pair<ResourceSlot, const char*> targets[] = {
+        { ResourceSlot::GBufferDepth, GBUFFER_DEPTH },
+        { ResourceSlot::GBufferNormal, GBUFFER_NORMAL },
+        { ResourceSlot::GBufferAlbedo, GBUFFER_ALBEDO },
+        { ResourceSlot::GBufferInfo, GBUFFER_INFO }
     };
+    for (const auto& [entry, name] : targets) {
+        vk::ImageView view = graph.getTransientView(name);
+        if (!view) continue;
+        if (slot(entry) == BindlessHeap::INVALID) {
+            slot(entry) = heap.addStorageImage(view);
+        } else {
+            heap.setStorageImage(slot(entry), view);
+        }
+    }
+}
 
-    descriptorManager->updateSet(descriptorSet, writes);
+void SDFRenderer::requestPicks(std::vector<glm::vec2> pixels, PickCallback callback) {
+    if (pixels.size() <= MAX_PICKS_PER_FRAME) {
+        pendingPicks.push_back({ std::move(pixels), std::move(callback) });
+        return;
+    }
+
+    // Too many for one slot: queue slot-sized parts, and the last part to resolve delivers
+    // the whole batch
+    struct Gather {
+        std::vector<SelectionData> results;
+        size_t remainingParts;
+        PickCallback callback;
+    };
+    size_t parts = (pixels.size() + MAX_PICKS_PER_FRAME - 1) / MAX_PICKS_PER_FRAME;
+    auto gather = std::make_shared<Gather>(Gather{ std::vector<SelectionData>(pixels.size()), parts, std::move(callback) });
+    for (size_t first = 0; first < pixels.size(); first += MAX_PICKS_PER_FRAME) {
+        size_t last = std::min<size_t>(first + MAX_PICKS_PER_FRAME, pixels.size());
+        std::vector<glm::vec2> part(pixels.begin() + first, pixels.begin() + last);
+        pendingPicks.push_back({ std::move(part), [gather, first](const std::vector<SelectionData>& results) {
+            std::copy(results.begin(), results.end(), gather->results.begin() + first);
+            if (--gather->remainingParts == 0) {
+                gather->callback(gather->results);
+            }
+        } });
+    }
 }
 
-void SDFRenderer::triggerPicking(float x, float y) {
-    pushConstants.mouseX = x;
-    pushConstants.mouseY = y;
-    pickingRequested = true;
+void SDFRenderer::requestPick(float x, float y, std::function<void(const SelectionData&)> callback) {
+    requestPicks({ glm::vec2(x, y) }, [callback = std::move(callback)](const std::vector<SelectionData>& results) {
+        callback(results[0]);
+    });
 }
 
-SDFRenderer::SelectionData SDFRenderer::getSelection() {
-    SelectionData result{-1, 0, 0, 0};
-    void* data = context.getDevice().mapMemory(selectionBuffer.memory.get(), 0, sizeof(SelectionData));
-    std::memcpy(&result, data, sizeof(SelectionData));
-    context.getDevice().unmapMemory(selectionBuffer.memory.get());
+bool SDFRenderer::readGBufferCapture(GBufferCapture& capture) {
+    if (!gbufferCapturePending) return false;
+
+    size_t pixels = static_cast<size_t>(outputWidth) * outputHeight;
+    const auto* mapped = static_cast<const uint8_t*>(gbufferCaptureBuffer.memory.getMappedData());
+    capture.width = outputWidth;
+    capture.height = outputHeight;
+    capture.depth.resize(pixels);
+    std::memcpy(capture.depth.data(), mapped, sizeof(float) * pixels);
+
+    // RGBA16F normal + metallic; the metallic channel is dropped
+    const auto* normals = reinterpret_cast<const uint16_t*>(mapped + sizeof(float) * pixels);
+    capture.normal.resize(pixels);
+    for (size_t i = 0; i < pixels; i++) {
+        capture.normal[i] = glm::vec3(glm::unpackHalf1x16(normals[i * 4]), glm::unpackHalf1x16(normals[i * 4 + 1]),
+                                      glm::unpackHalf1x16(normals[i * 4 + 2]));
+    }
+    gbufferCapturePending = false;
+    return true;
+}
 
-    // Reset it to -1 for next pick
-    SelectionData clearVal{-1, 0, 0, 0};
-    void* clearPtr = context.getDevice().mapMemory(selectionBuffer.memory.get(), 0, sizeof(SelectionData));
-    std::memcpy(clearPtr, &clearVal, sizeof(SelectionData));
-    context.getDevice().unmapMemory(selectionBuffer.memory.get());
+uint32_t SDFRenderer::resolvePicks() {
+    uint32_t frame = context.getCurrentFrame();
+    PickEntry* slot = pickMapped + frame * MAX_PICKS_PER_FRAME;
+
+    // beginFrame waited on this slot's fence, so the picks traced into it are complete
+    uint32_t offset = 0;
+    for (auto& batch : inFlightPicks[frame]) {
+        std::vector<SelectionData> results(batch.pixels.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            const PickEntry& entry = slot[offset + i];
+            results[i] = { entry.hitIndex, entry.x, entry.y, entry.z };
+        }
+        offset += static_cast<uint32_t>(batch.pixels.size());
+        batch.callback(results);
+    }
+    inFlightPicks[frame].clear();
+
+    // Move whole batches into the slot while they fit; the rest waits for the next frame
+    uint32_t count = 0;
+    while (!pendingPicks.empty() && count + pendingPicks.front().pixels.size() <= MAX_PICKS_PER_FRAME) {
+        PickBatch& batch = pendingPicks.front();
+        for (const glm::vec2& pixel : batch.pixels) {
+            slot[count++] = { pixel.x, pixel.y, 0.0f, -1 };
+        }
+        inFlightPicks[frame].push_back(std::move(batch));
+        pendingPicks.pop_front();
+    }
 
-    return result;
+    pushConstants.pickBase = frame * MAX_PICKS_PER_FRAME;
+    pushConstants.pickCount = count;
+    return count;
 }
 
 } // namespace engine::renderer
@@ -2,25 +2,86 @@
 
 #include "core/VulkanContext.hpp"
 #include "ComputePipeline.hpp"
-#include "DescriptorManager.hpp"
+#include "RenderGraph.hpp"
+#include "PerFrameBuffer.hpp"
 #include "core/SDFEdit.hpp"
+#include "core/Light.hpp"
 #include "core/InputState.hpp"
+#include <array>
 #include <vector>
+#include <deque>
+#include <functional>
+#include <future>
 #include <cmath>
 #include "Terrain.hpp"
 
 namespace engine::renderer {
 
 struct PushConstants {
-    float camPosX, camPosY, camPosZ, pad0;
+    float camPosX, camPosY, camPosZ, shadowScale; // shadowScale: shadow/AO resolution divisor
     float camDirX, camDirY, camDirZ, pad1;
     float resX, resY, time, editCount;
-    uint32_t renderMode; // 0=Lit, 1=Normals, 2=Complexity
-    uint32_t showGround; // 1=On, 0=Off
-    float mouseX, mouseY; // -1 if not picking
+    uint32_t lightCount;
+    uint32_t probeOffset; // First probe refreshed this frame
+    uint32_t pickBase, pickCount; // This frame's slot in the pick readback ring
     float brushX, brushY, brushZ, brushRadius; // World space brush
-    uint32_t showGrid; // 1=On, 0=Off
-    float pad2, pad3;
+    float giIntensity; // Scale applied to probe irradiance
+    uint32_t frameIndex;
+    uint32_t historyValid; // 0 discards the shadow/AO history
+    uint32_t resourceTable; // Bindless heap index of this frame's resource table
+    float prevCamPosX, prevCamPosY, prevCamPosZ, pad4; // Previous frame camera, for reprojection
+    float prevCamDirX, prevCamDirY, prevCamDirZ, pad5;
+};
+static_assert(sizeof(PushConstants) <= 128, "PushConstants must fit the guaranteed push constant size");
+
+// constant_id values declared in shaders/common/SDFScene.glsl
+enum class SpecConstant : uint32_t {
+    MaxMarchSteps = 0,
+    ShadowSteps = 1,
+    AOTaps = 2,
+    MaxMarchDist = 3,
+    RenderMode = 4,
+    ShowGround = 5,
+    ShowGrid = 6,
+    StageEdits = 7,
+    PointShadows = 8,
+    ProbeGI = 9
+};
+
+// Upper bound of the PointShadows constant: the lighting shader sizes its arrays of
+// strongest lights to it (shaders/SDFLighting.glsl)
+static constexpr uint32_t MAX_POINT_SHADOWS = 4;
+
+// Entries of the per-frame resource table: bindless heap indices of everything the SDF
+// passes access. Values must match the RES_ constants in shaders/common/SDFScene.glsl.
+enum class ResourceSlot : uint32_t {
+    BrickAtlas = 0,
+    SparseMap = 1,
+    Output = 2,
+    Edits = 3,
+    Picks = 4,
+    TerrainHeight = 5,
+    TerrainSplat = 6,
+    TerrainMinMax = 7,
+    GBufferDepth = 8,
+    GBufferNormal = 9,
+    GBufferAlbedo = 10,
+    GBufferInfo = 11,
+    ShadowHistory = 12, // History 0; history 1 is entry 13
+    HitList = 14,
+    TileEdits = 15,
+    Lights = 16,
+    ClusterLights = 17,
+    Probes = 18,
+    PresentTarget = 19,
+    Count = 20
+};
+
+enum class QualityPreset : uint32_t {
+    Low = 0,
+    Medium = 1,
+    High = 2,
+    Ultra = 3
 };
 
 class SDFRenderer {
@@ -29,44 +90,171 @@ public:
     ~SDFRenderer();
 
     void update(float deltaTime, const core::InputState& input, bool imguiCapture);
-    void render(vk::CommandBuffer commandBuffer);
+    // Declares this frame's passes; they are recorded when the graph executes
+    void render(RenderGraph& graph);
     vk::Image getOutputImage() const { return outputImage.image.get(); }
 
+    // Lighting writes the acquired swapchain image instead of outputImage, so the
+    // frame skips VulkanContext::endFrameBlit
+    bool supportsDirectPresent() const { return lightingPresentPipeline != nullptr; }
+    bool usesDirectPresent() const { return directPresent; }
+    void setDirectPresent(bool enabled) { directPresent = enabled && supportsDirectPresent(); }
+
     struct SelectionData {
         int32_t hitIndex; // -1 none, 0 ground, 1+ edit
         float posX, posY, posZ;
     };
-    SelectionData getSelection();
-    void triggerPicking(float x, float y);
+    using PickCallback = std::function<void(const std::vector<SelectionData>&)>;
+
+    // Queues pick rays at window pixel coordinates. They are traced by a small
+    // dedicated dispatch, and the callback runs (from render) once that frame's
+    // fence has signalled, with one result per pixel in request order. Batches larger
+    // than MAX_PICKS_PER_FRAME are traced over several frames; the callback still runs
+    // once, after the last part.
+    void requestPicks(std::vector<glm::vec2> pixels, PickCallback callback);
+    void requestPick(float x, float y, std::function<void(const SelectionData&)> callback);
 
     // Public access for editor
     std::vector<core::SDFEdit>& getEdits() { return edits; }
     void markEditsDirty() { editsDirty = true; }
 
+    // Point lights, culled into screen/depth clusters every frame
+    std::vector<core::PointLight>& getLights() { return lights; }
+    void markLightsDirty() { lightsDirty = true; }
+    static constexpr uint32_t MAX_LIGHTS = 1024;
+
     uint32_t& getRenderMode() { return renderMode; }
     bool& getShowGround() { return showGround; }
     
     void setBrush(float x, float y, float z, float r) {
         brushX = x; brushY = y; brushZ = z; brushRadius = r;
     }
+    // Places the camera for scripted runs (yaw/pitch in radians, as used by update)
+    void setCamera(const glm::vec3& position, float yaw, float pitch) {
+        camPosX = position.x; camPosY = position.y; camPosZ = position.z;
+        camYaw = yaw; camPitch = pitch;
+    }
     bool& getShowGrid() { return showGrid; }
 
+    // Selects the specialized pipeline variants used for marching
+    QualityPreset& getQuality() { return quality; }
+    // Visibility pass reads its tile's edits from shared memory instead of the edit buffer
+    bool& getStageEdits() { return stageEdits; }
+    // Toggle changes take effect once their variants are built in the background. Scripted
+    // runs call this after changing toggles so the next frame already renders with them.
+    void waitForVariants();
+    // Visibility and shadow evaluate primitives and smooth blends in fp16. On by default
+    // where shaderFloat16 is supported; EngineBench --fp16-check measures the error.
+    bool supportsFp16Evaluation() const { return visibilityFp16Pipeline != nullptr; }
+    bool usesFp16Evaluation() const { return fp16Evaluation; }
+    void setFp16Evaluation(bool enabled) { fp16Evaluation = enabled && supportsFp16Evaluation(); }
+
+    // Hit distance and normal of every pixel, from a frame's G-Buffer
+    struct GBufferCapture {
+        uint32_t width = 0, height = 0;
+        std::vector<float> depth;      // Negative on miss
+        std::vector<glm::vec3> normal;
+    };
+    // The next render copies its G-Buffer depth and normal out for readGBufferCapture
+    void requestGBufferCapture() { gbufferCaptureRequested = true; }
+    // Call once the capturing frame has completed (e.g. after a device wait)
+    bool readGBufferCapture(GBufferCapture& capture);
+
+    // Irradiance probe GI: probes are refreshed round-robin, giRayBudget rays per frame
+    bool& getProbeGI() { return probeGI; }
+    uint32_t& getGIRayBudget() { return giRayBudget; }
+    float& getGIIntensity() { return giIntensity; }
+    static constexpr uint32_t PROBE_COUNT = 32 * 8 * 32; // Must match PROBE_GRID in SDFScene.glsl
+    static constexpr uint32_t RAYS_PER_PROBE = 64;
+
+    // Shadow/AO resolution divisor: 2 = half, 4 = quarter
+    uint32_t getShadowScale() const { return shadowScale; }
+    void setShadowScale(uint32_t scale);
+
     Terrain& getTerrain() { return *terrain; }
 
 private:
     core::VulkanContext& context;
-    std::unique_ptr<DescriptorManager> descriptorManager;
-    vk::DescriptorSetLayout descriptorSetLayout;
-    vk::DescriptorSet descriptorSet;
-    
-    std::unique_ptr<ComputePipeline> computePipeline;
     
+    // Deferred pipeline: visibility -> shadow/AO (hit pixels only) -> lighting
+    std::unique_ptr<ComputePipeline> tileCullPipeline;
+    std::unique_ptr<ComputePipeline> lightCullPipeline;
+    std::unique_ptr<ComputePipeline> probeUpdatePipeline;
+    std::unique_ptr<ComputePipeline> visibilityPipeline;
+    std::unique_ptr<ComputePipeline> shadowPipeline;
+    std::unique_ptr<ComputePipeline> visibilityFp16Pipeline; // Null without shaderFloat16
+    std::unique_ptr<ComputePipeline> shadowFp16Pipeline;
+    std::unique_ptr<ComputePipeline> lightingPipeline;
+    std::unique_ptr<ComputePipeline> lightingPresentPipeline; // Null without direct present support
+    std::unique_ptr<ComputePipeline> pickPipeline;
+
+    // Transient G-Buffer targets, owned by the render graph:
+    // depth R32F hit distance (negative on miss), normal RGBA16F normal + metallic,
+    // albedo RGBA8 albedo + roughness, info R32UI (steps << 16) | (hitIndex + 1)
+    static constexpr const char* GBUFFER_DEPTH = "G-Buffer Depth";
+    static constexpr const char* GBUFFER_NORMAL = "G-Buffer Normal";
+    static constexpr const char* GBUFFER_ALBEDO = "G-Buffer Albedo";
+    static constexpr const char* GBUFFER_INFO = "G-Buffer Info";
+    ResourceManager::Buffer gbufferCaptureBuffer; // Depth, then normal; created on first capture
+    bool gbufferCaptureRequested = false;
+    bool gbufferCapturePending = false;
+
+    // Reduced-resolution shadow/AO, ping-ponged between frames for temporal accumulation
+    ResourceManager::Image shadowHistory[2]; // RGBA16F: shadow, AO, hit distance, history length
+    uint32_t shadowScale = 2;
+    bool historyInitialized = false;
+    uint32_t lastRenderMode = 0;
     ResourceManager::Image outputImage;
-    ResourceManager::Buffer editBuffer;
-    ResourceManager::Buffer selectionBuffer;
+    bool directPresent = false;
+    // Host-written scene data, one copy per frame in flight
+    static constexpr uint32_t MAX_EDITS = 256; // Shaders read at most this many
+    PerFrameBuffer editBuffer;
+    ResourceManager::Buffer hitListBuffer; // Dispatch header + compacted hit pixels
+    ResourceManager::Buffer tileEditBuffer; // Per 8x8 tile: count + culled edit indices
+    static constexpr uint32_t TILE_STRIDE = 64; // uints per tile, must match SDFScene.glsl
     std::vector<core::SDFEdit> edits;
     bool editsDirty = true;
-    bool pickingRequested = false;
+
+    PerFrameBuffer lightBuffer;
+    ResourceManager::Buffer clusterLightBuffer; // Per cluster: count + light indices
+    // Cluster grid and list size, must match SDFScene.glsl
+    static constexpr uint32_t CLUSTER_X = 16, CLUSTER_Y = 9, CLUSTER_Z = 24;
+    static constexpr uint32_t CLUSTER_STRIDE = 64;
+    std::vector<core::PointLight> lights;
+    bool lightsDirty = true;
+
+    // Irradiance probes: L1 SH per colour channel plus validity (64 bytes each)
+    ResourceManager::Buffer probeBuffer;
+    bool probesInitialized = false;
+    bool probeGI = true;
+    uint32_t giRayBudget = 8192;
+    float giIntensity = 0.3f;
+    uint32_t probeCursor = 0;
+
+    // Pick readback ring: MAX_PICKS_PER_FRAME entries per frame in flight, persistently mapped
+    struct PickEntry {
+        float x, y, z;    // In: pixel in xy. Out: hit position
+        int32_t hitIndex; // Out: -1 none, 0 ground, 1+ edit
+    };
+    struct PickBatch {
+        std::vector<glm::vec2> pixels;
+        PickCallback callback;
+    };
+    static constexpr uint32_t MAX_PICKS_PER_FRAME = 1024;
+    ResourceManager::Buffer pickBuffer;
+    PickEntry* pickMapped = nullptr;
+    std::deque<PickBatch> pendingPicks;
+    std::vector<PickBatch> inFlightPicks[core::VulkanContext::MAX_FRAMES_IN_FLIGHT];
+
+    // Bindless heap indices, copied into this frame's resource table by render. Per-frame
+    // buffers have a heap slot per frame in flight; the swapchain images follow presentSlot.
+    PerFrameBuffer resourceTable;
+    BindlessHeap::Index tableSlots[core::VulkanContext::MAX_FRAMES_IN_FLIGHT] = {};
+    BindlessHeap::Index editSlots[core::VulkanContext::MAX_FRAMES_IN_FLIGHT] = {};
+    BindlessHeap::Index lightSlots[core::VulkanContext::MAX_FRAMES_IN_FLIGHT] = {};
+    BindlessHeap::Index presentSlot = BindlessHeap::INVALID;
+    std::array<BindlessHeap::Index, static_cast<size_t>(ResourceSlot::Count)> resourceSlots;
+    BindlessHeap::Index& slot(ResourceSlot entry) { return resourceSlots[static_cast<size_t>(entry)]; }
 
     PushConstants pushConstants{};
     float totalTime = 0.0f;
@@ -82,10 +270,42 @@ private:
     uint32_t renderMode = 0;
     bool showGround = true;
     bool showGrid = false;
+    QualityPreset quality = QualityPreset::High;
+    bool stageEdits = true;
+    bool fp16Evaluation = false;
     float brushX = 0, brushY = 0, brushZ = 0, brushRadius = 0;
 
-    void createDescriptorSets();
-    void updateEditBuffer();
+    // Everything the specialization constants are derived from
+    struct VariantState {
+        QualityPreset quality;
+        uint32_t renderMode;
+        bool showGround, showGrid, stageEdits, probeGI;
+        bool operator==(const VariantState&) const = default;
+    };
+    // State the active constant set was built from. A changed toggle compiles its variants
+    // on a worker; frames keep rendering the active set until they are ready.
+    VariantState activeVariant{};
+    SpecializationConstants specConstants;
+    std::future<std::vector<ComputePipeline::Program>> pendingVariants;
+    std::vector<ComputePipeline*> pendingPipelines; // Receivers of pendingVariants, in order
+
+    VariantState currentVariant() const {
+        return { quality, renderMode, showGround, showGrid, stageEdits, probeGI };
+    }
+    static SpecializationConstants buildSpecializationConstants(const VariantState& state);
+    std::vector<ComputePipeline*> getPipelines() const;
+    // Switches to the current toggles once their variants exist, starting their build if needed
+    void selectVariants();
+    void createScreenResources();
+    void createShadowHistory();
+    // Adds the fixed resources to the bindless heap
+    void registerResources();
+    // Points the G-Buffer slots at the graph's current transient views
+    void updateGBufferSlots();
+    // Refresh the current frame's copy; called from render, after beginFrame's fence wait
+    void updateEditBuffer(uint32_t frame);
+    void updateLightBuffer(uint32_t frame);
+    uint32_t resolvePicks();
 
     std::unique_ptr<Terrain> terrain;
     vk::Sampler terrainSampler;
@@ -0,0 +1,270 @@
+#include "ShaderHotReload.hpp"
+#include "core/CpuProfiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace engine::renderer {
+
+namespace {
+
+// Direct #include "file" dependencies of a GLSL source
+std::vector<std::filesystem::path> findIncludes(const std::filesystem::path& source) {
+    std::vector<std::filesystem::path> includes;
+    std::ifstream file(source);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t directive = line.find("#include");
+        if (directive == std::string::npos) continue;
+        size_t open = line.find('"', directive);
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos) continue;
+        includes.push_back(source.parent_path() / line.substr(open + 1, close - open - 1));
+    }
+    return includes;
+}
+
+} // namespace
+
+ShaderHotReload::ShaderHotReload(vk::Device device, vk::PipelineCache pipelineCache, uint32_t framesInFlight)
+    : device(device), pipelineCache(pipelineCache), framesInFlight(framesInFlight) {}
+
+ShaderHotReload::~ShaderHotReload() {
+    setEnabled(false);
+}
+
+void ShaderHotReload::watch(ComputePipeline* pipeline) {
+    std::lock_guard<std::mutex> lock(mutex);
+    watches.push_back({ nextWatchId++, pipeline, pipeline->getShaderPath(), pipeline->getLayout(), pipeline->getVariantKeys() });
+}
+
+void ShaderHotReload::unwatch(ComputePipeline* pipeline) {
+    std::lock_guard<std::mutex> build(buildMutex);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = std::find_if(watches.begin(), watches.end(), [pipeline](const Watch& w) { return w.pipeline == pipeline; });
+    if (it == watches.end()) return;
+    uint32_t id = it->id;
+    watches.erase(it);
+
+    // Never bound, so these can go right away
+    finished.erase(std::remove_if(finished.begin(), finished.end(), [id](const Rebuild& r) { return r.watchId == id; }),
+                   finished.end());
+}
+
+void ShaderHotReload::setEnabled(bool enabled) {
+    if (enabled == isEnabled()) return;
+
+    if (enabled) {
+        stopRequested = false;
+        worker = std::thread(&ShaderHotReload::run, this);
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopRequested = true;
+        }
+        wake.notify_all();
+        worker.join();
+        modifiedTimes.clear(); // Re-baseline on the next start
+    }
+}
+
+void ShaderHotReload::update() {
+    frameCounter++;
+
+    std::vector<Rebuild> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(finished);
+        // Later rebuilds should cover variants compiled since the last one
+        for (auto& w : watches) {
+            w.keys = w.pipeline->getVariantKeys();
+        }
+    }
+
+    // Only this thread adds or removes watches, so they can be read without the lock
+    for (auto& rebuild : ready) {
+        auto it = std::find_if(watches.begin(), watches.end(), [&](const Watch& w) { return w.id == rebuild.watchId; });
+        if (it == watches.end()) continue;
+        retired.push_back({ frameCounter, it->pipeline->replaceProgram(std::move(rebuild.program)) });
+        std::cout << "Shader hot reload: swapped in " << it->spvPath << std::endl;
+    }
+
+    while (!retired.empty() && retired.front().frame + framesInFlight <= frameCounter) {
+        retired.pop_front();
+    }
+}
+
+std::string ShaderHotReload::getStatus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return status;
+}
+
+void ShaderHotReload::setStatus(const std::string& message) {
+    std::cout << "Shader hot reload: " << message << std::endl;
+    std::lock_guard<std::mutex> lock(mutex);
+    status = message;
+}
+
+void ShaderHotReload::run() {
+    ENGINE_PROFILE_THREAD("Shader Reload");
+    while (!stopRequested) {
+        poll();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait_for(lock, std::chrono::milliseconds(250), [this] { return stopRequested.load(); });
+    }
+}
+
+void ShaderHotReload::poll() {
+    std::vector<Watch> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot = watches;
+    }
+
+    // Pipelines sharing a SPIR-V file share one compile
+    std::map<std::string, std::vector<const Watch*>> bySpv;
+    for (const auto& w : snapshot) {
+        bySpv[w.spvPath].push_back(&w);
+    }
+
+    for (const auto& [spvPath, users] : bySpv) {
+        const ShaderSource* source = findSource(spvPath);
+        if (!source || !sourceChanged(*source)) continue;
+
+        ENGINE_PROFILE_ZONE("Shader Recompile");
+        std::vector<uint32_t> spirv;
+        std::string log;
+        if (!compile(*source, spvPath, spirv, log)) {
+            setStatus(source->source.filename().string() + " failed to compile, keeping the previous pipeline\n" + log);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> build(buildMutex);
+        bool built = true;
+        for (const Watch* w : users) {
+            {
+                // Skip pipelines unwatched since the snapshot; their layouts may be gone
+                std::lock_guard<std::mutex> lock(mutex);
+                bool alive = std::any_of(watches.begin(), watches.end(), [w](const Watch& current) { return current.id == w->id; });
+                if (!alive) continue;
+            }
+            try {
+                auto program = ComputePipeline::buildProgram(device, pipelineCache, w->layout, spirv, w->keys);
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.push_back({ w->id, std::move(program) });
+            } catch (const std::exception& e) {
+                setStatus(spvPath + ": pipeline creation failed (" + e.what() + "), keeping the previous pipeline");
+                built = false;
+            }
+        }
+        if (built) {
+            setStatus(source->source.filename().string() + " reloaded");
+        }
+    }
+}
+
+const ShaderHotReload::ShaderSource* ShaderHotReload::findSource(const std::string& spvPath) {
+    std::filesystem::path spv(spvPath);
+    std::filesystem::path manifestPath = spv.parent_path() / "manifest.txt";
+
+    // One line per SPIR-V file: name|source|space separated defines
+    if (loadedManifests.insert(manifestPath).second) {
+        std::ifstream file(manifestPath);
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t first = line.find('|');
+            size_t second = first == std::string::npos ? first : line.find('|', first + 1);
+            if (second == std::string::npos) continue;
+
+            ShaderSource entry;
+            entry.source = line.substr(first + 1, second - first - 1);
+            std::istringstream defines(line.substr(second + 1));
+            for (std::string define; defines >> define;) {
+                entry.defines.push_back(define);
+            }
+            manifest[line.substr(0, first)] = std::move(entry);
+        }
+    }
+
+    auto it = manifest.find(spv.filename().string());
+    return it != manifest.end() ? &it->second : nullptr;
+}
+
+bool ShaderHotReload::sourceChanged(const ShaderSource& source) {
+    // The source and everything it includes, transitively
+    std::vector<std::filesystem::path> pending = { source.source };
+    std::set<std::filesystem::path> visited;
+    bool changed = false;
+    while (!pending.empty()) {
+        std::filesystem::path path = pending.back();
+        pending.pop_back();
+        if (!visited.insert(path).second) continue;
+
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(path, error);
+        if (error) continue;
+
+        // First sighting only records a baseline
+        auto [it, inserted] = modifiedTimes.emplace(path, time);
+        if (!inserted && it->second != time) {
+            it->second = time;
+            changed = true;
+        }
+
+        auto includes = findIncludes(path);
+        pending.insert(pending.end(), includes.begin(), includes.end());
+    }
+    return changed;
+}
+
+bool ShaderHotReload::compile(const ShaderSource& source, const std::string& spvPath,
+                              std::vector<uint32_t>& spirv, std::string& log) {
+    // Same invocation as the build (see CMakeLists.txt); ENGINE_GLSLC overrides the compiler
+    const char* glslc = std::getenv("ENGINE_GLSLC");
+    std::string output = spvPath + ".reload";
+    std::string command = std::string("\"") + (glslc ? glslc : "glslc") + "\" -fshader-stage=compute";
+    for (const auto& define : source.defines) {
+        command += " -D" + define;
+    }
+    command += " \"" + source.source.string() + "\" -o \"" + output + "\" 2>&1";
+
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        log = "could not run " + command;
+        return false;
+    }
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), pipe)) {
+        log += buffer;
+    }
+    if (pclose(pipe) != 0) return false;
+
+    std::ifstream file(output, std::ios::ate | std::ios::binary);
+    if (!file) {
+        log += "no output written to " + output;
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    spirv.resize(fileSize / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(spirv.data()), fileSize);
+    file.close();
+
+    // Replace the build's SPIR-V too, so the next launch starts from the edited shader
+    std::error_code error;
+    std::filesystem::rename(output, spvPath, error);
+    return true;
+}
+
+} // namespace engine::renderer
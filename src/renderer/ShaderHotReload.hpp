@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ComputePipeline.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine::renderer {
+
+// Rebuilds watched pipelines when their GLSL changes. A worker thread polls the sources
+// (and the files they #include), recompiles with glslc and builds the new programs;
+// update() swaps them in at the frame boundary. A failed compile keeps the old program.
+// Sources and defines of each .spv come from the manifest.txt CMake writes next to them.
+class ShaderHotReload {
+public:
+    ShaderHotReload(vk::Device device, vk::PipelineCache pipelineCache, uint32_t framesInFlight);
+    ~ShaderHotReload();
+
+    void watch(ComputePipeline* pipeline);
+    // Call before destroying a watched pipeline; waits for a build that is using it
+    void unwatch(ComputePipeline* pipeline);
+
+    // Starts or stops the watcher thread; sources are compared against their state when it starts
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return worker.joinable(); }
+
+    // Frame boundary, after the frame's fence wait: swaps in finished programs and destroys
+    // replaced ones once the frames that used them have completed
+    void update();
+
+    // Outcome of the latest reload, for the editor
+    std::string getStatus() const;
+
+private:
+    struct ShaderSource {
+        std::filesystem::path source;
+        std::vector<std::string> defines;
+    };
+
+    struct Watch {
+        uint32_t id;
+        ComputePipeline* pipeline; // Dereferenced on the main thread only
+        std::string spvPath;
+        vk::PipelineLayout layout;
+        std::vector<SpecializationConstants> keys; // Variants to rebuild, refreshed every update
+    };
+
+    struct Rebuild {
+        uint32_t watchId;
+        ComputePipeline::Program program;
+    };
+
+    struct Retired {
+        uint64_t frame;
+        ComputePipeline::Program program;
+    };
+
+    vk::Device device;
+    vk::PipelineCache pipelineCache;
+    uint32_t framesInFlight;
+
+    // Shared with the worker
+    mutable std::mutex mutex;
+    std::vector<Watch> watches;
+    std::vector<Rebuild> finished;
+    std::string status;
+    uint32_t nextWatchId = 0;
+    // Held by the worker while it builds with a watch's layout
+    std::mutex buildMutex;
+
+    // Main thread only
+    std::deque<Retired> retired;
+    uint64_t frameCounter = 0;
+
+    // Worker only
+    std::map<std::string, ShaderSource> manifest; // .spv file name to its source
+    std::set<std::filesystem::path> loadedManifests;
+    std::map<std::filesystem::path, std::filesystem::file_time_type> modifiedTimes;
+
+    std::thread worker;
+    std::atomic<bool> stopRequested{ false };
+    std::condition_variable wake;
+
+    void run();
+    void poll();
+    const ShaderSource* findSource(const std::string& spvPath);
+    bool sourceChanged(const ShaderSource& source);
+    bool compile(const ShaderSource& source, const std::string& spvPath, std::vector<uint32_t>& spirv, std::string& log);
+    void setStatus(const std::string& message);
+};
+
+} // namespace engine::renderer
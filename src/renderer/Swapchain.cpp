@@ -4,13 +4,14 @@
 
 namespace engine::renderer {
 
-Swapchain::Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, uint32_t width, uint32_t height)
+Swapchain::Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, uint32_t width, uint32_t height,
+                     vk::PresentModeKHR preferredPresentMode)
     : device(device) {
     
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, surface);
 
     vk::SurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    vk::PresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes, preferredPresentMode);
     vk::Extent2D extent = chooseSwapExtent(swapChainSupport.capabilities, width, height);
 
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -27,6 +28,14 @@ Swapchain::Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::S
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst;
 
+    // Storage usage lets the final compute pass write the swapchain image instead of blitting to it
+    auto formatProps = physicalDevice.getFormatProperties(surfaceFormat.format);
+    storageSupported = (swapChainSupport.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eStorage) &&
+                       (formatProps.optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage);
+    if (storageSupported) {
+        createInfo.imageUsage |= vk::ImageUsageFlagBits::eStorage;
+    }
+
     // For simplicity, we assume graphics and present queues are the same
     createInfo.imageSharingMode = vk::SharingMode::eExclusive;
 
@@ -39,6 +48,7 @@ Swapchain::Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::S
     swapChainImages = device.getSwapchainImagesKHR(swapChain.get());
     swapChainImageFormat = surfaceFormat.format;
     swapChainExtent = extent;
+    swapChainPresentMode = presentMode;
 
     swapChainImageViews.resize(swapChainImages.size());
     for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -79,9 +89,10 @@ vk::SurfaceFormatKHR Swapchain::chooseSwapSurfaceFormat(const std::vector<vk::Su
     return availableFormats[0];
 }
 
-vk::PresentModeKHR Swapchain::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes) {
+vk::PresentModeKHR Swapchain::chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes,
+                                                    vk::PresentModeKHR preferred) {
     for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
+        if (availablePresentMode == preferred) {
             return availablePresentMode;
         }
     }
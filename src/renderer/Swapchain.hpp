@@ -14,14 +14,19 @@ public:
         std::vector<vk::PresentModeKHR> presentModes;
     };
 
-    Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, uint32_t width, uint32_t height);
+    // presentMode is used when the surface supports it, otherwise FIFO (always available)
+    Swapchain(vk::Device device, vk::PhysicalDevice physicalDevice, vk::SurfaceKHR surface, uint32_t width, uint32_t height,
+              vk::PresentModeKHR presentMode = vk::PresentModeKHR::eMailbox);
     ~Swapchain();
 
     vk::SwapchainKHR getSwapchain() const { return swapChain.get(); }
     vk::Format getFormat() const { return swapChainImageFormat; }
     vk::Extent2D getExtent() const { return swapChainExtent; }
+    vk::PresentModeKHR getPresentMode() const { return swapChainPresentMode; }
     const std::vector<vk::ImageView>& getImageViews() const { return swapChainImageViews; }
     const std::vector<vk::Image>& getImages() const { return swapChainImages; }
+    // Images were created with STORAGE usage, so compute passes can write them directly
+    bool supportsStorage() const { return storageSupported; }
 
     static SwapChainSupportDetails querySwapChainSupport(vk::PhysicalDevice device, vk::SurfaceKHR surface);
 
@@ -31,10 +36,12 @@ private:
     std::vector<vk::Image> swapChainImages;
     vk::Format swapChainImageFormat;
     vk::Extent2D swapChainExtent;
+    vk::PresentModeKHR swapChainPresentMode = vk::PresentModeKHR::eFifo;
     std::vector<vk::ImageView> swapChainImageViews;
+    bool storageSupported = false;
 
     vk::SurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormatKHR>& availableFormats);
-    vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes);
+    vk::PresentModeKHR chooseSwapPresentMode(const std::vector<vk::PresentModeKHR>& availablePresentModes, vk::PresentModeKHR preferred);
     vk::Extent2D chooseSwapExtent(const vk::SurfaceCapabilitiesKHR& capabilities, uint32_t width, uint32_t height);
 };
 
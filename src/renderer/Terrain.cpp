@@ -1,15 +1,32 @@
 #include "Terrain.hpp"
-#include "DescriptorManager.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <string>
 
 namespace engine::renderer {
 
 Terrain::Terrain(core::VulkanContext& context, uint32_t size)
     : context(context), size(size) {
+    stampSlots.fill(BindlessHeap::INVALID);
     createResources();
     createPipeline();
+    context.getShaderReload().watch(computePipeline.get());
+    context.getShaderReload().watch(minMaxPipeline.get());
 }
 
-Terrain::~Terrain() {}
+Terrain::~Terrain() {
+    context.getShaderReload().unwatch(computePipeline.get());
+    context.getShaderReload().unwatch(minMaxPipeline.get());
+
+    auto& heap = context.getBindlessHeap();
+    heap.release(BindlessHeap::Kind::StorageImage, heightmapIndex);
+    heap.release(BindlessHeap::Kind::StorageImage, splatmapIndex);
+    heap.release(BindlessHeap::Kind::StorageImage, pyramidIndex);
+    for (BindlessHeap::Index slot : stampSlots) {
+        heap.release(BindlessHeap::Kind::StorageBuffer, slot);
+    }
+}
 
 void Terrain::createResources() {
     auto& rm = context.getResourceManager();
@@ -34,114 +51,229 @@ void Terrain::createResources() {
         vk::ImageViewType::e2D
     );
 
-    // Initialize heightmap to 0
-    context.immediateSubmit([&](vk::CommandBuffer cmd) {
-        vk::ClearColorValue clearColor(std::array<float, 4>{0.0f, 0.0f, 0.0f, 0.0f});
-        vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
-        
-        // Transition to General for clear/compute
-        vk::ImageMemoryBarrier barrier{};
-        barrier.oldLayout = vk::ImageLayout::eUndefined;
-        barrier.newLayout = vk::ImageLayout::eGeneral;
-        barrier.srcAccessMask = vk::AccessFlagBits::eNone;
-        barrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
-        barrier.subresourceRange = range;
-        
-        barrier.image = heightmap.image.get();
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
-        
-        barrier.image = splatmap.image.get();
-        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
-
-        cmd.clearColorImage(heightmap.image.get(), vk::ImageLayout::eGeneral, clearColor, range);
-        
-        // Initialize splatmap to red (1,0,0,0) -> Base layer
-        clearColor = std::array<float, 4>{1.0f, 0.0f, 0.0f, 0.0f};
-        cmd.clearColorImage(splatmap.image.get(), vk::ImageLayout::eGeneral, clearColor, range);
-    });
-}
+    // Min/max pyramid down to 1x1, one storage view per level for the update pass
+    pyramidLevels = std::min<uint32_t>(std::bit_width(size), MAX_PYRAMID_LEVELS);
+    minMaxPyramid = rm.createImage(
+        size, size, 1,
+        vk::Format::eR32Uint,
+        vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal,
+        vk::ImageViewType::e2D,
+        pyramidLevels
+    );
+    for (uint32_t level = 0; level < pyramidLevels; level++) {
+        pyramidLevelViews.push_back(rm.createImageView(
+            minMaxPyramid.image.get(), vk::Format::eR32Uint, vk::ImageViewType::e2D, level, 1));
+    }
 
-void Terrain::createPipeline() {
-    descriptorManager = std::make_unique<DescriptorManager>(context.getDevice());
+    // Flat ground painted with the base layer. Uploaded rather than cleared so it goes
+    // through the transfer queue; the first frame waits for it on the GPU only.
+    auto& transfers = context.getTransferManager();
+    vk::Extent3D extent{ size, size, 1 };
+    size_t texels = static_cast<size_t>(size) * size;
 
-    std::vector<vk::DescriptorSetLayoutBinding> bindings = {
-        { 0, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute }, // Heightmap
-        { 1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute }  // Splatmap
-    };
+    std::vector<float> heights(texels, 0.0f);
+    transfers.uploadImage(heightmap.image.get(), extent, 0, heights.data(), texels * sizeof(float), vk::ImageLayout::eGeneral);
 
-    descriptorSetLayout = descriptorManager->createLayout(bindings);
-    descriptorSet = descriptorManager->allocateSet(descriptorSetLayout);
+    std::vector<uint32_t> splat(texels, 0x000000FFu); // RGBA8 (1, 0, 0, 0)
+    transfers.uploadImage(splatmap.image.get(), extent, 0, splat.data(), texels * sizeof(uint32_t), vk::ImageLayout::eGeneral);
 
-    vk::DescriptorImageInfo heightInfo{};
-    heightInfo.imageView = heightmap.view.get();
-    heightInfo.imageLayout = vk::ImageLayout::eGeneral;
+    // A flat heightmap has min = max = 0 everywhere, which packs to 0
+    std::vector<uint32_t> zeros(texels, 0);
+    for (uint32_t level = 0; level < pyramidLevels; level++) {
+        uint32_t levelSize = std::max(size >> level, 1u);
+        transfers.uploadImage(minMaxPyramid.image.get(), vk::Extent3D{ levelSize, levelSize, 1 }, level, zeros.data(),
+                              static_cast<vk::DeviceSize>(levelSize) * levelSize * sizeof(uint32_t), vk::ImageLayout::eGeneral);
+    }
+}
 
-    vk::DescriptorImageInfo splatInfo{};
-    splatInfo.imageView = splatmap.view.get();
-    splatInfo.imageLayout = vk::ImageLayout::eGeneral;
+void Terrain::createPipeline() {
+    auto& heap = context.getBindlessHeap();
+    heightmapIndex = heap.addStorageImage(heightmap.view.get());
+    splatmapIndex = heap.addStorageImage(splatmap.view.get());
+    std::vector<vk::ImageView> levelViews;
+    for (const auto& view : pyramidLevelViews) {
+        levelViews.push_back(view.get());
+    }
+    pyramidIndex = heap.addStorageImages(levelViews);
 
-    std::vector<vk::WriteDescriptorSet> writes = {
-        { descriptorSet, 0, 0, 1, vk::DescriptorType::eStorageImage, &heightInfo, nullptr, nullptr },
-        { descriptorSet, 1, 0, 1, vk::DescriptorType::eStorageImage, &splatInfo, nullptr, nullptr }
-    };
-    descriptorManager->updateSet(descriptorSet, writes);
+    // Stamps are rewritten every frame a stroke is active, so each frame in flight has a copy
+    vk::DeviceSize storageAlignment = context.getPhysicalDevice().getProperties().limits.minStorageBufferOffsetAlignment;
+    stampBuffer = PerFrameBuffer(context.getResourceManager(), sizeof(BrushParams) * MAX_STAMPS, storageAlignment,
+                                 context.getFramesInFlight());
+    for (uint32_t frame = 0; frame < context.getFramesInFlight(); frame++) {
+        stampSlots[frame] = heap.addStorageBuffer(stampBuffer.getBuffer(), stampBuffer.getOffset(frame), stampBuffer.getSlotSize());
+    }
 
     vk::PushConstantRange pcRange{};
     pcRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
     pcRange.offset = 0;
-    pcRange.size = sizeof(BrushParams);
+    pcRange.size = sizeof(BrushConstants);
 
     computePipeline = std::make_unique<ComputePipeline>(
         context.getDevice(),
+        context.getPipelineCache(),
         "shaders/TerrainBrush.spv",
-        std::vector<vk::DescriptorSetLayout>{ descriptorSetLayout },
+        std::vector<vk::DescriptorSetLayout>{ heap.getLayout() },
         std::vector<vk::PushConstantRange>{ pcRange }
     );
+
+    // Min/max pyramid update: the level is chosen by push constant
+    vk::PushConstantRange minMaxRange{};
+    minMaxRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    minMaxRange.offset = 0;
+    minMaxRange.size = sizeof(MinMaxParams);
+
+    minMaxPipeline = std::make_unique<ComputePipeline>(
+        context.getDevice(),
+        context.getPipelineCache(),
+        "shaders/TerrainMinMax.spv",
+        std::vector<vk::DescriptorSetLayout>{ heap.getLayout() },
+        std::vector<vk::PushConstantRange>{ minMaxRange }
+    );
 }
 
 void Terrain::queueBrush(const BrushParams& params) {
-    pendingParams = params;
-    hasPending = true;
+    // Fill the gap to the previous stamp; a change of tool starts a new stroke
+    if (strokeActive && params.mode == lastStamp.mode && params.layer == lastStamp.layer) {
+        float spacing = std::max(std::min(params.radius, lastStamp.radius) * STAMP_SPACING, 1.0f / size);
+        glm::vec2 delta = params.pos - lastStamp.pos;
+        uint32_t steps = std::min(static_cast<uint32_t>(std::ceil(glm::length(delta) / spacing)), MAX_STAMPS);
+        for (uint32_t i = 1; i < steps; i++) {
+            float t = static_cast<float>(i) / static_cast<float>(steps);
+            BrushParams stamp = params;
+            stamp.pos = lastStamp.pos + delta * t;
+            stamp.radius = glm::mix(lastStamp.radius, params.radius, t);
+            stamp.strength = glm::mix(lastStamp.strength, params.strength, t);
+            pendingStamps.push_back(stamp);
+        }
+    }
+
+    // The stamp at the cursor itself is applied every call, so holding still keeps painting
+    pendingStamps.push_back(params);
+    lastStamp = params;
+    strokeActive = true;
 }
 
-void Terrain::executePending(vk::CommandBuffer cmd) {
-    if (!hasPending) return;
-
-    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline->getPipeline());
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipeline->getLayout(), 0, 1, &descriptorSet, 0, nullptr);
-    cmd.pushConstants(computePipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(BrushParams), &pendingParams);
-
-    uint32_t groupX = (size + 7) / 8;
-    uint32_t groupY = (size + 7) / 8;
-    cmd.dispatch(groupX, groupY, 1);
-
-    hasPending = false;
-
-    // Barrier to ensure SDF shader sees the changes
-    vk::ImageMemoryBarrier barrier{};
-    barrier.oldLayout = vk::ImageLayout::eGeneral;
-    barrier.newLayout = vk::ImageLayout::eGeneral;
-    barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
-    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead; // Sampled in SDF
-    barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.image = heightmap.image.get();
-    
-    cmd.pipelineBarrier(
-        vk::PipelineStageFlagBits::eComputeShader,
-        vk::PipelineStageFlagBits::eComputeShader,
-        {}, nullptr, nullptr, barrier
-    );
-    
-    barrier.image = splatmap.image.get();
-    cmd.pipelineBarrier(
-        vk::PipelineStageFlagBits::eComputeShader,
-        vk::PipelineStageFlagBits::eComputeShader,
-        {}, nullptr, nullptr, barrier
-    );
+Terrain::TexelRect Terrain::stampRect(const BrushParams& stamp) const {
+    int32_t maxTexel = static_cast<int32_t>(size) - 1;
+    return {
+        std::clamp(static_cast<int32_t>(std::floor((stamp.pos.x - stamp.radius) * size)), 0, maxTexel),
+        std::clamp(static_cast<int32_t>(std::floor((stamp.pos.y - stamp.radius) * size)), 0, maxTexel),
+        std::clamp(static_cast<int32_t>(std::ceil((stamp.pos.x + stamp.radius) * size)), 0, maxTexel),
+        std::clamp(static_cast<int32_t>(std::ceil((stamp.pos.y + stamp.radius) * size)), 0, maxTexel)
+    };
+}
+
+void Terrain::executePending(RenderGraph& graph) {
+    if (pendingStamps.empty()) return;
+
+    uint32_t stampCount = static_cast<uint32_t>(std::min<size_t>(pendingStamps.size(), MAX_STAMPS));
+    uint32_t frame = context.getCurrentFrame();
+    stampBuffer.invalidate();
+    stampBuffer.update(frame, pendingStamps.data(), sizeof(BrushParams) * stampCount);
+    std::vector<BrushParams> stamps(pendingStamps.begin(), pendingStamps.begin() + stampCount);
+    pendingStamps.erase(pendingStamps.begin(), pendingStamps.begin() + stampCount);
+
+    // Imported with their startup layout; from then on the graph tracks them, including
+    // the previous frame's march still sampling the heightmap and pyramid
+    auto height = graph.importImage("Terrain Height", heightmap.image.get(), 1, vk::ImageLayout::eGeneral);
+    auto splat = graph.importImage("Terrain Splat", splatmap.image.get(), 1, vk::ImageLayout::eGeneral);
+
+    auto unite = [](const TexelRect& a, const TexelRect& b) {
+        return TexelRect{ std::min(a.minX, b.minX), std::min(a.minY, b.minY), std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY) };
+    };
+
+    // Runs of point-wise stamps (raise, lower, paint) are one dispatch over the union of
+    // their footprints, each texel applying the stamps in order. Smoothing reads neighbours
+    // another stamp may have just written, so a smooth run dispatches stamp by stamp.
+    TexelRect dirty = stampRect(stamps[0]);
+    bool heightsChanged = false;
+    for (uint32_t first = 0; first < stampCount;) {
+        bool smooth = stamps[first].mode == 3;
+        uint32_t end = first + 1;
+        while (end < stampCount && (stamps[end].mode == 3) == smooth) end++;
+
+        std::vector<BrushConstants> dispatches;
+        for (uint32_t i = first; i < end; i++) {
+            TexelRect rect = stampRect(stamps[i]);
+            dirty = unite(dirty, rect);
+            heightsChanged = heightsChanged || stamps[i].mode != 4; // Paint leaves heights untouched
+            if (smooth || dispatches.empty()) {
+                dispatches.push_back({ rect, i, 1, stampSlots[frame], heightmapIndex, splatmapIndex });
+            } else {
+                dispatches.back().rect = unite(dispatches.back().rect, rect);
+                dispatches.back().stampCount++;
+            }
+        }
+
+        auto& pass = graph.addPass(smooth ? "Terrain Smooth" : "Terrain Brush");
+        pass.write(height, ResourceUsage::ComputeReadWrite);
+        if (!smooth) {
+            pass.write(splat, ResourceUsage::ComputeReadWrite);
+        }
+        pass.execute([this, dispatches](vk::CommandBuffer cmd) {
+            cmd.bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline->getPipeline());
+            context.getBindlessHeap().bind(cmd, computePipeline->getLayout());
+
+            for (size_t d = 0; d < dispatches.size(); d++) {
+                if (d > 0) {
+                    // Within the pass, so the graph cannot order consecutive smooth stamps
+                    vk::MemoryBarrier barrier{ vk::AccessFlagBits::eShaderWrite,
+                                               vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+                    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+                                        {}, barrier, nullptr, nullptr);
+                }
+                const BrushConstants& constants = dispatches[d];
+                cmd.pushConstants(computePipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(BrushConstants), &constants);
+
+                uint32_t groupX = static_cast<uint32_t>(constants.rect.maxX - constants.rect.minX + 1 + 7) / 8;
+                uint32_t groupY = static_cast<uint32_t>(constants.rect.maxY - constants.rect.minY + 1 + 7) / 8;
+                cmd.dispatch(groupX, groupY, 1);
+            }
+        });
+        first = end;
+    }
+
+    if (heightsChanged) {
+        updateMinMax(graph, height, dirty);
+    }
+}
+
+void Terrain::updateMinMax(RenderGraph& graph, RenderGraph::ImageHandle height, const TexelRect& rect) {
+    // Texels the brush touched, grown by one for the 3x3 footprint of level 0
+    int32_t maxTexel = static_cast<int32_t>(size) - 1;
+    int32_t minX = std::max(rect.minX - 1, 0);
+    int32_t minY = std::max(rect.minY - 1, 0);
+    int32_t maxX = std::min(rect.maxX + 1, maxTexel);
+    int32_t maxY = std::min(rect.maxY + 1, maxTexel);
+
+    auto pyramid = graph.importImage("Terrain MinMax", minMaxPyramid.image.get(), pyramidLevels, vk::ImageLayout::eGeneral);
+
+    // Each level only rebuilds the parents of the texels changed below it. Level N reads
+    // level N-1, so the graph puts a barrier on exactly that mip between dispatches.
+    for (uint32_t level = 0; level < pyramidLevels; level++) {
+        MinMaxParams mm{ minX >> level, minY >> level, maxX >> level, maxY >> level, static_cast<int32_t>(level),
+                         heightmapIndex, pyramidIndex };
+
+        auto& pass = graph.addPass("Terrain MinMax " + std::to_string(level));
+        if (level == 0) {
+            pass.read(height, ResourceUsage::ComputeRead);
+        } else {
+            pass.read(pyramid, ResourceUsage::ComputeRead, level - 1, 1);
+        }
+        pass.write(pyramid, ResourceUsage::ComputeWrite, level, 1)
+            .execute([this, mm](vk::CommandBuffer cmd) {
+                cmd.bindPipeline(vk::PipelineBindPoint::eCompute, minMaxPipeline->getPipeline());
+                context.getBindlessHeap().bind(cmd, minMaxPipeline->getLayout());
+                cmd.pushConstants(minMaxPipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(MinMaxParams), &mm);
+
+                uint32_t groupX = static_cast<uint32_t>(mm.rectMaxX - mm.rectMinX + 1 + 7) / 8;
+                uint32_t groupY = static_cast<uint32_t>(mm.rectMaxY - mm.rectMinY + 1 + 7) / 8;
+                cmd.dispatch(groupX, groupY, 1);
+            });
+    }
 }
 
 } // namespace engine::renderer
@@ -2,12 +2,15 @@
 
 #include "core/VulkanContext.hpp"
 #include "ComputePipeline.hpp"
+#include "RenderGraph.hpp"
+#include "BindlessHeap.hpp"
+#include "PerFrameBuffer.hpp"
+#include <array>
 #include <memory>
+#include <vector>
 
 namespace engine::renderer {
 
-class DescriptorManager;
-
 class Terrain {
 public:
     struct BrushParams {
@@ -23,11 +26,26 @@ public:
     Terrain(core::VulkanContext& context, uint32_t size = 1024);
     ~Terrain();
 
+    // Continues the current stroke to params. Stamps are interpolated from the previous
+    // one at a fraction of the radius, so fast cursor movement leaves no gaps.
     void queueBrush(const BrushParams& params);
-    void executePending(vk::CommandBuffer cmd);
+    // The next queueBrush starts a new stroke instead of connecting to the last stamp
+    void endStroke() { strokeActive = false; }
+    // Declares the brush and min/max pyramid passes for up to MAX_STAMPS queued stamps;
+    // the rest stay queued for the next frame
+    void executePending(RenderGraph& graph);
 
     ResourceManager::Image& getHeightmap() { return heightmap; }
     ResourceManager::Image& getSplatmap() { return splatmap; }
+    // R32UI mip chain of packHalf2x16(min, max) heights, used for hierarchical ray traversal
+    ResourceManager::Image& getMinMaxPyramid() { return minMaxPyramid; }
+    uint32_t getPyramidLevels() const { return pyramidLevels; }
+
+    static constexpr uint32_t MAX_PYRAMID_LEVELS = 16;
+    // Stamps applied per frame, and the most one queueBrush call interpolates
+    static constexpr uint32_t MAX_STAMPS = 256;
+    // Stamp spacing along a stroke, relative to the radius
+    static constexpr float STAMP_SPACING = 0.25f;
     
     // Material settings (could be a UBO, but for now simple getters/setters or just fixed)
     // We'll hardcode materials in shader for now or pass as push constants if needed,
@@ -39,17 +57,54 @@ private:
 
     ResourceManager::Image heightmap;
     ResourceManager::Image splatmap; // RGBA8 (Base, Layer1, Layer2, Layer3 weights)
+    ResourceManager::Image minMaxPyramid;
+    std::vector<vk::UniqueImageView> pyramidLevelViews;
+    uint32_t pyramidLevels = 1;
+
+    // Storage views in the bindless heap; the pyramid levels take consecutive slots
+    BindlessHeap::Index heightmapIndex = BindlessHeap::INVALID;
+    BindlessHeap::Index splatmapIndex = BindlessHeap::INVALID;
+    BindlessHeap::Index pyramidIndex = BindlessHeap::INVALID;
 
-    std::unique_ptr<DescriptorManager> descriptorManager;
-    vk::DescriptorSetLayout descriptorSetLayout;
-    vk::DescriptorSet descriptorSet;
     std::unique_ptr<ComputePipeline> computePipeline;
+    std::unique_ptr<ComputePipeline> minMaxPipeline;
+
+    // Queued stamps, uploaded per frame and read by the brush pass from the heap
+    std::vector<BrushParams> pendingStamps;
+    PerFrameBuffer stampBuffer;
+    std::array<BindlessHeap::Index, core::VulkanContext::MAX_FRAMES_IN_FLIGHT> stampSlots;
+    BrushParams lastStamp{};
+    bool strokeActive = false;
 
-    bool hasPending = false;
-    BrushParams pendingParams{};
+    // Inclusive texel rectangle
+    struct TexelRect {
+        int32_t minX, minY;
+        int32_t maxX, maxY;
+    };
+
+    // Push constants, must match TerrainBrush.glsl and TerrainMinMax.glsl
+    struct BrushConstants {
+        TexelRect rect; // Texels the dispatch covers
+        uint32_t firstStamp;
+        uint32_t stampCount;
+        uint32_t stampsIndex;
+        uint32_t heightmapIndex;
+        uint32_t splatmapIndex;
+    };
+    struct MinMaxParams {
+        int32_t rectMinX, rectMinY; // Inclusive texel rectangle of the level
+        int32_t rectMaxX, rectMaxY;
+        int32_t level;
+        uint32_t heightmapIndex;
+        uint32_t pyramidIndex;
+    };
 
     void createResources();
     void createPipeline();
+    // Texels a stamp can change, clamped to the map
+    TexelRect stampRect(const BrushParams& stamp) const;
+    // Rebuilds the pyramid above rect, the union of the changed texels
+    void updateMinMax(RenderGraph& graph, RenderGraph::ImageHandle height, const TexelRect& rect);
 };
 
 } // namespace engine::renderer
@@ -0,0 +1,194 @@
+#include "TlsfAllocator.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace engine::renderer {
+
+namespace {
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+TlsfAllocator::TlsfAllocator(uint64_t size) : size(size) {
+    for (auto& level : heads) {
+        std::fill(std::begin(level), std::end(level), INVALID);
+    }
+
+    uint32_t whole = newNode();
+    nodes[whole].size = size;
+    insertFree(whole);
+}
+
+void TlsfAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl) {
+    if (size < SL_COUNT) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size);
+        return;
+    }
+    uint32_t log2 = 63 - static_cast<uint32_t>(std::countl_zero(size));
+    fl = log2 - SL_LOG2 + 1;
+    sl = static_cast<uint32_t>(size >> (log2 - SL_LOG2)) - SL_COUNT;
+}
+
+TlsfAllocator::Range TlsfAllocator::allocate(uint64_t requestSize, uint64_t alignment, uint64_t granularity) {
+    Range range;
+    if (requestSize == 0) return range;
+
+    alignment = std::max<uint64_t>({ alignment, granularity, 1 });
+    uint64_t allocSize = alignUp(requestSize, std::max<uint64_t>(granularity, 1));
+
+    // Any free range of at least this size fits once its start is aligned. Rounding up to the
+    // next size class means every range in the first non-empty class at or above it does.
+    uint64_t searchSize = allocSize + alignment - 1;
+    if (searchSize >= SL_COUNT) {
+        uint32_t log2 = 63 - static_cast<uint32_t>(std::countl_zero(searchSize));
+        searchSize += (uint64_t(1) << (log2 - SL_LOG2)) - 1;
+    }
+
+    uint32_t fl, sl;
+    mapping(searchSize, fl, sl);
+
+    uint32_t slMap = secondLevelMap[fl] & (~0u << sl);
+    if (slMap == 0) {
+        uint64_t flMap = fl + 1 < FL_COUNT ? firstLevelMap & (~uint64_t(0) << (fl + 1)) : 0;
+        if (flMap == 0) return range;
+        fl = static_cast<uint32_t>(std::countr_zero(flMap));
+        slMap = secondLevelMap[fl];
+    }
+    sl = static_cast<uint32_t>(std::countr_zero(slMap));
+
+    uint32_t index = heads[fl][sl];
+    uint64_t offset = alignUp(nodes[index].offset, alignment);
+    index = carve(index, offset, allocSize);
+
+    used += allocSize;
+    allocationCount++;
+    range.handle = index;
+    range.offset = offset;
+    return range;
+}
+
+uint32_t TlsfAllocator::carve(uint32_t index, uint64_t offset, uint64_t allocSize) {
+    removeFree(index);
+
+    // Alignment padding in front stays free
+    if (offset > nodes[index].offset) {
+        uint32_t lead = newNode();
+        nodes[lead].offset = nodes[index].offset;
+        nodes[lead].size = offset - nodes[index].offset;
+        nodes[lead].prevPhysical = nodes[index].prevPhysical;
+        nodes[lead].nextPhysical = index;
+        if (nodes[lead].prevPhysical != INVALID) nodes[nodes[lead].prevPhysical].nextPhysical = lead;
+        nodes[index].prevPhysical = lead;
+        nodes[index].offset = offset;
+        nodes[index].size -= nodes[lead].size;
+        insertFree(lead);
+    }
+
+    if (nodes[index].size > allocSize) {
+        uint32_t tail = newNode();
+        nodes[tail].offset = offset + allocSize;
+        nodes[tail].size = nodes[index].size - allocSize;
+        nodes[tail].prevPhysical = index;
+        nodes[tail].nextPhysical = nodes[index].nextPhysical;
+        if (nodes[tail].nextPhysical != INVALID) nodes[nodes[tail].nextPhysical].prevPhysical = tail;
+        nodes[index].nextPhysical = tail;
+        nodes[index].size = allocSize;
+        insertFree(tail);
+    }
+
+    nodes[index].free = false;
+    return index;
+}
+
+void TlsfAllocator::free(uint32_t handle) {
+    used -= nodes[handle].size;
+    allocationCount--;
+
+    uint32_t index = handle;
+    uint32_t next = nodes[index].nextPhysical;
+    if (next != INVALID && nodes[next].free) {
+        removeFree(next);
+        nodes[index].size += nodes[next].size;
+        nodes[index].nextPhysical = nodes[next].nextPhysical;
+        if (nodes[index].nextPhysical != INVALID) nodes[nodes[index].nextPhysical].prevPhysical = index;
+        releaseNode(next);
+    }
+
+    uint32_t prev = nodes[index].prevPhysical;
+    if (prev != INVALID && nodes[prev].free) {
+        removeFree(prev);
+        nodes[prev].size += nodes[index].size;
+        nodes[prev].nextPhysical = nodes[index].nextPhysical;
+        if (nodes[prev].nextPhysical != INVALID) nodes[nodes[prev].nextPhysical].prevPhysical = prev;
+        releaseNode(index);
+        index = prev;
+    }
+
+    insertFree(index);
+}
+
+uint64_t TlsfAllocator::getLargestFree() const {
+    if (firstLevelMap == 0) return 0;
+    uint32_t fl = 63 - static_cast<uint32_t>(std::countl_zero(firstLevelMap));
+    uint32_t sl = 31 - static_cast<uint32_t>(std::countl_zero(secondLevelMap[fl]));
+
+    uint64_t largest = 0;
+    for (uint32_t index = heads[fl][sl]; index != INVALID; index = nodes[index].nextFree) {
+        largest = std::max(largest, nodes[index].size);
+    }
+    return largest;
+}
+
+uint32_t TlsfAllocator::newNode() {
+    if (!unusedNodes.empty()) {
+        uint32_t index = unusedNodes.back();
+        unusedNodes.pop_back();
+        nodes[index] = Node{};
+        return index;
+    }
+    nodes.emplace_back();
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void TlsfAllocator::releaseNode(uint32_t index) {
+    unusedNodes.push_back(index);
+}
+
+void TlsfAllocator::insertFree(uint32_t index) {
+    uint32_t fl, sl;
+    mapping(nodes[index].size, fl, sl);
+
+    nodes[index].free = true;
+    nodes[index].prevFree = INVALID;
+    nodes[index].nextFree = heads[fl][sl];
+    if (heads[fl][sl] != INVALID) nodes[heads[fl][sl]].prevFree = index;
+    heads[fl][sl] = index;
+
+    firstLevelMap |= uint64_t(1) << fl;
+    secondLevelMap[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::removeFree(uint32_t index) {
+    uint32_t fl, sl;
+    mapping(nodes[index].size, fl, sl);
+
+    Node& node = nodes[index];
+    if (node.prevFree != INVALID) nodes[node.prevFree].nextFree = node.nextFree;
+    if (node.nextFree != INVALID) nodes[node.nextFree].prevFree = node.prevFree;
+    if (heads[fl][sl] == index) {
+        heads[fl][sl] = node.nextFree;
+        if (heads[fl][sl] == INVALID) {
+            secondLevelMap[fl] &= ~(1u << sl);
+            if (secondLevelMap[fl] == 0) firstLevelMap &= ~(uint64_t(1) << fl);
+        }
+    }
+    node.free = false;
+    node.prevFree = INVALID;
+    node.nextFree = INVALID;
+}
+
+} // namespace engine::renderer
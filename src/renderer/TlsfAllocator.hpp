@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace engine::renderer {
+
+// Two-level segregated fit over an offset range: O(1) allocate and free with immediate
+// coalescing. Only bookkeeping lives here; ResourceManager maps the offsets onto a
+// VkDeviceMemory block. Free ranges are bucketed by size class (power of two, split into
+// SL_COUNT linear steps), and two bitmaps find the first non-empty bucket that fits.
+class TlsfAllocator {
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    explicit TlsfAllocator(uint64_t size);
+
+    struct Range {
+        uint32_t handle = INVALID; // Pass to free; INVALID when the allocation failed
+        uint64_t offset = 0;
+    };
+
+    // granularity > 1 rounds the range out to whole pages of that size at both ends, so
+    // nothing else shares a page with it (bufferImageGranularity for optimal images)
+    Range allocate(uint64_t size, uint64_t alignment, uint64_t granularity = 1);
+    void free(uint32_t handle);
+
+    uint64_t getSize() const { return size; }
+    uint64_t getUsed() const { return used; }
+    uint32_t getAllocationCount() const { return allocationCount; }
+    uint64_t getLargestFree() const;
+    bool isEmpty() const { return allocationCount == 0; }
+
+private:
+    static constexpr uint32_t SL_LOG2 = 4;
+    static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64 - SL_LOG2 + 1;
+
+    // Physical neighbours make a list in offset order; free nodes are also in a bucket list
+    struct Node {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t prevPhysical = INVALID;
+        uint32_t nextPhysical = INVALID;
+        uint32_t prevFree = INVALID;
+        uint32_t nextFree = INVALID;
+        bool free = false;
+    };
+
+    uint64_t size;
+    uint64_t used = 0;
+    uint32_t allocationCount = 0;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> unusedNodes;
+
+    uint64_t firstLevelMap = 0;
+    uint32_t secondLevelMap[FL_COUNT] = {};
+    uint32_t heads[FL_COUNT][SL_COUNT];
+
+    static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+    uint32_t newNode();
+    void releaseNode(uint32_t index);
+    void insertFree(uint32_t index);
+    void removeFree(uint32_t index);
+    // Node holding exactly [offset, offset + size) of the free node, splitting off the rest
+    uint32_t carve(uint32_t index, uint64_t offset, uint64_t size);
+};
+
+} // namespace engine::renderer
@@ -0,0 +1,337 @@
+#include "TransferManager.hpp"
+#include "core/CpuProfiler.hpp"
+#include <cstring>
+
+namespace engine::renderer {
+
+namespace {
+
+// Every copy region starts at a multiple of the largest texel size
+constexpr vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+constexpr vk::PipelineStageFlags CONSUMER_STAGES = TransferManager::WAIT_STAGES;
+constexpr vk::AccessFlags CONSUMER_ACCESS = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferRead;
+
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+TransferManager::TransferManager(vk::Device device, ResourceManager& resourceManager, vk::Queue queue, uint32_t queueFamily,
+                                 uint32_t graphicsFamily, uint32_t framesInFlight, vk::DeviceSize stagingSize)
+    : device(device), resourceManager(resourceManager), queue(queue), queueFamily(queueFamily),
+      graphicsFamily(graphicsFamily), framesInFlight(framesInFlight), stagingSize(stagingSize) {
+    vk::SemaphoreTypeCreateInfo typeInfo{ vk::SemaphoreType::eTimeline, 0 };
+    vk::SemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.pNext = &typeInfo;
+    timeline = device.createSemaphoreUnique(semaphoreInfo);
+
+    vk::CommandPoolCreateInfo poolInfo{};
+    poolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient;
+    poolInfo.queueFamilyIndex = queueFamily;
+    commandPool = device.createCommandPoolUnique(poolInfo);
+
+    staging = resourceManager.createBuffer(
+        stagingSize,
+        vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+    );
+    stagingMapped = static_cast<uint8_t*>(staging.memory.getMappedData());
+}
+
+TransferManager::~TransferManager() {
+    if (pending.commands) {
+        submit();
+    }
+    if (lastSubmitted > 0) {
+        vk::SemaphoreWaitInfo waitInfo{ {}, 1, &timeline.get(), &lastSubmitted };
+        auto result = device.waitSemaphores(waitInfo, UINT64_MAX);
+        (void)result;
+    }
+    // Staging and deferred resources go with the members; the command buffers with their pool
+}
+
+TransferManager::Ticket TransferManager::uploadBuffer(vk::Buffer dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size) {
+    vk::Buffer source;
+    vk::DeviceSize sourceOffset = 0;
+    std::memcpy(stage(size, source, sourceOffset), data, size);
+
+    auto cmd = pendingCommands();
+    vk::BufferCopy region{ sourceOffset, dstOffset, size };
+    cmd.copyBuffer(source, dst, 1, &region);
+
+    vk::BufferMemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.buffer = dst;
+    barrier.offset = dstOffset;
+    barrier.size = size;
+
+    if (ownershipTransfer()) {
+        // Released here, acquired by the next frame
+        barrier.srcQueueFamilyIndex = queueFamily;
+        barrier.dstQueueFamilyIndex = graphicsFamily;
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, barrier, nullptr);
+
+        barrier.srcAccessMask = {};
+        barrier.dstAccessMask = CONSUMER_ACCESS;
+        pending.bufferAcquires.push_back(barrier);
+    } else {
+        barrier.dstAccessMask = CONSUMER_ACCESS;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, CONSUMER_STAGES, {}, nullptr, barrier, nullptr);
+    }
+    return nextValue;
+}
+
+TransferManager::Ticket TransferManager::uploadImage(vk::Image dst, vk::Extent3D extent, uint32_t mipLevel, const void* data,
+                                                     vk::DeviceSize size, vk::ImageLayout finalLayout) {
+    vk::Buffer source;
+    vk::DeviceSize sourceOffset = 0;
+    std::memcpy(stage(size, source, sourceOffset), data, size);
+
+    auto cmd = pendingCommands();
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, mipLevel, 1, 0, 1);
+
+    vk::ImageMemoryBarrier barrier{};
+    barrier.oldLayout = vk::ImageLayout::eUndefined;
+    barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.srcAccessMask = {};
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dst;
+    barrier.subresourceRange = range;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, barrier);
+
+    vk::BufferImageCopy region{};
+    region.bufferOffset = sourceOffset;
+    region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mipLevel, 0, 1);
+    region.imageExtent = extent;
+    cmd.copyBufferToImage(source, dst, vk::ImageLayout::eTransferDstOptimal, 1, &region);
+
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = finalLayout;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+
+    if (ownershipTransfer()) {
+        // Layout changes once, in the release/acquire pair
+        barrier.srcQueueFamilyIndex = queueFamily;
+        barrier.dstQueueFamilyIndex = graphicsFamily;
+        barrier.dstAccessMask = {};
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, barrier);
+
+        barrier.srcAccessMask = {};
+        barrier.dstAccessMask = CONSUMER_ACCESS;
+        pending.imageAcquires.push_back(barrier);
+    } else {
+        barrier.dstAccessMask = CONSUMER_ACCESS;
+        cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, CONSUMER_STAGES, {}, nullptr, nullptr, barrier);
+    }
+    return nextValue;
+}
+
+bool TransferManager::isComplete(Ticket ticket) const {
+    return device.getSemaphoreCounterValue(timeline.get()) >= ticket;
+}
+
+void TransferManager::onComplete(Ticket ticket, std::function<void()> callback) {
+    if (ticket == nextValue) {
+        pending.callbacks.push_back(std::move(callback));
+        return;
+    }
+    for (auto& batch : inFlight) {
+        if (batch.value == ticket) {
+            batch.callbacks.push_back(std::move(callback));
+            return;
+        }
+    }
+    // Already retired
+    callback();
+}
+
+std::shared_future<void> TransferManager::getFuture(Ticket ticket) {
+    auto futureOf = [](Batch& batch) {
+        if (!batch.promise) {
+            batch.promise = std::make_unique<std::promise<void>>();
+            batch.future = batch.promise->get_future().share();
+        }
+        return batch.future;
+    };
+
+    if (ticket == nextValue) return futureOf(pending);
+    for (auto& batch : inFlight) {
+        if (batch.value == ticket) return futureOf(batch);
+    }
+
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future().share();
+}
+
+void TransferManager::wait(Ticket ticket) {
+    ENGINE_PROFILE_ZONE("Transfer Wait");
+    if (ticket == nextValue && pending.commands) {
+        submit();
+    }
+    vk::SemaphoreWaitInfo waitInfo{ {}, 1, &timeline.get(), &ticket };
+    auto result = device.waitSemaphores(waitInfo, UINT64_MAX);
+    (void)result;
+    retire(device.getSemaphoreCounterValue(timeline.get()));
+}
+
+uint64_t TransferManager::beginFrame(vk::CommandBuffer cmd) {
+    frameCounter++;
+    if (pending.commands) {
+        submit();
+    }
+    retire(device.getSemaphoreCounterValue(timeline.get()));
+
+    // Source stages match the timeline wait: a TopOfPipe source would not chain to it, and
+    // the acquire's layout transition could run before the transfer queue's release
+    if (!frameBufferAcquires.empty() || !frameImageAcquires.empty()) {
+        cmd.pipelineBarrier(WAIT_STAGES, CONSUMER_STAGES, {},
+                            nullptr, frameBufferAcquires, frameImageAcquires);
+        frameBufferAcquires.clear();
+        frameImageAcquires.clear();
+    }
+
+    uint64_t waitValue = frameWaitValue;
+    frameWaitValue = 0;
+    return waitValue;
+}
+
+vk::CommandBuffer TransferManager::pendingCommands() {
+    if (!pending.commands) {
+        if (freeCommandBuffers.empty()) {
+            vk::CommandBufferAllocateInfo allocInfo{ commandPool.get(), vk::CommandBufferLevel::ePrimary, 1 };
+            pending.commands = device.allocateCommandBuffers(allocInfo)[0];
+        } else {
+            pending.commands = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+            pending.commands.reset();
+        }
+        pending.commands.begin(vk::CommandBufferBeginInfo{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    }
+    return pending.commands;
+}
+
+uint8_t* TransferManager::stage(vk::DeviceSize size, vk::Buffer& buffer, vk::DeviceSize& offset) {
+    // Too big for the ring: a one-off staging buffer that lives as long as the batch
+    if (size > stagingSize) {
+        auto oversized = resourceManager.createBuffer(
+            size,
+            vk::BufferUsageFlagBits::eTransferSrc,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+        );
+        buffer = oversized.buffer.get();
+        offset = 0;
+        auto* mapped = static_cast<uint8_t*>(oversized.memory.getMappedData());
+        pending.oversizedStaging.push_back(std::move(oversized));
+        return mapped;
+    }
+
+    while (!allocateRing(size, offset)) {
+        // Ring full: push out what is recorded and wait for the oldest batch to free space
+        ENGINE_PROFILE_ZONE("Staging Ring Full");
+        if (pending.usesRing) {
+            submit();
+        }
+        uint64_t oldest = inFlight.front().value;
+        vk::SemaphoreWaitInfo waitInfo{ {}, 1, &timeline.get(), &oldest };
+        auto result = device.waitSemaphores(waitInfo, UINT64_MAX);
+        (void)result;
+        retire(device.getSemaphoreCounterValue(timeline.get()));
+    }
+
+    pending.usesRing = true;
+    buffer = staging.buffer.get();
+    return stagingMapped + offset;
+}
+
+bool TransferManager::allocateRing(vk::DeviceSize size, vk::DeviceSize& offset) {
+    bool live = pending.usesRing;
+    for (const auto& batch : inFlight) {
+        live = live || batch.usesRing;
+    }
+    if (!live) {
+        ringHead = ringTail = 0;
+    }
+
+    // Live bytes are [tail, head), wrapping past the end when head < tail
+    vk::DeviceSize aligned = alignUp(ringHead, STAGING_ALIGNMENT);
+    if (ringHead > ringTail || !live) {
+        if (aligned + size <= stagingSize) {
+            offset = aligned;
+            ringHead = aligned + size;
+            return true;
+        }
+        if (size <= ringTail) {
+            offset = 0;
+            ringHead = size;
+            return true;
+        }
+        return false;
+    }
+    if (ringHead < ringTail && aligned + size <= ringTail) {
+        offset = aligned;
+        ringHead = aligned + size;
+        return true;
+    }
+    return false;
+}
+
+void TransferManager::submit() {
+    ENGINE_PROFILE_ZONE("Transfer Submit");
+    pending.commands.end();
+    pending.value = nextValue++;
+    pending.ringEnd = ringHead;
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &pending.value;
+
+    vk::SubmitInfo submitInfo{};
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &pending.commands;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &timeline.get();
+    queue.submit(submitInfo, nullptr);
+
+    lastSubmitted = pending.value;
+    frameWaitValue = pending.value;
+    frameBufferAcquires.insert(frameBufferAcquires.end(), pending.bufferAcquires.begin(), pending.bufferAcquires.end());
+    frameImageAcquires.insert(frameImageAcquires.end(), pending.imageAcquires.begin(), pending.imageAcquires.end());
+    pending.bufferAcquires.clear();
+    pending.imageAcquires.clear();
+
+    inFlight.push_back(std::move(pending));
+    pending = Batch{};
+}
+
+void TransferManager::retire(uint64_t completed) {
+    while (!inFlight.empty() && inFlight.front().value <= completed) {
+        Batch batch = std::move(inFlight.front());
+        inFlight.pop_front();
+
+        if (batch.usesRing) {
+            ringTail = batch.ringEnd;
+        }
+        freeCommandBuffers.push_back(batch.commands);
+        for (auto& callback : batch.callbacks) {
+            callback();
+        }
+        if (batch.promise) {
+            batch.promise->set_value();
+        }
+    }
+
+    while (!deferred.empty() && deferred.front().frame + framesInFlight <= frameCounter &&
+           deferred.front().value <= completed) {
+        deferred.pop_front();
+    }
+}
+
+} // namespace engine::renderer
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include "ResourceManager.hpp"
+
+namespace engine::renderer {
+
+// Uploads without stalling the frame. Data is copied into a persistently mapped staging
+// ring and the copies are batched into one command buffer, submitted on the transfer
+// queue (the graphics queue when the device has no separate one) at the next frame start.
+// Each batch signals a timeline semaphore value, which is the ticket returned for its
+// uploads; callbacks and futures fire once the frame loop sees the value reached.
+//
+// Anything uploaded before beginFrame is visible to that frame's commands: the frame
+// acquires ownership of the destinations and waits on the timeline on the GPU only.
+// Used from the main thread.
+class TransferManager {
+public:
+    using Ticket = uint64_t;
+
+    TransferManager(vk::Device device, ResourceManager& resourceManager, vk::Queue queue, uint32_t queueFamily,
+                    uint32_t graphicsFamily, uint32_t framesInFlight, vk::DeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+    ~TransferManager();
+
+    Ticket uploadBuffer(vk::Buffer dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size);
+    // Whole mip level of a color image, tightly packed. Previous contents are discarded and
+    // the image ends up in finalLayout, which should be the layout the render graph expects.
+    Ticket uploadImage(vk::Image dst, vk::Extent3D extent, uint32_t mipLevel, const void* data, vk::DeviceSize size,
+                       vk::ImageLayout finalLayout);
+
+    bool isComplete(Ticket ticket) const;
+    // Runs on the main thread from beginFrame once the upload has landed
+    void onComplete(Ticket ticket, std::function<void()> callback);
+    std::shared_future<void> getFuture(Ticket ticket);
+    // Blocks until the upload has landed (tools and startup only)
+    void wait(Ticket ticket);
+
+    // Keeps a resource (moved in) alive until the frames in flight and the uploads
+    // recorded so far no longer use it
+    template <typename T>
+    void destroyLater(T resource) {
+        deferred.push_back({ frameCounter, pending.commands ? nextValue : lastSubmitted,
+                             std::make_unique<Holder<T>>(std::move(resource)) });
+    }
+
+    // Frame start, after the frame's fence wait and with cmd recording: submits the
+    // pending batch, retires finished ones and records the ownership acquires. Returns
+    // the timeline value the frame's submit must wait for, or 0.
+    uint64_t beginFrame(vk::CommandBuffer cmd);
+    vk::Semaphore getTimeline() const { return timeline.get(); }
+
+    // Stages the frame's timeline wait must use. The acquire barriers start from these
+    // stages, so their layout transitions are ordered after the semaphore wait.
+    static constexpr vk::PipelineStageFlags WAIT_STAGES = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer;
+
+    static constexpr vk::DeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+
+private:
+    struct HolderBase {
+        virtual ~HolderBase() = default;
+    };
+    template <typename T>
+    struct Holder : HolderBase {
+        explicit Holder(T&& value) : value(std::move(value)) {}
+        T value;
+    };
+
+    struct Batch {
+        vk::CommandBuffer commands;
+        uint64_t value = 0;
+        bool usesRing = false;
+        vk::DeviceSize ringEnd = 0;
+        std::vector<vk::BufferMemoryBarrier> bufferAcquires;
+        std::vector<vk::ImageMemoryBarrier> imageAcquires;
+        std::vector<ResourceManager::Buffer> oversizedStaging;
+        std::vector<std::function<void()>> callbacks;
+        std::unique_ptr<std::promise<void>> promise;
+        std::shared_future<void> future;
+    };
+
+    struct Deferred {
+        uint64_t frame;
+        uint64_t value;
+        std::unique_ptr<HolderBase> resource;
+    };
+
+    vk::Device device;
+    ResourceManager& resourceManager;
+    vk::Queue queue;
+    uint32_t queueFamily;
+    uint32_t graphicsFamily;
+    uint32_t framesInFlight;
+
+    vk::UniqueSemaphore timeline;
+    vk::UniqueCommandPool commandPool;
+    std::vector<vk::CommandBuffer> freeCommandBuffers;
+
+    ResourceManager::Buffer staging;
+    uint8_t* stagingMapped = nullptr;
+    vk::DeviceSize stagingSize;
+    vk::DeviceSize ringHead = 0; // Next free byte
+    vk::DeviceSize ringTail = 0; // Oldest byte still in use
+
+    Batch pending;               // Recording; signals nextValue when submitted
+    std::deque<Batch> inFlight;  // Submitted, oldest first
+    uint64_t nextValue = 1;
+    uint64_t lastSubmitted = 0;
+
+    // Ownership acquires of batches submitted since the last beginFrame
+    std::vector<vk::BufferMemoryBarrier> frameBufferAcquires;
+    std::vector<vk::ImageMemoryBarrier> frameImageAcquires;
+    uint64_t frameWaitValue = 0;
+
+    std::deque<Deferred> deferred;
+    uint64_t frameCounter = 0;
+
+    bool ownershipTransfer() const { return queueFamily != graphicsFamily; }
+    vk::CommandBuffer pendingCommands();
+    // Mapped staging space for size bytes; waits for older batches when the ring is full
+    uint8_t* stage(vk::DeviceSize size, vk::Buffer& buffer, vk::DeviceSize& offset);
+    bool allocateRing(vk::DeviceSize size, vk::DeviceSize& offset);
+    void submit();
+    void retire(uint64_t completed);
+};
+
+} // namespace engine::renderer